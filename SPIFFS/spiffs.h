@@ -68,6 +68,14 @@ extern "C" {
 
 #define SPIFFS_ERR_TEST                 -10100
 #define SPIFFS_SFU_ERR_ERASE_SZ			-10060
+#define SPIFFS_SFU_ERR_RECORD_FIELDS	-10061
+#define SPIFFS_SFU_ERR_BUSY				-10062
+#define SPIFFS_SFU_ERR_NO_FLAGS			-10063
+#define SPIFFS_SFU_ERR_FEE				-10064
+#define SPIFFS_SFU_ERR_CRC				-10065
+#define SPIFFS_SFU_ERR_ID_MISMATCH		-10066
+#define SPIFFS_SFU_ERR_DIRTY_FREE		-10067
+#define SPIFFS_SFU_ERR_FLASH			-10068
 
 
 // spiffs file descriptor index type. must be signed
@@ -140,6 +148,9 @@ typedef enum {
 /* file system listener callback function */
 typedef void (*spiffs_file_callback)(struct spiffs_t *fs, spiffs_fileop_type op, spiffs_obj_id obj_id, spiffs_page_ix pix);
 
+/* SFUSat: gc erase age callback. Gets the age spiffs worked out from the block's erase count, returns the one to score with */
+typedef spiffs_obj_id (*spiffs_gc_erase_age)(struct spiffs_t *fs, spiffs_block_ix bix, spiffs_obj_id age);
+
 #ifndef SPIFFS_DBG
 #define SPIFFS_DBG(...) \
     printf(__VA_ARGS__)
@@ -228,6 +239,8 @@ typedef struct {
   // an integer offset added to each file handle
   u16_t fh_ix_offset;
 #endif
+  // SFUSat: erase age for gc candidates, NULL to use the block erase counts. See obc_fs_wear.h
+  spiffs_gc_erase_age gc_erase_age_f;
 } spiffs_config;
 
 typedef struct spiffs_t {
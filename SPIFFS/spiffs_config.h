@@ -191,7 +191,7 @@ typedef uint8_t u8_t;
 // not on mount point. If not, SPIFFS_format must be called prior to mounting
 // again.
 #ifndef SPIFFS_USE_MAGIC
-#define SPIFFS_USE_MAGIC                (0)
+#define SPIFFS_USE_MAGIC                (1) // SFUSat: partitions that don't match their layout get formatted at boot, see obc_spiffs.h
 #endif
 
 #if SPIFFS_USE_MAGIC
@@ -201,7 +201,7 @@ typedef uint8_t u8_t;
 // be accepted for mounting with a configuration defining the filesystem as 2
 // megabytes.
 #ifndef SPIFFS_USE_MAGIC_LENGTH
-#define SPIFFS_USE_MAGIC_LENGTH         (0)
+#define SPIFFS_USE_MAGIC_LENGTH         (1)
 #endif
 #endif
 
@@ -222,7 +222,7 @@ typedef uint8_t u8_t;
 // on the target. This will reduce calculations, flash and memory accesses.
 // Parts of configuration must be defined below instead of at time of mount.
 #ifndef SPIFFS_SINGLETON
-#define SPIFFS_SINGLETON 1
+#define SPIFFS_SINGLETON 0 // SFUSat: logs and state partitions, geometry is in obc_spiffs.h
 #endif
 
 #if SPIFFS_SINGLETON
@@ -262,7 +262,7 @@ typedef uint8_t u8_t;
 // NB: This adds config field fh_ix_offset in the configuration struct when
 // mounting, which must be defined.
 #ifndef SPIFFS_FILEHDL_OFFSET
-#define SPIFFS_FILEHDL_OFFSET                 0
+#define SPIFFS_FILEHDL_OFFSET                 1 // SFUSat: a state fd passed to the logs partition (or v/v) is a bad descriptor
 #endif
 
 // Enable this to compile a read only version of spiffs.
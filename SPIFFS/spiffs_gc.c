@@ -308,6 +308,9 @@ s32_t spiffs_gc_find_candidate(
       } else {
         erase_age = SPIFFS_OBJ_ID_FREE - (erase_count - fs->max_erase_count);
       }
+      if (fs->cfg.gc_erase_age_f) { // SFUSat: our own erase counts, see obc_fs_wear.h
+        erase_age = fs->cfg.gc_erase_age_f(fs, cur_block, erase_age);
+      }
 
       s32_t score =
           deleted_pages_in_block * SPIFFS_GC_HEUR_W_DELET +
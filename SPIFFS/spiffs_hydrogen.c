@@ -633,6 +633,15 @@ s32_t SPIFFS_lseek(spiffs *fs, spiffs_file fh, s32_t offs, int whence) {
 
   spiffs_span_ix data_spix = (offs > 0 ? (offs-1) : 0) / SPIFFS_DATA_PAGE_SIZE(fs);
   spiffs_span_ix objix_spix = SPIFFS_OBJ_IX_ENTRY_SPAN_IX(fs, data_spix);
+#if SPIFFS_IX_MAP
+  // SFUSat: a read from an index mapped page doesn't need the cursor, don't scan the lookup pages for its index page.
+  // The cursor stays where it was, which is still a valid pair for writes and unmapped reads
+  spiffs_span_ix read_spix = offs / SPIFFS_DATA_PAGE_SIZE(fs);
+  if (fd->ix_map && read_spix >= fd->ix_map->start_spix && read_spix <= fd->ix_map->end_spix
+      && fd->ix_map->map_buf[read_spix - fd->ix_map->start_spix]) {
+    objix_spix = fd->cursor_objix_spix;
+  }
+#endif
   if (fd->cursor_objix_spix != objix_spix) {
     spiffs_page_ix pix;
     res = spiffs_obj_lu_find_id_and_span(
@@ -1330,9 +1339,9 @@ s32_t SPIFFS_ix_remap(spiffs *fs, spiffs_file fh, u32_t offset) {
     const s32_t vec_len = map->end_spix - map->start_spix + 1; // spix range includes last
     map->start_spix += spix_diff;
     map->end_spix += spix_diff;
-    if (spix_diff >= vec_len) {
+    if (spix_diff >= vec_len || -spix_diff >= vec_len) { // SFUSat: was only forward, a jump back past the map overran map_buf
       // moving beyond range
-      memset(&map->map_buf, 0, vec_len * sizeof(spiffs_page_ix));
+      memset(map->map_buf, 0, vec_len * sizeof(spiffs_page_ix)); // SFUSat: was &map->map_buf, which cleared the map struct
       // populate_ix_map is inclusive
       res = spiffs_populate_ix_map(fs, fd, 0, vec_len-1);
       SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
@@ -714,7 +714,7 @@ s32_t spiffs_populate_ix_map(spiffs *fs, spiffs_fd *fd, u32_t vec_entry_start, u
   spiffs_ix_map *map = fd->ix_map;
   spiffs_ix_map_populate_state state;
   vec_entry_start = MIN((u32_t)(map->end_spix - map->start_spix), vec_entry_start);
-  vec_entry_end = MAX((u32_t)(map->end_spix - map->start_spix), vec_entry_end);
+  vec_entry_end = MIN((u32_t)(map->end_spix - map->start_spix), vec_entry_end); // SFUSat: was MAX, which visits an index page past the map
   if (vec_entry_start > vec_entry_end) {
     return SPIFFS_ERR_IX_MAP_BAD_RANGE;
   }
@@ -724,10 +724,12 @@ s32_t spiffs_populate_ix_map(spiffs *fs, spiffs_fd *fd, u32_t vec_entry_start, u
       state.map_objix_end_spix - state.map_objix_start_spix + 1;
   state.fd = fd;
 
+  // SFUSat: start at the lookup cursor like spiffs_obj_lu_find_id_and_span does, was the object header's block.
+  // The visitor goes round every block either way, the cursor is just usually closer to the index pages
   res = spiffs_obj_lu_find_entry_visitor(
       fs,
-      SPIFFS_BLOCK_FOR_PAGE(fs, fd->objix_hdr_pix),
-      SPIFFS_OBJ_LOOKUP_ENTRY_FOR_PAGE(fs, fd->objix_hdr_pix),
+      fs->cursor_block_ix,
+      fs->cursor_obj_lu_entry,
       SPIFFS_VIS_CHECK_ID,
       fd->obj_id | SPIFFS_OBJ_ID_IX_FLAG,
       spiffs_populate_ix_map_v,
@@ -0,0 +1,125 @@
+/*
+ * fee_model.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "ti_fee.h"
+#include "fee_model.h"
+
+fee_stats_t fee_stats;
+
+typedef struct fee_block {
+	uint16_t size;					/* 0 if not configured */
+	bool valid;
+	bool inconsistent;
+	uint8_t data[FEE_MODEL_BLOCK_MAX];
+} fee_block_t;
+
+static fee_block_t blocks[FEE_MODEL_BLOCKS];
+static TI_FeeModuleStatusType status = UNINIT;
+static TI_FeeJobResultType job = JOB_OK;
+static uint32_t busy;
+static uint32_t fail_writes;
+
+void fee_model_erase() {
+	memset(blocks, 0, sizeof(blocks));
+	memset(&fee_stats, 0, sizeof(fee_stats));
+	status = UNINIT;
+	fail_writes = 0;
+}
+
+void fee_model_config(uint16_t block, uint16_t size) {
+	if (block == 0 || block >= FEE_MODEL_BLOCKS || size > FEE_MODEL_BLOCK_MAX) {
+		fprintf(stderr, "fee: can't configure block %u of %u bytes\n", block, size);
+		return;
+	}
+	blocks[block].size = size;
+}
+
+void fee_model_fail_writes(uint32_t n) {
+	fail_writes = n;
+}
+
+void fee_model_corrupt(uint16_t block) {
+	if (block < FEE_MODEL_BLOCKS) {
+		blocks[block].inconsistent = true;
+	}
+}
+
+void TI_Fee_Init(void) {
+	fee_stats.inits++;
+	status = BUSY_INTERNAL;
+	busy = FEE_MODEL_BUSY_CALLS;
+	job = JOB_OK;
+}
+
+void TI_Fee_MainFunction(void) {
+	fee_stats.main_calls++;
+	if (busy > 0 && --busy == 0) {
+		status = IDLE;
+	}
+}
+
+TI_FeeModuleStatusType TI_Fee_GetStatus(uint8 u8EEPIndex) {
+	return status;
+}
+
+TI_FeeJobResultType TI_Fee_GetJobResult(uint8 u8EEPIndex) {
+	return job;
+}
+
+Std_ReturnType TI_Fee_WriteSync(uint16 BlockNumber, uint8 *DataBufferPtr) {
+	fee_block_t *b;
+
+	if (status != IDLE || BlockNumber == 0 || BlockNumber >= FEE_MODEL_BLOCKS || blocks[BlockNumber].size == 0) {
+		job = JOB_FAILED;
+		return E_NOT_OK;
+	}
+	b = &blocks[BlockNumber];
+	fee_stats.writes++;
+	if (fail_writes > 0) {
+		fail_writes--;
+		job = JOB_FAILED;
+		return E_NOT_OK;
+	}
+	memcpy(b->data, DataBufferPtr, b->size);
+	b->valid = true;
+	b->inconsistent = false;
+	fee_stats.write_bytes += b->size;
+	status = BUSY_INTERNAL;
+	busy = FEE_MODEL_BUSY_CALLS;
+	job = JOB_OK;
+	return E_OK;
+}
+
+Std_ReturnType TI_Fee_ReadSync(uint16 BlockNumber, uint16 BlockOffset, uint8 *DataBufferPtr, uint16 Length) {
+	fee_block_t *b;
+
+	if (status == UNINIT || BlockNumber == 0 || BlockNumber >= FEE_MODEL_BLOCKS
+			|| BlockOffset + Length > blocks[BlockNumber].size) {
+		job = JOB_FAILED;
+		return E_NOT_OK;
+	}
+	b = &blocks[BlockNumber];
+	fee_stats.reads++;
+	if (!b->valid || b->inconsistent) {
+		job = b->valid ? BLOCK_INCONSISTENT : BLOCK_INVALID;
+		return E_NOT_OK;
+	}
+	memcpy(DataBufferPtr, &b->data[BlockOffset], Length);
+	job = JOB_OK;
+	return E_OK;
+}
+
+Std_ReturnType TI_Fee_InvalidateBlock(uint16 BlockNumber) {
+	if (BlockNumber == 0 || BlockNumber >= FEE_MODEL_BLOCKS) {
+		return E_NOT_OK;
+	}
+	blocks[BlockNumber].valid = false;
+	job = JOB_OK;
+	return E_OK;
+}
@@ -0,0 +1,41 @@
+/*
+ * fee_model.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      RAM stand-in for the TI FEE driver (include/ti_fee.h) for host builds.
+ *
+ *      Blocks have a configured size like in HALCoGen and keep their contents across TI_Fee_Init, so a test can
+ *      "reset" and load again. A block that was never written reads BLOCK_INVALID. Failures can be injected: a write
+ *      cut short leaves the previous value, the way FEE's copy scheme does, and a block can be made inconsistent.
+ *      Init and each write leave the driver busy for a few TI_Fee_MainFunction calls, like the background work
+ *      on target.
+ */
+
+#ifndef HOST_SIM_FEE_MODEL_H_
+#define HOST_SIM_FEE_MODEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FEE_MODEL_BLOCKS		32
+#define FEE_MODEL_BLOCK_MAX		64
+#define FEE_MODEL_BUSY_CALLS	3		/* TI_Fee_MainFunction calls before the driver is idle again */
+
+typedef struct fee_stats {
+	uint32_t inits;
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t write_bytes;
+	uint32_t main_calls;
+} fee_stats_t;
+
+extern fee_stats_t fee_stats;
+
+void fee_model_erase();								/* blank FEE, no blocks configured */
+void fee_model_config(uint16_t block, uint16_t size);
+void fee_model_fail_writes(uint32_t n);				/* the next n writes fail and leave the old data */
+void fee_model_corrupt(uint16_t block);				/* reads of block fail until it's written again */
+
+#endif /* HOST_SIM_FEE_MODEL_H_ */
@@ -0,0 +1,113 @@
+/*
+ * flag_fee_test.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      The FEE flag backend (obc_flag_fee.c) against the FEE stand-in (fee_model.c).
+ *
+ *      Goes through what the OBC does with FEE flags over a few resets: first boot on a blank FEE, commits, a write
+ *      that fails, a block that reads back inconsistent, and a table that loses its SPIFFS-only flags.
+ *
+ *      usage: flag_fee_test		(exits non-zero on the first failure)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "sys_common.h"
+#include "obc_flags.h"
+#include "obc_flag_fee.h"
+#include "ti_fee.h"
+#include "fee_model.h"
+#include "spiffs.h"
+
+/* normally in obc_flags.c, which needs the rest of the firmware */
+flag_memory_table_t flag_memory_table;
+const uint8_t flagSize[NUM_FLAGS] = {FLAG_TABLE(FLAG_SIZE_CHECK)};
+const uint32_t flagOffset[NUM_FLAGS] = {FLAG_TABLE(FLAG_OFFSET_INIT)};
+
+static uint32_t failures;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; } } while (0)
+
+static void config_blocks() {
+	uint8_t i;
+
+	for (i = 0; i < NUM_FLAGS; i++) {
+		if (FLAG_FEE_MASK & ((uint32_t)1 << i)) {
+			fee_model_config(FLAG_FEE_BLOCK(i), flagSize[i]);
+		}
+	}
+}
+
+/* what flagInit() does, with a known default instead of initFlagTable() */
+static uint32_t boot(flag_memory_table_t *t) {
+	memset(t, 0xA5, sizeof(*t));
+	flag_fee_init();
+	return flag_fee_load(t);
+}
+
+int main() {
+	flag_memory_table_t t;
+	flag_memory_table_t saved;
+	uint32_t found;
+
+	printf("FEE flags: mask %08x, table %u bytes\n", FLAG_FEE_MASK, (unsigned)FLAG_TABLE_SIZE);
+	CHECK(FLAG_FEE_MASK == (RESET_FLAG_BIT | PREFIX_FLAG_BIT));
+
+	fee_model_erase();
+	config_blocks();
+
+	/* blank FEE: nothing found, table untouched */
+	found = boot(&t);
+	CHECK(found == 0);
+	CHECK(t.PREFIX_FLAG.all[0] == 0xA5);
+	CHECK(fee_stats.main_calls >= FEE_MODEL_BUSY_CALLS);
+
+	/* commit only writes FEE flags */
+	t.PREFIX_FLAG.payload.flag = 'b';
+	t.PREFIX_FLAG.payload.timestamp = 1000;
+	t.RESET_FLAG.payload.flag = 'F';
+	CHECK(flag_fee_commit(&t, RESET_FLAG_BIT | PREFIX_FLAG_BIT | GEN_TELEM_BIT) == 0);
+	CHECK(fee_stats.writes == 2);
+	CHECK(fee_stats.write_bytes == flagSize[RESET_FLAG] + flagSize[PREFIX_FLAG]);
+	saved = t;
+
+	/* reset: both come back, GEN_TELEM doesn't */
+	found = boot(&t);
+	CHECK(found == (RESET_FLAG_BIT | PREFIX_FLAG_BIT));
+	CHECK(memcmp(&t.PREFIX_FLAG, &saved.PREFIX_FLAG, sizeof(t.PREFIX_FLAG)) == 0);
+	CHECK(memcmp(&t.RESET_FLAG, &saved.RESET_FLAG, sizeof(t.RESET_FLAG)) == 0);
+	CHECK(t.GEN_TELEM.all[0] == 0xA5);
+
+	/* failed write: error returned, the old value is what loads */
+	t.PREFIX_FLAG.payload.flag = 'c';
+	fee_model_fail_writes(1);
+	CHECK(flag_fee_commit(&t, PREFIX_FLAG_BIT) == SPIFFS_SFU_ERR_FEE);
+	CHECK(flag_fee_stats.write_fails == 1);
+	found = boot(&t);
+	CHECK(found == (RESET_FLAG_BIT | PREFIX_FLAG_BIT));
+	CHECK(t.PREFIX_FLAG.payload.flag == 'b');
+
+	/* retry goes through */
+	t.PREFIX_FLAG.payload.flag = 'c';
+	CHECK(flag_fee_commit(&t, PREFIX_FLAG_BIT) == 0);
+	found = boot(&t);
+	CHECK(t.PREFIX_FLAG.payload.flag == 'c');
+
+	/* inconsistent block: that flag isn't reported, the other one still is */
+	fee_model_corrupt(FLAG_FEE_BLOCK(RESET_FLAG));
+	found = boot(&t);
+	CHECK(found == PREFIX_FLAG_BIT);
+	CHECK(t.RESET_FLAG.all[0] == 0xA5);
+	CHECK(flag_fee_stats.last_result == BLOCK_INCONSISTENT);
+
+	printf("fee: %u inits, %u reads, %u writes (%u bytes), %u main calls\n", fee_stats.inits, fee_stats.reads,
+			fee_stats.writes, fee_stats.write_bytes, fee_stats.main_calls);
+	printf("flag_fee: %u reads (%u failed), %u writes (%u failed)\n", flag_fee_stats.reads, flag_fee_stats.read_fails,
+			flag_fee_stats.writes, flag_fee_stats.write_fails);
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * flash_model.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "flash_mibspi.h"
+#include "flash_model.h"
+#include "nor_model.h"
+#include "rtos_model.h"
+
+#define STATUS_WIP	0x01
+
+flash_timing_t flash_timing = { 5000000, 2000, FLASH_T_PP_TYP_US, FLASH_T_SE_TYP_US };
+flash_model_stats_t flash_model_stats;
+flash_wait_stats_t flash_wait_stats;
+
+static uint64_t busy_until_ns;	/* the chip's Write In Progress bit is set until then */
+
+/* Private functions */
+static void transfer(uint32_t bytes);
+static bool accepts_command();
+static void stream(uint32_t bytes);
+static void page_program(uint32_t address, uint32_t size, const uint8_t *data);
+
+/* flash_erase_chip
+ * 	- the chip is busy for the driver's FLASH_T_CE_US, it waits the same way
+ */
+void flash_erase_chip() {
+	bool enabled;
+
+	transfer(1);	/* Write Enable */
+	enabled = accepts_command();
+	transfer(1);	/* Chip Erase */
+	if (enabled && accepts_command()) {
+		nor_erase(0, NOR_SIZE);
+		busy_until_ns = sim_time_ns + (uint64_t)FLASH_T_CE_US * 1000;
+		flash_model_stats.erase_busy_ns += (uint64_t)FLASH_T_CE_US * 1000;
+	}
+	flash_wait_done(FLASH_T_CE_US);
+}
+
+void flash_erase_sector(uint32_t address) {
+	bool enabled;
+
+	transfer(1);	/* Write Enable */
+	enabled = accepts_command();
+	transfer(4);	/* Sector Erase + address */
+	if (!enabled || !accepts_command()) {
+		return;
+	}
+	nor_erase(address & ~(NOR_SECTOR_SIZE - 1), NOR_SECTOR_SIZE);
+	busy_until_ns = sim_time_ns + (uint64_t)flash_timing.t_se_us * 1000;
+	flash_model_stats.erase_busy_ns += (uint64_t)flash_timing.t_se_us * 1000;
+}
+
+uint16_t flash_status() {
+	transfer(2);	/* Read Status + the register */
+	flash_model_stats.status_polls++;
+	return (sim_time_ns < busy_until_ns) ? STATUS_WIP : 0;
+}
+
+/* flash_wait_done
+ * 	- the driver's: sleeps the typical time, then polls every typ_us / FLASH_WAIT_POLLS. Shorter than a tick, polls
+ * 	  back to back (the driver yields in between, to tasks the bench doesn't have)
+ */
+void flash_wait_done(uint32_t typ_us) {
+	TickType_t first = pdMS_TO_TICKS(typ_us / 1000);
+	TickType_t delay = pdMS_TO_TICKS(typ_us / 1000 / FLASH_WAIT_POLLS);
+	uint64_t start = sim_time_ns;
+	uint64_t sleep_start;
+
+	flash_wait_stats.waits++;
+	if (first > 0) {
+		sleep_start = sim_time_ns;
+		vTaskDelay(first);
+		flash_wait_stats.sleeps++;
+		flash_wait_stats.slept_us += (sim_time_ns - sleep_start) / 1000;
+	}
+	while (1) {
+		flash_wait_stats.polls++;
+		if ((flash_status() & STATUS_WIP) == 0) {
+			break;
+		}
+		if (first == 0) {
+			continue;
+		}
+		sleep_start = sim_time_ns;
+		vTaskDelay((delay > 0) ? delay : 1);
+		flash_wait_stats.sleeps++;
+		flash_wait_stats.slept_us += (sim_time_ns - sleep_start) / 1000;
+	}
+	flash_wait_stats.wait_us += (sim_time_ns - start) / 1000;
+}
+
+/* flash_write_arbitrary
+ * 	- a program per page the data touches, waiting for each one but the last
+ * 	- the model's transfers always finish, so it never fails
+ */
+bool flash_write_arbitrary(uint32_t address, uint32_t size, uint8_t *src) {
+	uint32_t n;
+
+	while (size > 0) {
+		n = FLASH_PAGE_SIZE - (address % FLASH_PAGE_SIZE);
+		n = (n < size) ? n : size;
+		page_program(address, n, src);
+		address += n;
+		src += n;
+		size -= n;
+		if (size > 0) {
+			flash_wait_done(FLASH_T_PP_US);
+		}
+	}
+	return true;
+}
+
+/* flash_read_arbitrary
+ * 	- one Read for all of it
+ */
+bool flash_read_arbitrary(uint32_t address, uint32_t size, uint8_t *dest) {
+	if (size == 0) {
+		return true;
+	}
+	stream(4 + size);	/* Read + address + data */
+	if (!accepts_command()) {
+		memset(dest, 0xFF, size); /* nothing drives the data line, but the transfer finished */
+		return true;
+	}
+	nor_read(address, size, dest);
+	return true;
+}
+
+static void transfer(uint32_t bytes) {
+	uint64_t ns = flash_timing.tg_overhead_ns + (uint64_t)bytes * 8 * 1000000000 / flash_timing.spi_hz;
+
+	flash_model_stats.transfers++;
+	flash_model_stats.bus_ns += ns;
+	sim_advance_ns(ns);
+}
+
+static bool accepts_command() {
+	if (sim_time_ns < busy_until_ns) {
+		if (flash_model_stats.ignored++ == 0) {
+			fprintf(stderr, "flash_model: command while the chip is busy, ignored\n");
+		}
+		return false;
+	}
+	return true;
+}
+
+/* stream
+ * 	- one command of bytes over the stream transfer group, FLASH_STREAM_LEN at a time with CS held in between
+ */
+static void stream(uint32_t bytes) {
+	uint32_t n;
+
+	while (bytes > 0) {
+		n = (bytes < FLASH_STREAM_LEN) ? bytes : FLASH_STREAM_LEN;
+		transfer(n);
+		flash_model_stats.blocked_ns += (uint64_t)n * 8 * 1000000000 / flash_timing.spi_hz;
+		bytes -= n;
+	}
+}
+
+static void page_program(uint32_t address, uint32_t size, const uint8_t *data) {
+	bool enabled;
+
+	transfer(1);		/* Write Enable */
+	enabled = accepts_command();
+	stream(4 + size);	/* Page Program + address + data */
+	if (!enabled || !accepts_command()) {
+		return;
+	}
+	nor_program(address, size, data);
+	busy_until_ns = sim_time_ns + (uint64_t)flash_timing.t_pp_us * 1000;
+	flash_model_stats.program_busy_ns += (uint64_t)flash_timing.t_pp_us * 1000;
+}
@@ -0,0 +1,54 @@
+/*
+ * flash_model.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Host stand-in for the flash driver (orcasat/flash_mibspi.c) on top of nor_model.c, with the time it takes.
+ *
+ *      The calls do what the driver does, transaction for transaction: flash_write_arbitrary sends a Write Enable and
+ *      a Page Program (command, address, data) per page the data touches, in FLASH_STREAM_LEN byte transfer groups, and
+ *      polls the status register until each but the last is programmed. flash_read_arbitrary is one Read (command,
+ *      address, data) in FLASH_STREAM_LEN byte transfer groups. The driver blocks for those instead of spinning, so
+ *      their bytes on the wire are CPU time the other tasks get (blocked_ns). Their tg_overhead_ns stays CPU time,
+ *      it's about what the DMA setup, interrupt and wake up cost. Every transfer group costs its bytes at
+ *      the SPI clock plus tg_overhead_ns for setting it up and waiting for it. The chip is busy for t_pp_us after a
+ *      Page Program and t_se_us after a Sector Erase, and like the real one it ignores commands other than Read Status
+ *      until it's done (counted in ignored, the data doesn't change).
+ *
+ *      The defaults are the IS25LP016D's typical program and erase times (datasheet tPP, tSE), and the MibSPI setup
+ *      in HALCoGen: VCLK1 30 MHz / 6 = 5 MHz. tg_overhead_ns is an estimate of the CPU side (mibspiSetData, trigger,
+ *      TG complete notification, mibspiGetData), not a measurement. FLASH_T_*_MAX are the datasheet's worst case.
+ */
+
+#ifndef HOST_SIM_FLASH_MODEL_H_
+#define HOST_SIM_FLASH_MODEL_H_
+
+#include "sys_common.h"
+
+#define FLASH_T_PP_TYP_US		200
+#define FLASH_T_PP_MAX_US		800
+#define FLASH_T_SE_TYP_US		70000
+#define FLASH_T_SE_MAX_US		300000
+
+typedef struct flash_timing {
+	uint32_t spi_hz;
+	uint32_t tg_overhead_ns;
+	uint32_t t_pp_us;
+	uint32_t t_se_us;
+} flash_timing_t;
+
+typedef struct flash_model_stats {
+	uint32_t transfers;			/* transfer groups */
+	uint64_t bus_ns;			/* time spent in them */
+	uint64_t blocked_ns;		/* of which on the wire in TG5, where the driver blocks instead of spinning */
+	uint32_t status_polls;
+	uint32_t ignored;			/* commands sent while the chip was busy */
+	uint64_t program_busy_ns;	/* chip busy time, programming and erasing */
+	uint64_t erase_busy_ns;
+} flash_model_stats_t;
+
+extern flash_timing_t flash_timing;
+extern flash_model_stats_t flash_model_stats;
+
+#endif /* HOST_SIM_FLASH_MODEL_H_ */
@@ -0,0 +1,539 @@
+/*
+ * fs_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      A day of telemetry through the real filesystem code, on the timed flash model.
+ *
+ *      Links the firmware's filesystem (orcasat/filesystem, the SPIFFS HAL in obc_spiffs.c included) against
+ *      flash_model.c, the flash driver's transactions on the RAM model of the IS25LP016D with its program and erase
+ *      times, and rtos_model.c, where time only passes while the flash or the harness says so. Then it plays the tasks:
+ *      	- stdtelem's records at its periods (RAMOCCUR 12 s, BMS, OBC current and temperatures 10 s) and events from
+ *      	  the logging task, posted to the filesystem service the way sfu_write_fields does
+ *      	- a flag change every so often (FLAG_SET), which the service commits to the state partition
+ *      	- the lifecycle task: the service drains its queues whenever there's something in them, and flushes stale
+ *      	  pages every FSYS_FLUSH_INTERVAL (plus rotation without FSYS_CIRCULAR_LOGS)
+ *      	- the GC task, whenever nothing else is running, at its FS_GC_STEP_INTERVAL/FS_GC_IDLE_INTERVAL pace
+ *      There's one CPU and tasks don't preempt each other, so a record that comes due while GC holds the mutex waits
+ *      for it. That's what the target does too, give or take the priorities.
+ *
+ *      With FSYS_CIRCULAR_LOGS the logs are reopened at the end like after a reset, to check that each one finds
+ *      its head again from the header and the data pages.
+ *
+ *      Latency is from when a record was due to the end of the service batch that handled it (on flash or staged in
+ *      the appender). Write amplification is bytes programmed on the chip per byte of record the appenders were
+ *      given.
+ *
+ *      usage: fs_bench [-t hours] [-e events/hour] [-f flag changes/hour] [-s erases] [-g] [-w] [-v]
+ *      	-s	start with the lower half of the logs partition this many erases more worn (fs_wear_counts), like a
+ *      		chip that had a different layout before its last format
+ *      	-g	GC erase ages from SPIFFS's own block counts instead of fs_wear's
+ *      	-w	the datasheet's worst case program and erase times instead of typical
+ *      	-v	print the firmware's serial output
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_task.h"
+#include "rtos_queue.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+#include "obc_spiffs.h"
+#include "obc_fs_structure.h"
+#include "obc_fs_service.h"
+#include "obc_fs_appender.h"
+#include "obc_fs_record.h"
+#include "obc_fs_gc.h"
+#include "obc_fs_check.h"
+#include "obc_fs_wear.h"
+#include "obc_flags.h"
+#include "obc_rtc.h"
+#include "nor_model.h"
+#include "flash_mibspi.h"
+#include "flash_model.h"
+#include "rtos_model.h"
+#include "fw_stubs.h"
+
+#define NS_PER_MS		1000000ULL
+#define NS_PER_S		1000000000ULL
+#define TICKS_NS(t)		((uint64_t)(t) * portTICK_PERIOD_MS * NS_PER_MS)
+#define DUE_QUEUE_SIZE	256		/* records posted and not handled yet, more than FS_SERVICE_QUEUE_LENGTH */
+
+typedef struct producer {
+	const char *name;
+	char suffix;
+	log_record_type_t type;
+	uint8_t num_fields;
+	uint32_t period_ms;			/* 0 to turn it off */
+	int32_t base[3];			/* fields wander around these */
+	int32_t spread;
+	uint64_t next_ns;
+	uint32_t posted;
+} producer_t;
+
+static producer_t producers[] = {
+	{ "ramoccur",	FSYS_SYS,		LOG_REC_RAMOCCUR,	2,	12000,	{ 0, 0, 0 },			3 },
+	{ "bms",		FSYS_BMS,		LOG_REC_BMS,		2,	10000,	{ 7400, 250000, 0 },	2000 },
+	{ "current",	OBC_CURRENT,	LOG_REC_CURRENT,	1,	10000,	{ 180, 0, 0 },			40 },
+	{ "temps",		TEMPS,			LOG_REC_TEMPS,		3,	10000,	{ 2400, 1900, 2100 },	150 },
+	{ "events",		FSYS_SYS,		LOG_REC_EVENT,		2,	0,		{ 2, 1, 0 },			2 },
+};
+#define NUM_PRODUCERS	(sizeof(producers) / sizeof(producers[0]))
+
+/* stand-ins for the task handles, only their addresses matter */
+static int service_task;
+static int telem_task;
+static int gc_task;
+
+static uint64_t due[DUE_QUEUE_SIZE];	/* due times of the queued records, oldest first */
+static uint32_t due_head;
+static uint32_t due_count;
+static uint32_t received;				/* records the service took off the queue so far */
+static bool gc_worked;
+static uint32_t *latencies_us;
+static uint32_t num_latencies;
+
+static struct {
+	uint64_t batch_ns;
+	uint64_t flush_ns;
+	uint64_t gc_ns;
+	uint64_t max_batch_ns;
+	uint64_t max_flush_ns;
+	uint64_t max_gc_ns;
+	uint32_t flag_changes;
+	uint32_t records;
+	uint32_t dropped;
+	uint32_t reopened;		/* circular logs whose head the reopen at the end found where it was */
+} bench;
+
+/* Private functions */
+static void post_record(producer_t *p);
+static void change_flag();
+static void service_batch();
+static void service_step();
+static void gc_step();
+static void timed(void (*fn)(), uint64_t *total, uint64_t *max);
+static void on_receive(QueueHandle_t q, const void *item);
+static void on_block(TaskHandle_t task);
+#ifdef FSYS_CIRCULAR_LOGS
+static void reopen_circular();
+#endif
+static void report(double hours);
+static void report_erases(const char *name, u32_t addr, u32_t size, u32_t block_size);
+static void report_wear(const char *name, u32_t addr, u32_t size);
+static void report_usage(const char *name, spiffs *p);
+static void report_latency(const char *name, const spiffs_hal_latency_t *l);
+static int compare_u32(const void *a, const void *b);
+static uint32_t percentile(uint32_t p);
+
+int main(int argc, char **argv) {
+	double hours = 24;
+	uint32_t events_per_hour = 6;
+	uint32_t flags_per_hour = 2;
+	uint32_t skew = 0;
+	uint32_t flag_period_ms;
+	uint64_t end;
+	uint64_t next;
+	uint64_t next_flag;
+	uint64_t next_flush;
+	uint64_t next_gc;
+	uint64_t next_wear_save;
+#ifndef FSYS_CIRCULAR_LOGS
+	uint64_t next_rotate;
+	fs_request_t req;
+#endif
+	uint32_t i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:e:f:s:gwv")) != -1) {
+		switch (opt) {
+			case 't': hours = atof(optarg); break;
+			case 'e': events_per_hour = atoi(optarg); break;
+			case 'f': flags_per_hour = atoi(optarg); break;
+			case 's': skew = atoi(optarg); break;
+			case 'g': fs_wear_gc = false; break;
+			case 'w':
+				flash_timing.t_pp_us = FLASH_T_PP_MAX_US;
+				flash_timing.t_se_us = FLASH_T_SE_MAX_US;
+				break;
+			case 'v': fw_serial_verbose = true; break;
+			default:
+				fprintf(stderr, "usage: %s [-t hours] [-e events/hour] [-f flag changes/hour] [-s erases] [-g] [-w] [-v]\n", argv[0]);
+				return 1;
+		}
+	}
+	producers[NUM_PRODUCERS - 1].period_ms = events_per_hour ? 3600000 / events_per_hour : 0;
+	flag_period_ms = flags_per_hour ? 3600000 / flags_per_hour : 0;
+	latencies_us = malloc(sizeof(uint32_t) * (size_t)(hours * 3600 + 1000));
+	srand(1);
+
+	/* the lifecycle task's startup on a blank chip: both partitions get formatted */
+	nor_init();
+	fs_service_init();
+	sim_receive_hook = on_receive;
+	sim_block_hook = on_block;
+	sim_set_task(&service_task);
+	fs_service_start();
+	sfu_fs_start();
+	printf("startup: %.1f ms, logs %u blocks of %u B, state %u blocks of %u B\n", sim_time_ns / 1e6,
+			fs.block_count, SPIFFS_CFG_LOG_BLOCK_SZ(&fs), fs_state.block_count, SPIFFS_CFG_LOG_BLOCK_SZ(&fs_state));
+
+	for (i = 0; i < SPIFFS_LOGS_SIZE / SPIFFS_PHYS_ERASE_SIZE / 2; i++) {
+		fs_wear_counts[(SPIFFS_LOGS_ADDR / SPIFFS_PHYS_ERASE_SIZE) + i] += skew;
+	}
+
+	/* count from here, not the formats */
+	nor_stats_reset();
+	memset(&flash_model_stats, 0, sizeof(flash_model_stats));
+	memset(&flash_wait_stats, 0, sizeof(flash_wait_stats));
+	memset(&fs_appender_stats, 0, sizeof(fs_appender_stats));
+	memset(&spiffs_hal_stats, 0, sizeof(spiffs_hal_stats));
+	memset(&fs_gc_stats, 0, sizeof(fs_gc_stats));
+	memset(&fs_check_stats, 0, sizeof(fs_check_stats));
+	memset(&fs_service_stats, 0, sizeof(fs_service_stats));
+	memset(&fs_circ_stats, 0, sizeof(fs_circ_stats));
+	end = sim_time_ns + (uint64_t)(hours * 3600 * NS_PER_S);
+	for (i = 0; i < NUM_PRODUCERS; i++) {
+		producers[i].next_ns = sim_time_ns + (uint64_t)producers[i].period_ms * NS_PER_MS;
+	}
+	next_flag = flag_period_ms ? sim_time_ns + (uint64_t)flag_period_ms * NS_PER_MS : end;
+	next_flush = sim_time_ns + TICKS_NS(FSYS_FLUSH_INTERVAL);
+	next_gc = sim_time_ns;
+	next_wear_save = sim_time_ns + TICKS_NS(FS_WEAR_SAVE_INTERVAL);
+#ifndef FSYS_CIRCULAR_LOGS
+	next_rotate = sim_time_ns + TICKS_NS(FSYS_LOOP_INTERVAL);
+#endif
+
+	while (sim_time_ns < end) {
+		/* telemetry and logging tasks: whatever came due, including while someone had the flash busy */
+		sim_set_task(&telem_task);
+		for (i = 0; i < NUM_PRODUCERS; i++) {
+			while (producers[i].period_ms && producers[i].next_ns <= sim_time_ns) {
+				post_record(&producers[i]);
+				producers[i].next_ns += (uint64_t)producers[i].period_ms * NS_PER_MS;
+			}
+		}
+		if (next_flag <= sim_time_ns) {
+			change_flag();
+			next_flag += (uint64_t)flag_period_ms * NS_PER_MS;
+		}
+
+		/* lifecycle task: serve until the queues are empty, then the stale pages */
+		sim_set_task(&service_task);
+		while (uxQueueMessagesWaiting(xFsServiceQueue) > 0 || uxQueueMessagesWaiting(xFsStateQueue) > 0) {
+			service_batch();
+		}
+		if (next_flush <= sim_time_ns) {
+			timed(sfu_flush_stale_logs, &bench.flush_ns, &bench.max_flush_ns);
+			next_flush = sim_time_ns + TICKS_NS(FSYS_FLUSH_INTERVAL);
+		}
+		if (next_wear_save <= sim_time_ns) {
+			timed(fs_wear_save, &bench.flush_ns, &bench.max_flush_ns);
+			next_wear_save = sim_time_ns + TICKS_NS(FS_WEAR_SAVE_INTERVAL);
+		}
+#ifndef FSYS_CIRCULAR_LOGS
+		if (next_rotate <= sim_time_ns) {
+			req.type = FS_REQ_ROTATE;
+			fs_service_post(&req);
+			next_rotate = sim_time_ns + TICKS_NS(FSYS_LOOP_INTERVAL);
+			continue;
+		}
+#endif
+
+		/* GC task: lowest priority, so only when everything above is done */
+		if (next_gc <= sim_time_ns) {
+			sim_set_task(&gc_task);
+			timed(gc_step, &bench.gc_ns, &bench.max_gc_ns);
+			next_gc = sim_time_ns + TICKS_NS(gc_worked ? FS_GC_STEP_INTERVAL : FS_GC_IDLE_INTERVAL);
+		}
+
+		/* idle until the next thing comes due */
+		next = end;
+		for (i = 0; i < NUM_PRODUCERS; i++) {
+			if (producers[i].period_ms && producers[i].next_ns < next) {
+				next = producers[i].next_ns;
+			}
+		}
+		next = (next_flag < next) ? next_flag : next;
+		next = (next_flush < next) ? next_flush : next;
+		next = (next_gc < next) ? next_gc : next;
+		next = (next_wear_save < next) ? next_wear_save : next;
+#ifndef FSYS_CIRCULAR_LOGS
+		next = (next_rotate < next) ? next_rotate : next;
+#endif
+		if (next > sim_time_ns) {
+			sim_advance_ns(next - sim_time_ns);
+		}
+	}
+
+#ifdef FSYS_CIRCULAR_LOGS
+	reopen_circular();
+#endif
+	report(hours);
+	return 0;
+}
+
+/* post_record
+ * 	- SFU_WRITE_RECORD, with fields that wander a bit so the varints are a realistic size
+ */
+static void post_record(producer_t *p) {
+	int32_t fields[3];
+	uint32_t dropped = fs_service_stats.dropped;
+	uint8_t i;
+
+	for (i = 0; i < p->num_fields; i++) {
+		fields[i] = p->base[i] + (rand() % (2 * p->spread + 1)) - p->spread;
+	}
+	sfu_write_fields(p->suffix, getCurrentRTCTime(), p->type, fields, p->num_fields);
+	p->posted++;
+	bench.records++;
+	if (fs_service_stats.dropped != dropped) {
+		bench.dropped++;
+		return;
+	}
+	due[(due_head + due_count) % DUE_QUEUE_SIZE] = p->next_ns;
+	due_count++;
+}
+
+static void change_flag() {
+	FLAG_SET(GEN_TELEM, period, 10000 + (rand() % 5) * 1000);
+	bench.flag_changes++;
+}
+
+/* service_batch
+ * 	- one fs_service_step. Every record in it is done when the batch is
+ */
+static void service_batch() {
+	uint32_t before = received;
+	uint32_t i;
+
+	timed(service_step, &bench.batch_ns, &bench.max_batch_ns);
+	for (i = before; i < received; i++) {
+		latencies_us[num_latencies++] = (uint32_t)((sim_time_ns - due[due_head]) / 1000);
+		due_head = (due_head + 1) % DUE_QUEUE_SIZE;
+		due_count--;
+	}
+}
+
+static void service_step() {
+	fs_service_step(0);
+}
+
+/* gc_step
+ * 	- vFilesystemGCTask's loop body: a GC step, or a check step when there was nothing to collect
+ */
+static void gc_step() {
+	gc_worked = fs_gc_step();
+	if (!gc_worked) {
+		fs_check_step();
+	}
+}
+
+static void timed(void (*fn)(), uint64_t *total, uint64_t *max) {
+	uint64_t start = sim_time_ns;
+	uint64_t ns;
+
+	fn();
+	ns = sim_time_ns - start;
+	*total += ns;
+	if (ns > *max) {
+		*max = ns;
+	}
+}
+
+static void on_receive(QueueHandle_t q, const void *item) {
+	const fs_request_t *req = (const fs_request_t *)item;
+
+	if (q == xFsServiceQueue && req->type == FS_REQ_FIELDS) {
+		received++;
+	}
+}
+
+/* on_block
+ * 	- someone called fs_service_call and waits for the service, which would run now
+ */
+static void on_block(TaskHandle_t task) {
+	sim_set_task(&service_task);
+	while (uxQueueMessagesWaiting(xFsServiceQueue) > 0 || uxQueueMessagesWaiting(xFsStateQueue) > 0) {
+		service_batch();
+	}
+	sim_set_task(task);
+}
+
+#ifdef FSYS_CIRCULAR_LOGS
+/* reopen_circular
+ * 	- forgets the appenders like a reset would, after the logs were flushed, and reopens them. Head has to come back
+ * 	  where it was, or at the start of the next page when it was part way into one after the first lap
+ */
+static void reopen_circular() {
+	uint32_t expected[FSYS_NUM_SUBSYS];
+	fs_appender_t *app;
+	uint32_t i;
+
+	sim_set_task(&service_task);
+	sfu_flush_logs();
+	xSemaphoreTake(spiffsTopMutex, portMAX_DELAY);
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		app = fs_appender_get(FSYS_OFFSET + i);
+		expected[i] = fs_circ_position(&app->circ);
+		if (app->circ.wraps > 0 && app->circ.head % SPIFFS_DATA_PAGE_SIZE(&fs) != 0) {
+			expected[i] += SPIFFS_DATA_PAGE_SIZE(&fs) - app->circ.head % SPIFFS_DATA_PAGE_SIZE(&fs);
+			if (expected[i] == FS_CIRC_DATA_START + FS_CIRC_DATA_SIZE) {
+				expected[i] = FS_CIRC_DATA_START;
+			}
+		}
+	}
+	fs_appender_close_all_noMutex();
+	fs_appender_init();
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		if (fs_appender_open_noMutex(FSYS_OFFSET + i, 0) >= 0 && fs_appender_get(FSYS_OFFSET + i)->size == expected[i]) {
+			bench.reopened++;
+		}
+	}
+	xSemaphoreGive(spiffsTopMutex);
+}
+#endif
+
+static void report(double hours) {
+	double seconds = hours * 3600;
+	double busy = (bench.batch_ns + bench.flush_ns + bench.gc_ns) / 1e9;
+	uint32_t i;
+
+	printf("run: %.1f h, %s, tPP %u us, tSE %u ms, SPI %u MHz\n", hours,
+#ifdef FSYS_CIRCULAR_LOGS
+			"circular logs",
+#else
+			"rotating logs",
+#endif
+			flash_timing.t_pp_us, flash_timing.t_se_us / 1000, flash_timing.spi_hz / 1000000);
+
+	printf("\nrecords: %u (%.2f/s), %u dropped, %u flag changes\n", bench.records, bench.records / seconds,
+			bench.dropped, bench.flag_changes);
+	for (i = 0; i < NUM_PRODUCERS; i++) {
+		if (producers[i].posted > 0) {
+			printf("  %-9s %6u\n", producers[i].name, producers[i].posted);
+		}
+	}
+	qsort(latencies_us, num_latencies, sizeof(latencies_us[0]), compare_u32);
+	printf("latency, due to done: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n", percentile(50) / 1e3,
+			percentile(90) / 1e3, percentile(99) / 1e3, percentile(100) / 1e3);
+
+	printf("\nbusy: %.1f s (%.2f%% of the run)\n", busy, 100 * busy / seconds);
+	printf("  service   %8.1f s in %u batches (max %u requests), longest %.1f ms\n", bench.batch_ns / 1e9,
+			fs_service_stats.batches, fs_service_stats.max_batch, bench.max_batch_ns / 1e6);
+	printf("  flushes   %8.1f s, longest %.1f ms\n", bench.flush_ns / 1e9, bench.max_flush_ns / 1e6);
+	printf("  gc        %8.1f s, longest %.1f ms\n", bench.gc_ns / 1e9, bench.max_gc_ns / 1e6);
+	printf("throughput: %.0f records/s while busy\n", (busy > 0) ? bench.records / busy : 0);
+
+	printf("\nwrites: %u SPIFFS writes (%.3f/s, %u B), %u page programs (%.3f/s, %llu B), %u sector erases\n",
+			spiffs_hal_stats.writes, spiffs_hal_stats.writes / seconds, spiffs_hal_stats.write_bytes,
+			nor_stats.programs, nor_stats.programs / seconds, (unsigned long long)nor_stats.program_bytes,
+			nor_stats.erases);
+	printf("write amplification: %u B of records, %u B staged out in %u writes, %u B to the HAL, %llu B programmed: %.1fx\n",
+			fs_appender_stats.bytes, fs_appender_stats.write_out_bytes, fs_appender_stats.write_outs,
+			spiffs_hal_stats.write_bytes, (unsigned long long)nor_stats.program_bytes,
+			fs_appender_stats.bytes ? (double)nor_stats.program_bytes / fs_appender_stats.bytes : 0);
+#ifdef FSYS_CIRCULAR_LOGS
+	printf("circular: %u wraps, %u header writes, %u pads (%u B), head found on reopen for %u of %u logs\n",
+			fs_circ_stats.wraps, fs_circ_stats.header_writes, fs_circ_stats.pads, fs_circ_stats.pad_bytes,
+			bench.reopened, FSYS_NUM_SUBSYS);
+#endif
+	printf("flash: %u transfers, %u status polls, bus %.1f s (%.1f s blocked), program %.1f s, erase %.1f s, %u commands ignored, %u page wraps\n",
+			flash_model_stats.transfers, flash_model_stats.status_polls, flash_model_stats.bus_ns / 1e9,
+			flash_model_stats.blocked_ns / 1e9,
+			flash_model_stats.program_busy_ns / 1e9, flash_model_stats.erase_busy_ns / 1e9,
+			flash_model_stats.ignored, nor_stats.wraps);
+	printf("program/erase waits: %u, %u status polls, %u sleeps, %.1f s waited, %.1f s of it asleep\n",
+			flash_wait_stats.waits, flash_wait_stats.polls, flash_wait_stats.sleeps, flash_wait_stats.wait_us / 1e6,
+			flash_wait_stats.slept_us / 1e6);
+	printf("HAL calls (\"get fs\"):\n");
+	report_latency("read", &spiffs_hal_stats.read_time);
+	report_latency("write", &spiffs_hal_stats.write_time);
+	report_latency("erase", &spiffs_hal_stats.erase_time);
+	printf("partitions, cache %u + %u pages:\n", SPIFFS_LOGS_CACHE_PAGES, SPIFFS_STATE_CACHE_PAGES);
+	report_usage("logs", &fs);
+	report_usage("state", &fs_state);
+
+	printf("\ngc: %u quick, %u full, %u in the write path, %u errors, SPIFFS counted %u runs, erase ages from %s\n",
+			fs_gc_stats.quick_runs, fs_gc_stats.full_runs, fs_gc_stats.foreground_runs, fs_gc_stats.errors,
+			fs.stats_gc_runs, fs_wear_gc ? "fs_wear" : "SPIFFS");
+	printf("check: %u passes, %u blocks, %u errors (last pass %u), max hold %u ms\n", fs_check_stats.passes,
+			fs_check_stats.blocks, fs_check_stats.errors, fs_check_stats.last_pass_errors,
+			fs_check_stats.max_ticks * portTICK_PERIOD_MS);
+	printf("erases per block in the run:\n");
+	report_erases("logs", SPIFFS_LOGS_ADDR, SPIFFS_LOGS_SIZE, SPIFFS_LOGS_BLOCK_SIZE);
+	report_erases("state", SPIFFS_STATE_ADDR, SPIFFS_STATE_SIZE, SPIFFS_STATE_BLOCK_SIZE);
+	printf("fs_wear, lifetime (\"get wear\"), %u saves, %u errors:\n", fs_wear_stats.saves, fs_wear_stats.save_errors);
+	report_wear("logs", SPIFFS_LOGS_ADDR, SPIFFS_LOGS_SIZE);
+	report_wear("state", SPIFFS_STATE_ADDR, SPIFFS_STATE_SIZE);
+	printf("\nserial: %u lines\n", fw_serial_lines);
+}
+
+/* report_erases
+ * 	- a block's sectors are always erased together, so its first sector's count is the block's
+ */
+static void report_erases(const char *name, u32_t addr, u32_t size, u32_t block_size) {
+	u32_t blocks = size / block_size;
+	u32_t min = 0xFFFFFFFF;
+	u32_t max = 0;
+	u32_t total = 0;
+	u32_t count;
+	u32_t b;
+
+	printf("  %-5s", name);
+	for (b = 0; b < blocks; b++) {
+		count = nor_stats.sector_erases[(addr + b * block_size) / NOR_SECTOR_SIZE];
+		min = (count < min) ? count : min;
+		max = (count > max) ? count : max;
+		total += count;
+		printf("%s%u", (b > 0 && b % 16 == 0) ? "\n       " : " ", count);
+	}
+	printf("\n        min %u, mean %.1f, max %u\n", min, (double)total / blocks, max);
+}
+
+static void report_wear(const char *name, u32_t addr, u32_t size) {
+	fs_wear_hist_t h;
+	u32_t i;
+
+	fs_wear_histogram(addr, size, &h);
+	printf("  %-5s %u-%u, mean %.1f, bins of %u:", name, h.min, h.max, (double)h.total / h.sectors, h.width);
+	for (i = 0; i < FS_WEAR_BINS; i++) {
+		printf(" %u", h.bins[i]);
+	}
+	printf("\n");
+}
+
+static int compare_u32(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static uint32_t percentile(uint32_t p) {
+	if (num_latencies == 0) {
+		return 0;
+	}
+	return latencies_us[(uint32_t)(((uint64_t)num_latencies - 1) * p / 100)];
+}
+
+static void report_usage(const char *name, spiffs *p) {
+	spiffs_usage_t u;
+
+	if (my_spiffs_usage(p, &u, 0) != SPIFFS_OK) {
+		printf("  %-5s busy\n", name);
+		return;
+	}
+	printf("  %-5s %u/%u B used, %u pages free, %u deleted, cache %u hits %u misses (%.1f%%)\n", name, u.used, u.total,
+			u.pages_free, u.pages_deleted, u.cache_hits, u.cache_misses,
+			(u.cache_hits + u.cache_misses) ? 100.0 * u.cache_hits / (u.cache_hits + u.cache_misses) : 0);
+}
+
+static void report_latency(const char *name, const spiffs_hal_latency_t *l) {
+	printf("  %-5s %8u calls, mean %.1f us, max %u us\n", name, l->calls,
+			l->calls ? (double)l->total_us / l->calls : 0, l->max_us);
+}
@@ -0,0 +1,61 @@
+/*
+ * fw_stubs.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      The rest of the firmware the filesystem sources call into, for fs_bench: the UART, the RTC and the logging
+ *      task. Nothing goes anywhere, serial output is counted and printed with fs_bench -v. DLOG_SERIAL goes through
+ *      the real obc_dlog.c.
+ */
+
+#include <stdio.h>
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "gio.h"
+#include "reg_system.h"
+#include "obc_uart.h"
+#include "obc_rtc.h"
+#include "obc_dlog.h"
+#include "obc_task_logging.h"
+#include "rtos_model.h"
+#include "fw_stubs.h"
+
+#define SIM_RTC_START	600000000	/* RTC seconds at the start of the run */
+
+uint32_t fw_serial_lines;
+bool fw_serial_verbose;
+
+gioPORT_t sim_gio_ports[2];
+systemBASE1_t sim_system_reg1;
+
+void serialSend(char *toSend) {
+	serialSendln(toSend);
+}
+
+void serialSendln(const char *toSend) {
+	fw_serial_lines++;
+	if (fw_serial_verbose) {
+		printf("%10.3f  %s\n", sim_time_ns / 1e9, toSend);
+	}
+}
+
+/* serialSendQ
+ * 	- what the serial TX task would do with the queued item, right away
+ */
+BaseType_t serialSendQ(const char *toSend) {
+	if (toSend[0] == SERIAL_DEFERRED_TAG) {
+		dlog_send_serial((const serial_deferred_t *)toSend);
+	} else {
+		serialSendln(toSend);
+	}
+	return pdPASS;
+}
+
+uint32_t getCurrentRTCTime() {
+	return SIM_RTC_START + (uint32_t)(sim_time_ns / 1000000000);
+}
+
+BaseType_t addLogItem(LogType_t logType, EncodedMessage_t encodedMessage) {
+	return pdPASS;
+}
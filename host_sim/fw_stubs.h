@@ -0,0 +1,16 @@
+/*
+ * fw_stubs.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef HOST_SIM_FW_STUBS_H_
+#define HOST_SIM_FW_STUBS_H_
+
+#include "sys_common.h"
+
+extern uint32_t fw_serial_lines;		/* lines the firmware sent to the UART */
+extern bool fw_serial_verbose;			/* print them as they go */
+
+#endif /* HOST_SIM_FW_STUBS_H_ */
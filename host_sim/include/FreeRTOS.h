@@ -0,0 +1,37 @@
+/*
+ * FreeRTOS.h
+ *
+ *      Host build stand-in. The types and macros the firmware uses from the kernel headers, with a 1 ms tick like
+ *      FreeRTOSConfig.h. The calls are declared in rtos_task.h, rtos_queue.h and rtos_semphr.h and implemented by
+ *      rtos_model.c, which only fs_bench links.
+ */
+
+#ifndef HOST_SIM_FREERTOS_H_
+#define HOST_SIM_FREERTOS_H_
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE				((BaseType_t)0)
+#define pdTRUE				((BaseType_t)1)
+#define pdPASS				pdTRUE
+#define pdFAIL				pdFALSE
+#define errQUEUE_FULL		((BaseType_t)0)
+
+#define configTICK_RATE_HZ	1000
+#define portTICK_PERIOD_MS	(1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY		((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms)	((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000))
+
+/* the PMU cycle counter, at GCLK_FREQ (system.h) off sim_time_ns */
+BaseType_t getRunTimeCounterValue(void);
+#define portGET_RUN_TIME_COUNTER_VALUE()	(getRunTimeCounterValue())
+
+/* there's only ever one thread */
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif /* HOST_SIM_FREERTOS_H_ */
@@ -0,0 +1,39 @@
+/*
+ * flash_mibspi.h
+ *
+ *      Host build stand-in for the flash driver header. Just the calls the SPIFFS HAL (obc_spiffs.c) makes,
+ *      flash_model.c implements them on nor_model.c with the driver's transactions and their timing.
+ */
+
+#ifndef HOST_SIM_FLASH_MIBSPI_H_
+#define HOST_SIM_FLASH_MIBSPI_H_
+
+#include "sys_common.h"
+
+#define FLASH_STREAM_LEN 64 // buffers (bytes) in FLASH_STREAM_GROUP
+#define FLASH_PAGE_SIZE 256 // Page Program wraps around within a page, so commands are split at page boundaries
+
+#define FLASH_T_PP_US 200
+#define FLASH_T_SE_US 70000
+#define FLASH_T_CE_US 5000000
+#define FLASH_WAIT_POLLS 16
+
+typedef struct flash_wait_stats {
+	uint32_t waits;
+	uint32_t polls;
+	uint32_t sleeps;
+	uint64_t wait_us;
+	uint64_t slept_us;
+	uint32_t stream_timeouts;
+} flash_wait_stats_t;
+
+extern flash_wait_stats_t flash_wait_stats;
+
+void flash_erase_chip();
+void flash_erase_sector(uint32_t address);
+uint16_t flash_status();
+bool flash_write_arbitrary(uint32_t address, uint32_t size, uint8_t *src);
+bool flash_read_arbitrary(uint32_t address, uint32_t size, uint8_t *dest);
+void flash_wait_done(uint32_t typ_us);
+
+#endif /* HOST_SIM_FLASH_MIBSPI_H_ */
@@ -0,0 +1,27 @@
+/*
+ * gio.h
+ *
+ *      Host build stand-in for the HALCoGen GIO driver, so obc_utils.c builds. Pins go nowhere.
+ */
+
+#ifndef HOST_SIM_GIO_H_
+#define HOST_SIM_GIO_H_
+
+#include "sys_common.h"
+
+typedef struct gioPort {
+	uint32 DIR;
+	uint32 DIN;
+	uint32 DOUT;
+} gioPORT_t;
+
+extern gioPORT_t sim_gio_ports[2];
+
+#define gioPORTA	(&sim_gio_ports[0])
+#define gioPORTB	(&sim_gio_ports[1])
+
+#define gioSetBit(port, bit, value)	((void)(port), (void)(bit), (void)(value))
+#define gioGetBit(port, bit)			((void)(port), (void)(bit), 0U)
+#define gioToggleBit(port, bit)			((void)(port), (void)(bit))
+
+#endif /* HOST_SIM_GIO_H_ */
@@ -0,0 +1,12 @@
+/*
+ * mibspi.h
+ *
+ *      Host build stand-in for the HALCoGen MIBSPI driver header, obc_hardwaredefs.h includes it.
+ */
+
+#ifndef HOST_SIM_MIBSPI_H_
+#define HOST_SIM_MIBSPI_H_
+
+#include "sys_common.h"
+
+#endif /* HOST_SIM_MIBSPI_H_ */
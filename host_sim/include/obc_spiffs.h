@@ -0,0 +1,11 @@
+/*
+ * obc_spiffs.h
+ *
+ *      Host build stand-in. spiffs_hydrogen.c includes the firmware's integration header but doesn't use anything in it,
+ *      and the real one pulls in the RTOS.
+ */
+
+#ifndef HOST_SIM_OBC_SPIFFS_H_
+#define HOST_SIM_OBC_SPIFFS_H_
+
+#endif /* HOST_SIM_OBC_SPIFFS_H_ */
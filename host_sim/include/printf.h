@@ -0,0 +1,16 @@
+/*
+ * printf.h
+ *
+ *      Host build stand-in for our printf (printf/printf.h), which replaces the C library's on target. The host build
+ *      uses the C library's, sfu_vsnprintf included.
+ */
+
+#ifndef HOST_SIM_PRINTF_H_
+#define HOST_SIM_PRINTF_H_
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#define sfu_vsnprintf vsnprintf
+
+#endif /* HOST_SIM_PRINTF_H_ */
@@ -0,0 +1,20 @@
+/*
+ * reg_system.h
+ *
+ *      Host build stand-in for the HALCoGen system registers, so obc_utils.c builds.
+ */
+
+#ifndef HOST_SIM_REG_SYSTEM_H_
+#define HOST_SIM_REG_SYSTEM_H_
+
+#include "sys_common.h"
+
+typedef struct systemBase1 {
+	uint32 SYSECR;
+} systemBASE1_t;
+
+extern systemBASE1_t sim_system_reg1;
+
+#define systemREG1	(&sim_system_reg1)
+
+#endif /* HOST_SIM_REG_SYSTEM_H_ */
@@ -0,0 +1,20 @@
+/*
+ * rtos_queue.h
+ *
+ *      Host build stand-in, see FreeRTOS.h. Nothing else runs while the one thread waits, so a send to a full queue or
+ *      a receive from an empty one fails right away whatever the wait.
+ */
+
+#ifndef HOST_SIM_RTOS_QUEUE_H_
+#define HOST_SIM_RTOS_QUEUE_H_
+
+#include "FreeRTOS.h"
+
+typedef struct sim_queue * QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t q, void *buf, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+
+#endif /* HOST_SIM_RTOS_QUEUE_H_ */
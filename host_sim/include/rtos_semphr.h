@@ -0,0 +1,20 @@
+/*
+ * rtos_semphr.h
+ *
+ *      Host build stand-in, see FreeRTOS.h. Mutexes aren't recursive, like on target: taking one that's held fails
+ *      instead of deadlocking, so the caller's timeout path runs. Binary semaphores start empty.
+ */
+
+#ifndef HOST_SIM_RTOS_SEMPHR_H_
+#define HOST_SIM_RTOS_SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+typedef struct sim_mutex * SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+#endif /* HOST_SIM_RTOS_SEMPHR_H_ */
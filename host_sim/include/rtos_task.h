@@ -0,0 +1,21 @@
+/*
+ * rtos_task.h
+ *
+ *      Host build stand-in, see FreeRTOS.h. Everything runs in the one host thread, rtos_model.c keeps the time.
+ */
+
+#ifndef HOST_SIM_RTOS_TASK_H_
+#define HOST_SIM_RTOS_TASK_H_
+
+#include "FreeRTOS.h"
+
+typedef void * TaskHandle_t;
+
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vTaskDelay(TickType_t ticks);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif /* HOST_SIM_RTOS_TASK_H_ */
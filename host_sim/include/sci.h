@@ -0,0 +1,12 @@
+/*
+ * sci.h
+ *
+ *      Host build stand-in for the HALCoGen SCI driver header, obc_uart.h includes it. fw_stubs.c is the UART.
+ */
+
+#ifndef HOST_SIM_SCI_H_
+#define HOST_SIM_SCI_H_
+
+#include "sys_common.h"
+
+#endif /* HOST_SIM_SCI_H_ */
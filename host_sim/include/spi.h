@@ -0,0 +1,12 @@
+/*
+ * spi.h
+ *
+ *      Host build stand-in for the HALCoGen SPI driver header, obc_hardwaredefs.h includes it.
+ */
+
+#ifndef HOST_SIM_SPI_H_
+#define HOST_SIM_SPI_H_
+
+#include "sys_common.h"
+
+#endif /* HOST_SIM_SPI_H_ */
@@ -0,0 +1,23 @@
+/*
+ * sys_common.h
+ *
+ *      Host build stand-in for the HALCoGen header. Just the types.
+ */
+
+#ifndef HOST_SIM_SYS_COMMON_H_
+#define HOST_SIM_SYS_COMMON_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef bool boolean;
+
+#ifndef TRUE
+#define TRUE	true
+#define FALSE	false
+#endif
+
+#endif /* HOST_SIM_SYS_COMMON_H_ */
@@ -0,0 +1,12 @@
+/*
+ * system.h
+ *
+ *      Host build stand-in for the HALCoGen clock settings. Same GCLK as platform-obc-v0.4.
+ */
+
+#ifndef HOST_SIM_SYSTEM_H_
+#define HOST_SIM_SYSTEM_H_
+
+#define GCLK_FREQ	60.000F		/* MHz */
+
+#endif /* HOST_SIM_SYSTEM_H_ */
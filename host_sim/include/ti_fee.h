@@ -0,0 +1,44 @@
+/*
+ * ti_fee.h
+ *
+ *      Host build stand-in for the TI FEE driver header (platform-obc-v0.4/include/ti_fee.h). Just the types and the
+ *      calls obc_flag_fee.c makes, fee_model.c implements them.
+ */
+
+#ifndef HOST_SIM_TI_FEE_H_
+#define HOST_SIM_TI_FEE_H_
+
+#include "sys_common.h"
+
+typedef uint8_t Std_ReturnType;
+
+#define E_OK		0U
+#define E_NOT_OK	1U
+
+typedef enum
+{
+	UNINIT,
+	IDLE,
+	BUSY,
+	BUSY_INTERNAL
+} TI_FeeModuleStatusType;
+
+typedef enum
+{
+	JOB_OK,
+	JOB_FAILED,
+	JOB_PENDING,
+	JOB_CANCELLED,
+	BLOCK_INCONSISTENT,
+	BLOCK_INVALID
+} TI_FeeJobResultType;
+
+void TI_Fee_Init(void);
+void TI_Fee_MainFunction(void);
+TI_FeeModuleStatusType TI_Fee_GetStatus(uint8 u8EEPIndex);
+TI_FeeJobResultType TI_Fee_GetJobResult(uint8 u8EEPIndex);
+Std_ReturnType TI_Fee_WriteSync(uint16 BlockNumber, uint8 *DataBufferPtr);
+Std_ReturnType TI_Fee_ReadSync(uint16 BlockNumber, uint16 BlockOffset, uint8 *DataBufferPtr, uint16 Length);
+Std_ReturnType TI_Fee_InvalidateBlock(uint16 BlockNumber);
+
+#endif /* HOST_SIM_TI_FEE_H_ */
@@ -0,0 +1,169 @@
+/*
+ * mount_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      How much does a SPIFFS mount cost on a full flash?
+ *
+ *      Builds an image of the logs partition (obc_spiffs.h) the way the OBC fills it (PREFIX_QUANTITY sets of FSYS_NUM_SUBSYS logs appended a data page
+ *      at a time, the oldest set deleted on rotation), then counts the flash reads a mount scan does on it. It also
+ *      times N log appends both ways: remount + open + write + close per entry (what sfu_write_fname used to do)
+ *      and with SPIFFS mounted once and the fd kept open.
+ *
+ *      The mount scan itself only reads the object lookup pages and the block magics, 248 reads (32 KB) for the 62
+ *      blocks. What makes the remount per entry expensive is what it throws away: the page cache and the free page
+ *      cursor, so the open and the write after it scan the lookup pages again. At 50% full that's ~520 reads per entry
+ *      against ~1.7 mounted.
+ *
+ *      usage: mount_bench [fill %] [rotations] [appends]		(defaults 50 4 1000)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+#include "nor_model.h"
+
+/* same as the firmware (obc_fs_structure.h, obc_spiffs.h) */
+#define PREFIX_START		97
+#define PREFIX_QUANTITY		3
+#define FSYS_OFFSET			65
+#define FSYS_NUM_SUBSYS		5
+#define LOG_PAGE_SIZE		256
+#define LOGS_SIZE			(NOR_SIZE - 64 * 1024)	/* the logs partition, the state partition is above it */
+#define LOGS_BLOCK_SIZE		32768
+#define ENTRY_SIZE			24		/* a typical telemetry record */
+
+static spiffs fs;
+static spiffs_config cfg;
+static u8_t work_buf[LOG_PAGE_SIZE * 2];
+static u8_t fds[32 * 16];
+static u8_t cache_buf[(LOG_PAGE_SIZE + 32) * 4];
+
+static s32_t mount() {
+	cfg.hal_read_f = nor_read;
+	cfg.hal_write_f = nor_write;
+	cfg.hal_erase_f = nor_erase;
+	cfg.phys_addr = 0;
+	cfg.phys_size = LOGS_SIZE;
+	cfg.phys_erase_block = NOR_SECTOR_SIZE;
+	cfg.log_block_size = LOGS_BLOCK_SIZE;
+	cfg.log_page_size = LOG_PAGE_SIZE;
+	cfg.fh_ix_offset = 0;
+	return SPIFFS_mount(&fs, &cfg, work_buf, fds, sizeof(fds), cache_buf, sizeof(cache_buf), 0);
+}
+
+/* fill_prefix
+ * 	- writes bytes spread over the prefix's logs, a data page per write like the appenders do
+ */
+static void fill_prefix(char prefix, u32_t bytes) {
+	static u8_t page[LOG_PAGE_SIZE];
+	char name[3] = { prefix, '\0', '\0' };
+	spiffs_file fd[FSYS_NUM_SUBSYS];
+	u32_t chunk = SPIFFS_DATA_PAGE_SIZE(&fs);
+	u32_t written = 0;
+	u8_t i;
+
+	memset(page, 0x5A, sizeof(page));
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		name[1] = FSYS_OFFSET + i;
+		fd[i] = SPIFFS_open(&fs, name, SPIFFS_CREAT | SPIFFS_APPEND | SPIFFS_RDWR, 0);
+		if (fd[i] < 0) {
+			fprintf(stderr, "open %s: %d\n", name, SPIFFS_errno(&fs));
+			exit(1);
+		}
+	}
+	for (i = 0; written < bytes; i = (i + 1) % FSYS_NUM_SUBSYS, written += chunk) {
+		if (SPIFFS_write(&fs, fd[i], page, chunk) < 0) {
+			fprintf(stderr, "write %c%c: %d\n", prefix, FSYS_OFFSET + i, SPIFFS_errno(&fs));
+			exit(1);
+		}
+	}
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		SPIFFS_close(&fs, fd[i]);
+	}
+}
+
+static void delete_prefix(char prefix) {
+	char name[3] = { prefix, '\0', '\0' };
+	u8_t i;
+
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		name[1] = FSYS_OFFSET + i;
+		SPIFFS_remove(&fs, name);
+	}
+}
+
+static void print_stats(const char *name, u32_t ops) {
+	printf("%-22s %8u reads %10llu B read %7u writes %5u erases", name, nor_stats.reads,
+			(unsigned long long)nor_stats.read_bytes, nor_stats.writes, nor_stats.erases);
+	if (ops > 1) {
+		printf("  (%.1f reads/op)", (double)nor_stats.reads / ops);
+	}
+	printf("\n");
+}
+
+int main(int argc, char **argv) {
+	u32_t fill = (argc > 1) ? atoi(argv[1]) : 50;
+	u32_t rotations = (argc > 2) ? atoi(argv[2]) : 4;
+	u32_t appends = (argc > 3) ? atoi(argv[3]) : 1000;
+	u32_t usable;
+	u32_t total;
+	u32_t used;
+	u8_t entry[ENTRY_SIZE];
+	char name[3] = { PREFIX_START, FSYS_OFFSET, '\0' };
+	spiffs_file fd;
+	u32_t i;
+
+	nor_init();
+	mount();	/* fails on a blank chip, but format needs the config from it */
+	SPIFFS_unmount(&fs);
+	if (SPIFFS_format(&fs) != SPIFFS_OK || mount() != SPIFFS_OK) {
+		fprintf(stderr, "format/mount failed: %d\n", SPIFFS_errno(&fs));
+		return 1;
+	}
+
+	/* each prefix gets its share of fill %, cycling through the prefixes like the lifecycle task does */
+	SPIFFS_info(&fs, &usable, &used);
+	for (i = 0; i < PREFIX_QUANTITY * rotations; i++) {
+		if (i >= PREFIX_QUANTITY) {
+			delete_prefix(PREFIX_START + (i % PREFIX_QUANTITY));
+		}
+		fill_prefix(PREFIX_START + (i % PREFIX_QUANTITY), (u32_t)((uint64_t)usable * fill / 100 / PREFIX_QUANTITY));
+	}
+	SPIFFS_info(&fs, &total, &used);
+	printf("image: %u/%u B used (%u%%), %u rotations, %u blocks of %u B, %u B pages\n", used, total,
+			used * 100 / total, rotations, fs.block_count, SPIFFS_CFG_LOG_BLOCK_SZ(&fs), SPIFFS_CFG_LOG_PAGE_SZ(&fs));
+
+	/* a single mount scan */
+	SPIFFS_unmount(&fs);
+	nor_stats_reset();
+	mount();
+	print_stats("mount scan", 1);
+
+	/* appends, remounting for every entry */
+	memset(entry, 0x33, sizeof(entry));
+	nor_stats_reset();
+	for (i = 0; i < appends; i++) {
+		SPIFFS_unmount(&fs);
+		mount();
+		fd = SPIFFS_open(&fs, name, SPIFFS_APPEND | SPIFFS_RDWR, 0);
+		SPIFFS_write(&fs, fd, entry, sizeof(entry));
+		SPIFFS_close(&fs, fd);
+	}
+	print_stats("remount per append", appends);
+
+	/* appends, mounted once */
+	nor_stats_reset();
+	fd = SPIFFS_open(&fs, name, SPIFFS_APPEND | SPIFFS_RDWR, 0);
+	for (i = 0; i < appends; i++) {
+		SPIFFS_write(&fs, fd, entry, sizeof(entry));
+	}
+	SPIFFS_close(&fs, fd);
+	print_stats("mounted once", appends);
+
+	SPIFFS_unmount(&fs);
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * nor_model.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "nor_model.h"
+
+nor_stats_t nor_stats;
+
+static u8_t nor[NOR_SIZE];
+
+void nor_init() {
+	memset(nor, 0xFF, sizeof(nor));
+	nor_stats_reset();
+}
+
+void nor_stats_reset() {
+	memset(&nor_stats, 0, sizeof(nor_stats));
+}
+
+s32_t nor_read(u32_t addr, u32_t size, u8_t *dst) {
+	if (addr + size > NOR_SIZE) {
+		fprintf(stderr, "nor: read past the end, %08x + %u\n", addr, size);
+		return SPIFFS_ERR_INTERNAL;
+	}
+	memcpy(dst, &nor[addr], size);
+	nor_stats.reads++;
+	nor_stats.read_bytes += size;
+	return SPIFFS_OK;
+}
+
+s32_t nor_write(u32_t addr, u32_t size, u8_t *src) {
+	u32_t i;
+
+	if (addr + size > NOR_SIZE) {
+		fprintf(stderr, "nor: write past the end, %08x + %u\n", addr, size);
+		return SPIFFS_ERR_INTERNAL;
+	}
+	for (i = 0; i < size; i++) {
+		nor[addr + i] &= src[i]; /* programming only clears bits */
+	}
+	nor_stats.writes++;
+	nor_stats.write_bytes += size;
+	return SPIFFS_OK;
+}
+
+s32_t nor_erase(u32_t addr, u32_t size) {
+	if ((addr % NOR_SECTOR_SIZE) != 0 || (size % NOR_SECTOR_SIZE) != 0 || addr + size > NOR_SIZE) {
+		fprintf(stderr, "nor: bad erase, %08x + %u\n", addr, size);
+		return SPIFFS_SFU_ERR_ERASE_SZ;
+	}
+	memset(&nor[addr], 0xFF, size);
+	nor_stats.erases += size / NOR_SECTOR_SIZE;
+	for (; size > 0; addr += NOR_SECTOR_SIZE, size -= NOR_SECTOR_SIZE) {
+		nor_stats.sector_erases[addr / NOR_SECTOR_SIZE]++;
+	}
+	return SPIFFS_OK;
+}
+
+s32_t nor_program(u32_t addr, u32_t size, const u8_t *src) {
+	u32_t page = addr & ~(NOR_PAGE_SIZE - 1);
+	u32_t i;
+
+	if (addr >= NOR_SIZE || size > NOR_PAGE_SIZE) {
+		fprintf(stderr, "nor: bad program, %08x + %u\n", addr, size);
+		return SPIFFS_ERR_INTERNAL;
+	}
+	if ((addr - page) + size > NOR_PAGE_SIZE) {
+		nor_stats.wraps++;
+	}
+	for (i = 0; i < size; i++) {
+		nor[page + ((addr - page + i) % NOR_PAGE_SIZE)] &= src[i];
+	}
+	nor_stats.programs++;
+	nor_stats.program_bytes += size;
+	return SPIFFS_OK;
+}
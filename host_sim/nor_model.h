@@ -0,0 +1,49 @@
+/*
+ * nor_model.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      RAM model of the 2 MB SPI NOR flash (IS25LP016D) for host builds.
+ *
+ *      Behaves like NOR: erase sets a 4 KB sector to 0xFF, programming can only clear bits (new = old & data).
+ *      Counts HAL calls the same way spiffs_hal_stats does on the OBC, so numbers from here line up with the
+ *      "get gc"/bench output on target.
+ *
+ *      nor_read/nor_write/nor_erase can be a SPIFFS HAL directly (mount_bench). nor_program is one Page Program
+ *      command instead, for the driver model (flash_model.c): like the chip, an address that runs past the end of the
+ *      256 byte page wraps around to the start of the same page. No timing here, the driver model keeps the clock.
+ */
+
+#ifndef HOST_SIM_NOR_MODEL_H_
+#define HOST_SIM_NOR_MODEL_H_
+
+#include "spiffs.h"
+
+#define NOR_SIZE			(2 * 1024 * 1024)
+#define NOR_SECTOR_SIZE		4096
+#define NOR_PAGE_SIZE		256		/* Page Program wraps within this */
+#define NOR_SECTORS			(NOR_SIZE / NOR_SECTOR_SIZE)
+
+typedef struct nor_stats {
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t erases;
+	uint64_t read_bytes;
+	uint64_t write_bytes;
+	uint32_t programs;						/* nor_program commands, and the bytes in them */
+	uint64_t program_bytes;
+	uint32_t wraps;							/* programs that ran past the end of their page */
+	uint32_t sector_erases[NOR_SECTORS];
+} nor_stats_t;
+
+extern nor_stats_t nor_stats;
+
+void nor_init();						/* blank chip, everything erased */
+void nor_stats_reset();
+s32_t nor_read(u32_t addr, u32_t size, u8_t *dst);
+s32_t nor_write(u32_t addr, u32_t size, u8_t *src);
+s32_t nor_erase(u32_t addr, u32_t size);
+s32_t nor_program(u32_t addr, u32_t size, const u8_t *src);	/* one Page Program command, size <= NOR_PAGE_SIZE */
+
+#endif /* HOST_SIM_NOR_MODEL_H_ */
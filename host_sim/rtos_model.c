@@ -0,0 +1,172 @@
+/*
+ * rtos_model.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sys_common.h"
+#include "rtos_model.h"
+#include "rtos_semphr.h"
+#include "system.h"
+
+struct sim_mutex {
+	bool held;						/* taken, or empty for a binary semaphore */
+	bool binary;
+};
+
+struct sim_queue {
+	UBaseType_t length;
+	UBaseType_t item_size;
+	UBaseType_t head;
+	UBaseType_t count;
+	uint8_t *items;
+};
+
+#define SIM_MAX_TASKS	8
+
+uint64_t sim_time_ns;
+void (*sim_block_hook)(TaskHandle_t task);
+void (*sim_receive_hook)(QueueHandle_t q, const void *item);
+void (*sim_give_hook)(SemaphoreHandle_t sem);
+
+static TaskHandle_t current_task;
+static struct {
+	TaskHandle_t task;
+	uint32_t count;
+} notifications[SIM_MAX_TASKS];
+
+/* Private functions */
+static uint32_t *notification(TaskHandle_t task);
+
+void sim_advance_ns(uint64_t ns) {
+	sim_time_ns += ns;
+}
+
+void sim_set_task(TaskHandle_t task) {
+	current_task = task;
+}
+
+TickType_t xTaskGetTickCount(void) {
+	return (TickType_t)(sim_time_ns / (1000000ULL * portTICK_PERIOD_MS));
+}
+
+BaseType_t getRunTimeCounterValue(void) {
+	return (BaseType_t)(uint32_t)(sim_time_ns * (uint64_t)GCLK_FREQ / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	return current_task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+	sim_advance_ns((uint64_t)ticks * portTICK_PERIOD_MS * 1000000);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+	uint32_t *n = notification(current_task);
+	uint32_t count;
+
+	if (*n == 0 && wait > 0 && sim_block_hook != NULL) {
+		sim_block_hook(current_task);
+	}
+	count = *n;
+	if (count > 0) {
+		*n = clear ? 0 : count - 1;
+	}
+	return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+	(*notification(task))++;
+	return pdPASS;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+	return 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+	return calloc(1, sizeof(struct sim_mutex));
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+	SemaphoreHandle_t sem = calloc(1, sizeof(struct sim_mutex));
+
+	sem->held = true;
+	sem->binary = true;
+	return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait) {
+	if (sem != NULL && sem->binary && sem->held && wait > 0 && sim_block_hook != NULL) {
+		sim_block_hook(current_task);
+	}
+	if (sem == NULL || sem->held) {
+		return pdFALSE;
+	}
+	sem->held = true;
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+	if (sem == NULL || !sem->held) {
+		return pdFALSE;
+	}
+	sem->held = false;
+	if (sim_give_hook != NULL) {
+		sim_give_hook(sem);
+	}
+	return pdTRUE;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+	QueueHandle_t q = calloc(1, sizeof(struct sim_queue));
+
+	q->length = length;
+	q->item_size = item_size;
+	q->items = calloc(length, item_size);
+	return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+	if (q->count == q->length) {
+		return errQUEUE_FULL;
+	}
+	memcpy(&q->items[((q->head + q->count) % q->length) * q->item_size], item, q->item_size);
+	q->count++;
+	return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *buf, TickType_t wait) {
+	if (q->count == 0) {
+		return pdFAIL;
+	}
+	memcpy(buf, &q->items[q->head * q->item_size], q->item_size);
+	q->head = (q->head + 1) % q->length;
+	q->count--;
+	if (sim_receive_hook != NULL) {
+		sim_receive_hook(q, buf);
+	}
+	return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+	return q->count;
+}
+
+static uint32_t *notification(TaskHandle_t task) {
+	uint8_t i;
+
+	for (i = 0; i < SIM_MAX_TASKS; i++) {
+		if (notifications[i].task == task || notifications[i].task == NULL) {
+			notifications[i].task = task;
+			return &notifications[i].count;
+		}
+	}
+	fprintf(stderr, "rtos_model: more than %d tasks\n", SIM_MAX_TASKS);
+	exit(1);
+}
@@ -0,0 +1,36 @@
+/*
+ * rtos_model.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Single threaded stand-in for the FreeRTOS calls the filesystem makes (include/rtos_*.h).
+ *
+ *      There's no scheduler. The harness plays every task itself, one call at a time, and says which one it's
+ *      playing with sim_set_task() so xTaskGetCurrentTaskHandle() sees the right handle. Time only moves when
+ *      somebody moves it: the harness while nothing's running, the flash model for every transaction and busy wait,
+ *      vTaskDelay for its whole delay. The tick count is sim_time_ns in 1 ms ticks.
+ *
+ *      A task that blocks on a notification or a binary semaphore (fs_service_call) can't be woken by anyone else, so
+ *      ulTaskNotifyTake and xSemaphoreTake call sim_block_hook first. The harness runs whatever would have run in the
+ *      meantime there. sim_give_hook is the other way round: a task that was waiting for the mutex or semaphore just
+ *      given would run now, ahead of the one that gave it.
+ */
+
+#ifndef HOST_SIM_RTOS_MODEL_H_
+#define HOST_SIM_RTOS_MODEL_H_
+
+#include "FreeRTOS.h"
+#include "rtos_task.h"
+#include "rtos_queue.h"
+#include "rtos_semphr.h"
+
+extern uint64_t sim_time_ns;
+extern void (*sim_block_hook)(TaskHandle_t task);
+extern void (*sim_receive_hook)(QueueHandle_t q, const void *item);	/* every item xQueueReceive hands out */
+extern void (*sim_give_hook)(SemaphoreHandle_t sem);					/* every successful xSemaphoreGive */
+
+void sim_advance_ns(uint64_t ns);
+void sim_set_task(TaskHandle_t task);
+
+#endif /* HOST_SIM_RTOS_MODEL_H_ */
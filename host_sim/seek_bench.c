@@ -0,0 +1,172 @@
+/*
+ * seek_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *      Seek + read latency of range reads (sfu_read_range) at different offsets of a full log, with and without the
+ *      service's index maps (fs_service_ix_maps).
+ *
+ *      Same firmware and flash model as fs_bench. Starts the filesystem on a blank chip and fills every subsystem log
+ *      with a lap of circular log data, 24 bytes at a time in turn like the telemetry does, so the log's pages are
+ *      spread over the whole partition. Then reads 64 bytes at random offsets of the system log, the way a downlink
+ *      resuming at an offset or a range query does, and reports the time and the HAL reads per read for each eighth of
+ *      the file. "open" is the first read, which opens the file (and maps it). With run > 1 the reads come in runs of
+ *      that many consecutive reads from each random offset, like a dump.
+ *
+ *      Without a map every seek to a different index page scans the lookup pages of every block up to the one the
+ *      index page is in, so how long it takes depends on where GC last put that page. The map is a window over one
+ *      index page's data pages (FS_SERVICE_MAP_PAGES): a seek inside it costs nothing and a read is the data page,
+ *      one outside it moves the window, which is about one unmapped seek. Both runs read the same offsets, and print a
+ *      CRC of everything they read.
+ *
+ *      usage: seek_bench [reads] [run]		(default 2000 reads, runs of 1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_semphr.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+#include "obc_spiffs.h"
+#include "obc_fs_structure.h"
+#include "obc_fs_service.h"
+#include "obc_fs_appender.h"
+#include "obc_utils.h"
+#include "nor_model.h"
+#include "rtos_model.h"
+
+#define ENTRY_SIZE		24		/* a typical telemetry record */
+#define READ_SIZE		64
+#define BUCKETS			8		/* eighths of the file */
+
+typedef struct bucket {
+	uint32_t reads;
+	uint64_t ns;
+	uint64_t max_ns;
+	uint64_t hal_reads;
+} bucket_t;
+
+static int service_task;
+
+/* Private functions */
+static void fill_logs();
+static void run(bool maps, uint32_t reads, uint32_t run_len, uint32_t size);
+static void print_bucket(const char *name, const bucket_t *b);
+
+int main(int argc, char **argv) {
+	uint32_t reads = (argc > 1) ? atoi(argv[1]) : 2000;
+	uint32_t run_len = (argc > 2) ? atoi(argv[2]) : 1;
+	uint8_t buf[READ_SIZE];
+	uint32_t size;
+
+	nor_init();
+	fs_service_init();
+	sim_set_task(&service_task);
+	fs_service_start(); /* the service handles our reads directly */
+	sfu_fs_start();
+
+	fill_logs();
+	if (sfu_read_range(getCurrentPrefix(), FSYS_SYS, 0, buf, sizeof(buf), &size) < 0) {
+		fprintf(stderr, "read: %d\n", SPIFFS_errno(&fs));
+		return 1;
+	}
+	printf("log %c%c: %u B, %u data pages, map of %u pages per reader; partition %u blocks, %u pages deleted\n",
+			getCurrentPrefix(), FSYS_SYS, size, (uint32_t)(size / SPIFFS_DATA_PAGE_SIZE(&fs)), (uint32_t)FS_SERVICE_MAP_PAGES,
+			fs.block_count, fs.stats_p_deleted);
+
+	run(false, reads, run_len, size);
+	run(true, reads, run_len, size);
+	return 0;
+}
+
+/* fill_logs
+ * 	- a lap of every log, round robin, then everything staged written out
+ */
+static void fill_logs() {
+	uint8_t entry[ENTRY_SIZE];
+	uint32_t written;
+	uint8_t i;
+
+	xSemaphoreTake(spiffsTopMutex, portMAX_DELAY);
+	for (written = 0; written < FS_CIRC_DATA_SIZE; written += ENTRY_SIZE) {
+		for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+			memset(entry, (uint8_t)(written / ENTRY_SIZE), sizeof(entry));
+			fs_appender_write_noMutex(FSYS_OFFSET + i, entry, sizeof(entry));
+		}
+	}
+	fs_appender_flush_all_noMutex(0);
+	xSemaphoreGive(spiffsTopMutex);
+}
+
+static void run(bool maps, uint32_t reads, uint32_t run_len, uint32_t size) {
+	bucket_t buckets[BUCKETS];
+	bucket_t open;
+	bucket_t all;
+	uint8_t buf[READ_SIZE];
+	uint32_t offset = 0;
+	uint64_t start_ns;
+	uint32_t start_reads;
+	uint16_t crc = 0xFFFF;
+	uint64_t ns;
+	bucket_t *b;
+	uint32_t i;
+
+	memset(buckets, 0, sizeof(buckets));
+	memset(&open, 0, sizeof(open));
+	memset(&all, 0, sizeof(all));
+	srand(1);
+	fs_service_ix_maps = maps;
+	xSemaphoreTake(spiffsTopMutex, portMAX_DELAY);
+	fs_service_close_reader_noMutex();
+	xSemaphoreGive(spiffsTopMutex);
+
+	for (i = 0; i <= reads; i++) {
+		if (i > 0 && ((i - 1) % run_len == 0 || offset + 2 * READ_SIZE > size)) {
+			offset = (uint32_t)rand() % (size - READ_SIZE);
+		} else if (i > 0) {
+			offset += READ_SIZE;
+		}
+		start_ns = sim_time_ns;
+		start_reads = spiffs_hal_stats.reads;
+		if (sfu_read_range(getCurrentPrefix(), FSYS_SYS, offset, buf, sizeof(buf), NULL) != READ_SIZE) {
+			fprintf(stderr, "read at %u: %d\n", offset, SPIFFS_errno(&fs));
+			exit(1);
+		}
+		ns = sim_time_ns - start_ns;
+		crc = crc16_ccitt(buf, sizeof(buf), crc);
+		b = (i == 0) ? &open : &buckets[(uint64_t)offset * BUCKETS / size];
+		b->reads++;
+		b->ns += ns;
+		b->max_ns = (ns > b->max_ns) ? ns : b->max_ns;
+		b->hal_reads += spiffs_hal_stats.reads - start_reads;
+		if (i > 0) {
+			all.reads++;
+			all.ns += ns;
+			all.max_ns = (ns > all.max_ns) ? ns : all.max_ns;
+			all.hal_reads += spiffs_hal_stats.reads - start_reads;
+		}
+	}
+
+	printf("\n%s, %u reads of %u B in runs of %u (%u maps moved, %u failed), data crc %04X:\n",
+			maps ? "index maps" : "no index maps", reads, READ_SIZE, run_len, fs_service_stats.map_moves,
+			fs_service_stats.map_fails, crc);
+	print_bucket("open", &open);
+	for (i = 0; i < BUCKETS; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "%u/%u", i, BUCKETS);
+		print_bucket(name, &buckets[i]);
+	}
+	print_bucket("all", &all);
+}
+
+static void print_bucket(const char *name, const bucket_t *b) {
+	if (b->reads == 0) {
+		return;
+	}
+	printf("  %-5s %6u reads, mean %8.2f ms, max %8.2f ms, %6.1f HAL reads/read\n", name, b->reads,
+			b->ns / 1e6 / b->reads, b->max_ns / 1e6, (double)b->hal_reads / b->reads);
+}
@@ -0,0 +1,159 @@
+/*
+ * state_lane_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *      A flag commit while the GC task is collecting the logs (the state lane, obc_fs_service.h).
+ *
+ *      Writes a file of a few logs blocks and deletes it, then plays the GC task through a SPIFFS_gc_quick of the logs
+ *      with spiffsTopMutex held, like fs_gc_step. When the HAL lets go of spiffsHALMutex after the first sector erase,
+ *      the tasks that were waiting run (sim_give_hook): one changes a flag, another reads the flag table back, and the
+ *      service serves them. Both have to be done there, with the GC still holding spiffsTopMutex, not after it.
+ *
+ *      usage: state_lane_test		(exits non-zero on the first failure)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_task.h"
+#include "rtos_semphr.h"
+#include "spiffs.h"
+#include "obc_spiffs.h"
+#include "obc_fs_structure.h"
+#include "obc_fs_service.h"
+#include "obc_flags.h"
+#include "obc_flag_store.h"
+#include "nor_model.h"
+#include "rtos_model.h"
+
+#define FILL_BYTES		(3 * SPIFFS_LOGS_BLOCK_SIZE)
+#define PERIOD			4321
+
+extern SemaphoreHandle_t spiffsHALMutex;	/* obc_spiffs.c, only the HAL takes it */
+
+static int service_task;
+static int gc_task;
+static int flag_task;
+
+static uint32_t failures;
+static bool in_gc;
+static bool served;
+static uint32_t gc_erases;					/* spiffs_hal_stats.erases when the GC started */
+static struct {
+	uint32_t erases;						/* sector erases the GC had done by then */
+	uint32_t commits;						/* flag store records written */
+	s32_t read;								/* readAllFlagsFromFlash() */
+	uint32_t period;						/* what it read */
+	bool logs_held;
+	double ms;
+} seen;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; } } while (0)
+
+/* run_service
+ * 	- the flag task is waiting for the service (fs_service_call), which would run now
+ */
+static void run_service(TaskHandle_t task) {
+	sim_set_task(&service_task);
+	fs_service_step(0);
+	sim_set_task(task);
+}
+
+/* on_give
+ * 	- the first time the GC's HAL call lets go of spiffsHALMutex after an erase, the other tasks get their turn
+ */
+static void on_give(SemaphoreHandle_t sem) {
+	flag_memory_table_wrap_t wrap;
+	uint32_t writes = flag_store_stats.writes;
+
+	if (!in_gc || served || sem != spiffsHALMutex || spiffs_hal_stats.erases == gc_erases) {
+		return;
+	}
+	served = true;
+	seen.erases = spiffs_hal_stats.erases - gc_erases;
+
+	sim_set_task(&flag_task);
+	FLAG_SET(GEN_TELEM, period, PERIOD);	/* posts FS_REQ_FLAGS */
+	run_service(&flag_task);
+	seen.commits = flag_store_stats.writes - writes;
+
+	memset(&wrap, 0, sizeof(wrap));
+	sim_block_hook = run_service;
+	seen.read = readAllFlagsFromFlash(&wrap);
+	sim_block_hook = NULL;
+	seen.period = wrap.flagTable.GEN_TELEM.payload.period;
+	seen.logs_held = (xSemaphoreTake(spiffsTopMutex, 0) != pdTRUE);
+	seen.ms = sim_time_ns / 1e6;
+	sim_set_task(&gc_task);
+}
+
+int main() {
+	static uint8_t buf[1024];
+	flag_memory_table_t stored;
+	spiffs_file fd;
+	uint32_t i;
+	s32_t res;
+	double start_ms;
+
+	nor_init();
+	fs_service_init();
+	sim_set_task(&service_task);
+	fs_service_start();
+	sfu_fs_start();
+	fs_service_step(0);
+
+	/* a file that fills whole blocks, then all of its pages deleted: SPIFFS_gc_quick erases a block of them */
+	CHECK(xSemaphoreTake(spiffsTopMutex, 0) == pdTRUE);
+	memset(buf, 0x5A, sizeof(buf));
+	fd = SPIFFS_open(&fs, "zq", SPIFFS_CREAT | SPIFFS_TRUNC | SPIFFS_RDWR, 0);
+	CHECK(fd > 0);
+	for (i = 0; i < FILL_BYTES; i += sizeof(buf)) {
+		CHECK(SPIFFS_write(&fs, fd, buf, sizeof(buf)) == sizeof(buf));
+	}
+	CHECK(SPIFFS_fremove(&fs, fd) == SPIFFS_OK);
+	xSemaphoreGive(spiffsTopMutex);
+
+	/* the GC task's step, forced */
+	sim_give_hook = on_give;
+	sim_set_task(&gc_task);
+	CHECK(xSemaphoreTake(spiffsTopMutex, 0) == pdTRUE);
+	gc_erases = spiffs_hal_stats.erases;
+	start_ms = sim_time_ns / 1e6;
+	in_gc = true;
+	res = SPIFFS_gc_quick(&fs, 0);
+	in_gc = false;
+	xSemaphoreGive(spiffsTopMutex);
+	sim_give_hook = NULL;
+
+	printf("gc: %d, %u sector erases in %.1f ms\n", res, spiffs_hal_stats.erases - gc_erases, sim_time_ns / 1e6 - start_ms);
+	printf("state lane after %u erases, %.1f ms in: %u flag commits, flag table read %d (period %u), logs %s\n",
+			seen.erases, seen.ms - start_ms, seen.commits, seen.read, seen.period, seen.logs_held ? "still held" : "free");
+	CHECK(res == SPIFFS_OK);
+	CHECK(served);
+	CHECK(seen.logs_held);
+	CHECK(seen.erases == 1);
+	CHECK(spiffs_hal_stats.erases - gc_erases == SPIFFS_LOGS_BLOCK_SIZE / SPIFFS_PHYS_ERASE_SIZE);
+	CHECK(seen.commits == 1);
+	CHECK(seen.read == 1);
+	CHECK(seen.period == PERIOD);
+
+	/* the commit is on flash, not just in RAM */
+	sim_set_task(&service_task);
+	CHECK(xSemaphoreTake(spiffsStateMutex, 0) == pdTRUE);
+	memset(&stored, 0, sizeof(stored));
+	CHECK(flag_store_load_noMutex(&stored) > 0);
+	CHECK(stored.GEN_TELEM.payload.period == PERIOD);
+	xSemaphoreGive(spiffsStateMutex);
+	printf("service: %u state requests, %u mutex fails\n", fs_service_stats.state_requests, fs_service_stats.mutex_fails);
+
+	if (failures > 0) {
+		printf("%u failures\n", failures);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
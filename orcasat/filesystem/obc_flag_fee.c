@@ -0,0 +1,107 @@
+/*
+ * obc_flag_fee.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "obc_flag_fee.h"
+#include "obc_flags.h"
+#include "spiffs.h"
+#ifdef FLAG_FEE_ENABLE
+#include "ti_fee.h"
+#endif
+
+flag_fee_stats_t flag_fee_stats;
+
+#ifdef FLAG_FEE_ENABLE
+
+/* Private functions */
+static void wait_idle();
+
+/* flag_fee_init
+ * 	- TI_Fee_Init only starts the driver. It finds the active virtual sector (and finishes any copy a reset interrupted)
+ * 	  in TI_Fee_MainFunction, so run that until it's done
+ */
+void flag_fee_init() {
+	TI_Fee_Init();
+	wait_idle();
+}
+
+/* flag_fee_load
+ * 	- reads each FEE flag into a scratch copy first. A flag that was never written (or can't be read) keeps whatever
+ * 	  table had, and its bit isn't in the result
+ */
+uint32_t flag_fee_load(flag_memory_table_t *table) {
+	uint8_t buf[FLAG_TABLE_SIZE];
+	uint32_t found = 0;
+	TI_FeeJobResultType job;
+	Std_ReturnType res;
+	uint8_t i;
+
+	for (i = 0; i < NUM_FLAGS; i++) {
+		if (!(FLAG_FEE_MASK & ((uint32_t)1 << i))) continue;
+
+		flag_fee_stats.reads++;
+		res = TI_Fee_ReadSync(FLAG_FEE_BLOCK(i), 0, buf, flagSize[i]);
+		job = TI_Fee_GetJobResult(FLAG_FEE_EEP);
+		if (res != E_OK || job != JOB_OK) {
+			flag_fee_stats.read_fails++;
+			flag_fee_stats.last_result = job;
+			continue;
+		}
+		memcpy((uint8_t *)table + flagOffset[i], buf, flagSize[i]);
+		found |= (uint32_t)1 << i;
+	}
+	return found;
+}
+
+/* flag_fee_commit
+ * 	- TI_Fee_WriteSync programs the block before it returns, but only takes a job when the driver is idle. A write
+ * 	  that fills a virtual sector leaves it copying and erasing in TI_Fee_MainFunction, so wait that out between blocks
+ * 	- if a write fails we keep going with the others, the caller keeps the bits for the next try
+ */
+int32_t flag_fee_commit(const flag_memory_table_t *table, uint32_t dirty) {
+	int32_t ret = 0;
+	Std_ReturnType res;
+	uint8_t i;
+
+	dirty &= FLAG_FEE_MASK;
+	for (i = 0; i < NUM_FLAGS; i++) {
+		if (!(dirty & ((uint32_t)1 << i))) continue;
+
+		flag_fee_stats.writes++;
+		wait_idle();
+		res = TI_Fee_WriteSync(FLAG_FEE_BLOCK(i), (uint8_t *)table + flagOffset[i]);
+		if (res != E_OK || TI_Fee_GetJobResult(FLAG_FEE_EEP) != JOB_OK) {
+			flag_fee_stats.write_fails++;
+			flag_fee_stats.last_result = TI_Fee_GetJobResult(FLAG_FEE_EEP);
+			ret = SPIFFS_SFU_ERR_FEE;
+		}
+	}
+	wait_idle();
+	return ret;
+}
+
+static void wait_idle() {
+	while (TI_Fee_GetStatus(FLAG_FEE_EEP) != IDLE) {
+		TI_Fee_MainFunction();
+	}
+}
+
+#else /* FLAG_FEE_ENABLE */
+
+/* no FEE in this build: FLAG_FEE_MASK is 0 and every flag is in the flag store */
+void flag_fee_init() {
+}
+
+uint32_t flag_fee_load(flag_memory_table_t *table) {
+	return 0;
+}
+
+int32_t flag_fee_commit(const flag_memory_table_t *table, uint32_t dirty) {
+	return 0;
+}
+
+#endif /* FLAG_FEE_ENABLE */
@@ -0,0 +1,47 @@
+/*
+ * obc_flag_fee.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      FEE backend for flag_memory_table: flags with FLAG_FEE in FLAG_TABLE are kept in the TMS570's on-chip EEPROM
+ *      emulation instead of the flag store on the external flash.
+ *
+ *      Everything in the flag store needs the MibSPI flash up and SPIFFS mounted (a scan of the whole chip) before the
+ *      first flag can be read. The flags startup needs (PREFIX_FLAG, RESET_FLAG) can be read from FEE as soon as
+ *      flagInit() runs, with nothing on the SPI bus.
+ *
+ *      Each FEE flag is its own FEE block, numbered FLAG_FEE_BLOCK(flag), holding the whole *_Wrap_t. FEE keeps its
+ *      own copies and checks, a write that's cut short leaves the previous value readable. The blocks have to be set up
+ *      in HALCoGen (FEE tab) with the sizes from flagSize[], then FLAG_FEE_ENABLE turned on in obc_flags.h.
+ *
+ *      The SPIFFS flag store still gets full copies of the table, but the FEE copy of a FEE flag always wins
+ *      (flagMergeStored).
+ *
+ *      host_sim has a RAM stand-in for the TI FEE API (fee_model.c), for testing this without the target.
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FLAG_FEE_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FLAG_FEE_H_
+
+#include "sys_common.h"
+#include "obc_flags.h"
+
+#define FLAG_FEE_BLOCK(idx)		((uint16_t)((idx) + 1))		/* FEE block numbers start at 1 */
+#define FLAG_FEE_EEP			0							/* the FEE instance we use */
+
+typedef struct flag_fee_stats {
+	uint32_t reads;
+	uint32_t read_fails;				/* blank or inconsistent blocks, and driver errors */
+	uint32_t writes;
+	uint32_t write_fails;
+	uint32_t last_result;				/* TI_FeeJobResultType of the last failed job */
+} flag_fee_stats_t;
+
+extern flag_fee_stats_t flag_fee_stats;
+
+void flag_fee_init();												/* brings up the FEE driver, blocks until it's idle */
+uint32_t flag_fee_load(flag_memory_table_t *table);					/* FEE flags into table. Returns the bits of the flags it found */
+int32_t flag_fee_commit(const flag_memory_table_t *table, uint32_t dirty);	/* writes the FEE flags in dirty. SPIFFS_SFU_ERR_FEE on failure */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FLAG_FEE_H_ */
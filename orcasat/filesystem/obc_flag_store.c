@@ -0,0 +1,302 @@
+/*
+ * obc_flag_store.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "obc_flag_store.h"
+#include "obc_spiffs.h"
+#include "obc_utils.h"
+#include "spiffs.h"
+
+flag_store_stats_t flag_store_stats;
+
+static uint8_t journal[FLAG_STORE_FILE_MAX];	/* the whole flag file, read in one go */
+static bool needs_compaction;					/* journal has a bad tail, next write starts a fresh one */
+
+typedef char flag_record_size_check[(FLAG_DELTA_MAX_SIZE <= 255) ? 1 : -1];	/* record size is a uint8_t */
+
+/* Private functions */
+static s32_t read_journal_noMutex(const char *name, flag_memory_table_t *table);
+static bool apply_delta(flag_memory_table_t *table, const uint8_t *data, uint8_t size);
+static uint8_t build_delta(const flag_memory_table_t *table, uint32_t dirty, uint8_t *out);
+static void finish_compaction_noMutex();
+static s32_t compact_noMutex(const flag_memory_table_t *table);
+static s32_t write_record_noMutex(spiffs_file fd, uint32_t seq, uint8_t type, const uint8_t *data, uint8_t size);
+static uint16_t record_crc(const flag_record_header_t *h, const uint8_t *data);
+
+/* flag_store_load_noMutex
+ * 	- loads the newest valid copy of the flag table into table. Leaves table alone if there isn't one
+ * 	- returns the number of valid records in the journal, SPIFFS_SFU_ERR_NO_FLAGS if none, < 0 on SPIFFS errors
+ */
+s32_t flag_store_load_noMutex(flag_memory_table_t *table) {
+	// CALL WITHIN MUTEX
+	s32_t res;
+
+	my_spiffs_mount_state();
+	finish_compaction_noMutex();
+
+	res = read_journal_noMutex(FLAG_STORE_NAME, table);
+	if (res == SPIFFS_ERR_NOT_FOUND) {
+		flag_store_stats.records = 0;
+		flag_store_stats.file_size = 0;
+		needs_compaction = false;
+		return SPIFFS_SFU_ERR_NO_FLAGS;
+	}
+	if (res < 0) {
+		return res;
+	}
+	return (res > 0) ? res : SPIFFS_SFU_ERR_NO_FLAGS;
+}
+
+/* flag_store_write_noMutex
+ * 	- appends a full copy of table to the journal
+ */
+s32_t flag_store_write_noMutex(const flag_memory_table_t *table) {
+	// CALL WITHIN MUTEX
+	return flag_store_commit_noMutex(table, (uint32_t)((1ULL << NUM_FLAGS) - 1));
+}
+
+/* flag_store_commit_noMutex
+ * 	- appends the flags that have their bit set in dirty, as one delta record
+ * 	- a journal that's new (or about to be compacted) gets a full copy instead, and so does a delta that wouldn't be
+ * 	  smaller than one
+ * 	- the write isn't read back. A torn record fails its CRC on the next load and the state before it is used
+ */
+s32_t flag_store_commit_noMutex(const flag_memory_table_t *table, uint32_t dirty) {
+	// CALL WITHIN MUTEX
+	uint8_t delta[FLAG_DELTA_MAX_SIZE];
+	const uint8_t *data = delta;
+	uint8_t type = FLAG_REC_DELTA;
+	uint8_t size;
+	spiffs_file fd;
+	s32_t res;
+
+	if (dirty == 0) {
+		return 0;
+	}
+	my_spiffs_mount_state();
+
+	size = build_delta(table, dirty, delta);
+	if (flag_store_stats.records == 0 || size >= FLAG_TABLE_SIZE) {
+		type = FLAG_REC_FULL;
+		data = (const uint8_t *)table;
+		size = FLAG_TABLE_SIZE;
+	}
+	if (needs_compaction || flag_store_stats.file_size + sizeof(flag_record_header_t) + size > FLAG_STORE_FILE_MAX) {
+		return compact_noMutex(table);
+	}
+
+	fd = SPIFFS_open(&fs_state, FLAG_STORE_NAME, SPIFFS_CREAT | SPIFFS_APPEND | SPIFFS_WRONLY, 0);
+	if (fd < 0) {
+		return SPIFFS_errno(&fs_state);
+	}
+	res = write_record_noMutex(fd, flag_store_stats.seq + 1, type, data, size);
+	SPIFFS_close(&fs_state, fd);
+	if (res < 0) {
+		needs_compaction = true; /* part of it may be on flash, don't append after it */
+		return res;
+	}
+
+	flag_store_stats.seq++;
+	flag_store_stats.records++;
+	flag_store_stats.file_size += sizeof(flag_record_header_t) + size;
+	flag_store_stats.writes++;
+	if (type == FLAG_REC_DELTA) {
+		flag_store_stats.delta_writes++;
+	}
+	return 0;
+}
+
+/* read_journal_noMutex
+ * 	- reads the journal in name and replays its records. The state after the last valid one ends up in table
+ * 	- stops at the first bad record. Since we only append, anything after it came from the same torn write
+ * 	- returns the number of valid records or < 0 on errors
+ */
+static s32_t read_journal_noMutex(const char *name, flag_memory_table_t *table) {
+	// CALL WITHIN MUTEX
+	flag_memory_table_t state;
+	flag_record_header_t h;
+	const uint8_t *data;
+	spiffs_file fd;
+	spiffs_stat s;
+	uint32_t offset = 0;
+	uint32_t len;
+	s32_t count = 0;
+	s32_t res;
+
+	fd = SPIFFS_open(&fs_state, name, SPIFFS_RDONLY, 0);
+	if (fd < 0) {
+		return SPIFFS_errno(&fs_state);
+	}
+	res = SPIFFS_fstat(&fs_state, fd, &s);
+	if (res >= 0) {
+		len = (s.size < sizeof(journal)) ? s.size : sizeof(journal);
+		res = (len > 0) ? SPIFFS_read(&fs_state, fd, journal, len) : 0;
+	}
+	SPIFFS_close(&fs_state, fd);
+	if (res < 0) {
+		return SPIFFS_errno(&fs_state);
+	}
+
+	while (offset + sizeof(h) <= len) {
+		memcpy(&h, &journal[offset], sizeof(h));
+		data = &journal[offset + sizeof(h)];
+		if (h.magic != FLAG_STORE_MAGIC || offset + sizeof(h) + h.size > len
+				|| record_crc(&h, data) != h.crc
+				|| (count > 0 && h.seq != flag_store_stats.seq + 1)) {
+			break;
+		}
+		if (h.type == FLAG_REC_FULL && h.size == FLAG_TABLE_SIZE) {
+			memcpy(&state, data, FLAG_TABLE_SIZE);
+		} else if (!(h.type == FLAG_REC_DELTA && count > 0 && apply_delta(&state, data, h.size))) {
+			break; /* written by firmware with a different FLAG_TABLE */
+		}
+		flag_store_stats.seq = h.seq;
+		offset += sizeof(h) + h.size;
+		count++;
+	}
+	if (count > 0) {
+		memcpy(table, &state, FLAG_TABLE_SIZE);
+	}
+
+	flag_store_stats.records = count;
+	flag_store_stats.file_size = s.size;
+	needs_compaction = (offset != s.size);
+	if (needs_compaction) {
+		flag_store_stats.bad_tails++;
+	}
+	return count;
+}
+
+/* apply_delta
+ * 	- returns false if a range doesn't fit in the table
+ */
+static bool apply_delta(flag_memory_table_t *table, const uint8_t *data, uint8_t size) {
+	uint32_t pos = 0;
+	uint32_t offset;
+	uint8_t len;
+
+	while (pos < size) {
+		if (pos + FLAG_DELTA_RANGE_HEADER > size) {
+			return false;
+		}
+		offset = ((uint32_t)data[pos] << 8) | data[pos + 1];
+		len = data[pos + 2];
+		pos += FLAG_DELTA_RANGE_HEADER;
+		if (offset + len > FLAG_TABLE_SIZE || pos + len > size) {
+			return false;
+		}
+		memcpy((uint8_t *)table + offset, &data[pos], len);
+		pos += len;
+	}
+	return true;
+}
+
+/* build_delta
+ * 	- one range per dirty flag, covering its whole *_Wrap_t (the timestamp goes with the value)
+ * 	- returns the size of the record data
+ */
+static uint8_t build_delta(const flag_memory_table_t *table, uint32_t dirty, uint8_t *out) {
+	uint8_t len = 0;
+	uint8_t i;
+
+	for (i = 0; i < NUM_FLAGS; i++) {
+		if (dirty & ((uint32_t)1 << i)) {
+			out[len++] = (uint8_t)(flagOffset[i] >> 8);
+			out[len++] = (uint8_t)flagOffset[i];
+			out[len++] = flagSize[i];
+			memcpy(&out[len], (const uint8_t *)table + flagOffset[i], flagSize[i]);
+			len += flagSize[i];
+		}
+	}
+	return len;
+}
+
+/* finish_compaction_noMutex
+ * 	- if we reset during a compaction the new journal is still around under FLAG_STORE_NEXT_NAME
+ * 	- it only ever holds one complete record once the old journal is gone, so if it's valid it replaces the old one
+ */
+static void finish_compaction_noMutex() {
+	// CALL WITHIN MUTEX
+	flag_memory_table_t scratch;
+	s32_t res;
+
+	res = read_journal_noMutex(FLAG_STORE_NEXT_NAME, &scratch);
+	if (res == SPIFFS_ERR_NOT_FOUND) {
+		return;
+	}
+	if (res > 0) {
+		SPIFFS_remove(&fs_state, FLAG_STORE_NAME);
+		SPIFFS_rename(&fs_state, FLAG_STORE_NEXT_NAME, FLAG_STORE_NAME);
+	} else {
+		SPIFFS_remove(&fs_state, FLAG_STORE_NEXT_NAME); /* torn, the old journal is still good */
+	}
+}
+
+/* compact_noMutex
+ * 	- starts a new journal with a copy of table and swaps it in for the old one
+ */
+static s32_t compact_noMutex(const flag_memory_table_t *table) {
+	// CALL WITHIN MUTEX
+	spiffs_file fd;
+	s32_t res;
+
+	fd = SPIFFS_open(&fs_state, FLAG_STORE_NEXT_NAME, SPIFFS_CREAT | SPIFFS_TRUNC | SPIFFS_WRONLY, 0);
+	if (fd < 0) {
+		return SPIFFS_errno(&fs_state);
+	}
+	res = write_record_noMutex(fd, flag_store_stats.seq + 1, FLAG_REC_FULL, (const uint8_t *)table, FLAG_TABLE_SIZE);
+	SPIFFS_close(&fs_state, fd);
+	if (res < 0) {
+		SPIFFS_remove(&fs_state, FLAG_STORE_NEXT_NAME);
+		return res;
+	}
+
+	/* the new copy is safe, from here on a reset is picked up by finish_compaction_noMutex */
+	if (SPIFFS_remove(&fs_state, FLAG_STORE_NAME) < 0 && SPIFFS_errno(&fs_state) != SPIFFS_ERR_NOT_FOUND) {
+		return SPIFFS_errno(&fs_state);
+	}
+	if (SPIFFS_rename(&fs_state, FLAG_STORE_NEXT_NAME, FLAG_STORE_NAME) < 0) {
+		return SPIFFS_errno(&fs_state);
+	}
+
+	flag_store_stats.seq++;
+	flag_store_stats.records = 1;
+	flag_store_stats.file_size = FLAG_RECORD_SIZE;
+	flag_store_stats.writes++;
+	flag_store_stats.compactions++;
+	needs_compaction = false;
+	return 0;
+}
+
+/* write_record_noMutex
+ * 	- header and data go out in one SPIFFS_write
+ */
+static s32_t write_record_noMutex(spiffs_file fd, uint32_t seq, uint8_t type, const uint8_t *data, uint8_t size) {
+	// CALL WITHIN MUTEX
+	uint8_t record[sizeof(flag_record_header_t) + FLAG_DELTA_MAX_SIZE];
+	flag_record_header_t h;
+
+	h.magic = FLAG_STORE_MAGIC;
+	h.type = type;
+	h.size = size;
+	h.seq = seq;
+	h.crc = record_crc(&h, data);
+
+	memcpy(record, &h, sizeof(h));
+	memcpy(&record[sizeof(h)], data, size);
+	if (SPIFFS_write(&fs_state, fd, record, sizeof(h) + size) < 0) {
+		return SPIFFS_errno(&fs_state);
+	}
+	flag_store_stats.bytes_written += sizeof(h) + size;
+	return 0;
+}
+
+static uint16_t record_crc(const flag_record_header_t *h, const uint8_t *data) {
+	flag_record_header_t zeroed = *h;
+	zeroed.crc = 0;
+	return crc16_ccitt(data, h->size, crc16_ccitt((const uint8_t *)&zeroed, sizeof(zeroed), 0xFFFF));
+}
@@ -0,0 +1,83 @@
+/*
+ * obc_flag_store.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Crash consistent storage for flag_memory_table.
+ *
+ *      The flag file used to be the raw table, overwritten in place one flag at a time and read back to check. A reset
+ *      in the middle of that left a mix of old and new bytes that nothing could detect.
+ *
+ *      Now the flag file (FLAG_STORE_NAME) is a journal of records:
+ *      	magic | type | size | seq | crc | data
+ *      seq goes up by one per record, crc is CRC-16/CCITT over the header and the data. Writes only ever append a
+ *      record, so the previous state is untouched while the new one goes out. The current and the previous record are
+ *      our A and B copies: if the newest one is torn, its CRC fails and the load stops at the one before it.
+ *
+ *      A journal starts with a FLAG_REC_FULL record (the whole table). After that, commits of a few flags append
+ *      FLAG_REC_DELTA records that only hold the flags that changed, as (offset, size, bytes) ranges of the table.
+ *      A PREFIX_FLAG change costs 8 bytes of data instead of the whole table. A commit is one record, so all of its
+ *      flags make it or none do.
+ *
+ *      Loading reads the whole file in one SPIFFS_read and replays the valid records. There's no read back after a
+ *      write, the CRC is checked on the next load.
+ *
+ *      Once the next record wouldn't fit in FLAG_STORE_FILE_MAX the journal is compacted: a full copy is written to
+ *      a new file (FLAG_STORE_NEXT_NAME), the old file is removed and the new one renamed over it. If we reset in
+ *      between, the load finds the new file and finishes the job.
+ *
+ *      The journal is on the state partition (fs_state in obc_spiffs.h), so log traffic never GCs or evicts it. The
+ *      _noMutex functions are called with spiffsStateMutex held.
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FLAG_STORE_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FLAG_STORE_H_
+
+#include "sys_common.h"
+#include "spiffs.h"
+#include "obc_flags.h"
+
+#define FLAG_STORE_NAME			"zZ"		/* the flag file (create_filename(FSYS_FLAGS)) */
+#define FLAG_STORE_NEXT_NAME	"zY"		/* compaction target, renamed to FLAG_STORE_NAME */
+#define FLAG_STORE_MAGIC		0xF1A6
+#define FLAG_STORE_MAX_RECORDS	16			/* journal size in full records. Compacted when it's full */
+
+typedef enum flag_record_type {
+	FLAG_REC_FULL = 1,					/* the whole flag_memory_table */
+	FLAG_REC_DELTA = 2					/* ranges of it: offset (2 bytes), size (1 byte), bytes. Repeated */
+} flag_record_type_t;
+
+#pragma pack(push,1)
+typedef struct flag_record_header {
+	uint16_t magic;
+	uint8_t type;						/* flag_record_type_t */
+	uint8_t size;						/* bytes after the header */
+	uint32_t seq;
+	uint16_t crc;						/* over the header with crc = 0, then the data */
+} flag_record_header_t;
+#pragma pack(pop)
+
+#define FLAG_RECORD_SIZE		(sizeof(flag_record_header_t) + FLAG_TABLE_SIZE)
+#define FLAG_DELTA_RANGE_HEADER	3
+#define FLAG_DELTA_MAX_SIZE		(NUM_FLAGS * FLAG_DELTA_RANGE_HEADER + FLAG_TABLE_SIZE)	/* every flag dirty */
+#define FLAG_STORE_FILE_MAX		(FLAG_STORE_MAX_RECORDS * FLAG_RECORD_SIZE)
+
+typedef struct flag_store_stats {
+	uint32_t seq;						/* of the newest record on flash */
+	uint32_t records;					/* in the current journal */
+	uint32_t file_size;
+	uint32_t bad_tails;					/* loads that found a torn or corrupt record at the end of a journal */
+	uint32_t writes;
+	uint32_t delta_writes;				/* writes that only had the changed flags */
+	uint32_t bytes_written;				/* record bytes appended, headers included */
+	uint32_t compactions;
+} flag_store_stats_t;
+
+extern flag_store_stats_t flag_store_stats;
+
+s32_t flag_store_load_noMutex(flag_memory_table_t *table);			/* newest valid copy into table. SPIFFS_SFU_ERR_NO_FLAGS if there isn't one */
+s32_t flag_store_write_noMutex(const flag_memory_table_t *table);	/* append a copy of table */
+s32_t flag_store_commit_noMutex(const flag_memory_table_t *table, uint32_t dirty);	/* append the flags with dirty bits (flag_dirty_bit_t) */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FLAG_STORE_H_ */
@@ -5,13 +5,24 @@
  *      Author: Richard
  */
 #include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_task.h"
 #include "stdtelem.h"
 #include "obc_flags.h"
 #include "obc_rtc.h"
+#include "obc_fs_service.h"
+#include "obc_flag_store.h"
+#include "obc_spiffs.h"
+#include "obc_flag_fee.h"
+#include "obc_dlog.h"
 
 flag_memory_table_t flag_memory_table;
 void * flagPointers[NUM_FLAGS] = {FLAG_TABLE(FLAG_PTR_INIT) };
 const uint8_t flagSize[NUM_FLAGS] = {FLAG_TABLE(FLAG_SIZE_CHECK)};
+const uint32_t flagOffset[NUM_FLAGS] = {FLAG_TABLE(FLAG_OFFSET_INIT)};
+
+static volatile uint32_t flags_dirty;	/* flag_dirty_bit_t */
+static volatile bool flags_posted;		/* an FS_REQ_FLAGS is queued and hasn't been handled yet */
 
 FLAG_TABLE(FLAG_FLASH_WRITE_DEFINE)
 FLAG_TABLE(FLAG_FLASH_READ_DEFINE)
@@ -30,7 +41,124 @@ void initFlagTable(){
 //	thingy = 43;
 }
 
+/* flagInit
+ * 	- run at boot, before SPIFFS is up. The FEE flags are usable right after it
+ * 	- FEE flags that were never written (new chip, or FEE just turned on) get their defaults written
+ * 	- the rest keep their defaults until the flag store is loaded (flagMergeStored)
+ */
+void flagInit(){
+	uint32_t missing;
+	int32_t res;
+
+	initFlagTable();
+	flag_fee_init();
+	missing = FLAG_FEE_MASK & ~flag_fee_load(&flag_memory_table);
+	if(missing != 0){
+		res = flag_fee_commit(&flag_memory_table, missing);
+		if(res < 0){
+			DLOG_SERIAL("FEww: %d", res);
+		}
+	}
+}
+
+/* flagMergeStored
+ * 	- copies the flags that aren't in FEE out of a table loaded from the flag store
+ * 	- the store's copy of a FEE flag can be older than the FEE one, so it's ignored
+ */
+void flagMergeStored(const flag_memory_table_t *stored){
+	uint8_t i;
+
+	for(i = 0; i < NUM_FLAGS; i++){
+		if(!(FLAG_FEE_MASK & ((uint32_t)1 << i))){
+			memcpy(flagPointers[i], (const uint8_t *)stored + flagOffset[i], flagSize[i]);
+		}
+	}
+}
+
+
+
+/* writeFlagStored
+ * 	- backs the generated write_FLAG_NAME functions
+ * 	- CALL WITHIN spiffsStateMutex
+ */
+void writeFlagStored(uint8_t idx, const uint8_t *wrap){
+	s32_t res;
+
+	if(wrap != flagPointers[idx]){
+		memcpy(flagPointers[idx], wrap, flagSize[idx]);
+	}
+	taskENTER_CRITICAL();
+	flags_dirty |= (uint32_t)1 << idx;
+	taskEXIT_CRITICAL();
+	res = flagCommit_noMutex();
+	if(res < 0){
+		DLOG_SERIAL("FFww: %d", res);
+	}
+}
+
+/* flagMarkDirty
+ * 	- the flag gets written to the flag store by the filesystem service, with whatever value it has by then
+ * 	- marking a flag while a commit request is queued doesn't queue anything else. Bits left over from a failed
+ * 	  commit don't count as queued, so the next mark asks again
+ */
+void flagMarkDirty(uint8_t idx){
+	bool post;
+
+	if(idx >= NUM_FLAGS) return;
+	taskENTER_CRITICAL();
+	flags_dirty |= (uint32_t)1 << idx;
+	post = !flags_posted;
+	flags_posted = true;
+	taskEXIT_CRITICAL();
+
+	if(post && !fs_service_commit_flags()){
+		taskENTER_CRITICAL();
+		flags_posted = false; /* queue full, the next mark (or any batch) picks it up */
+		taskEXIT_CRITICAL();
+	}
+}
+
+/* flagCommit_noMutex
+ * 	- writes the dirty FEE flags to FEE, and the rest to the flag store as one delta record
+ * 	- the table is copied with interrupts off, so we never write half an update
+ * 	- CALL WITHIN spiffsStateMutex
+ */
+int32_t flagCommit_noMutex(){
+	flag_memory_table_t snapshot;
+	uint32_t dirty;
+	uint32_t failed = 0;
+	int32_t fee_res;
+	s32_t res;
+
+	taskENTER_CRITICAL();
+	dirty = flags_dirty;
+	flags_dirty = 0;
+	flags_posted = false;
+	if(dirty != 0){
+		snapshot = flag_memory_table;
+	}
+	taskEXIT_CRITICAL();
+
+	if(dirty == 0) return 0;
+	fee_res = flag_fee_commit(&snapshot, dirty & FLAG_FEE_MASK);
+	if(fee_res < 0){
+		failed |= dirty & FLAG_FEE_MASK;
+	}
+	res = my_spiffs_state_check_error(flag_store_commit_noMutex(&snapshot, dirty & ~FLAG_FEE_MASK));
+	if(res < 0){
+		failed |= dirty & ~FLAG_FEE_MASK;
+	}
+	if(failed != 0){
+		taskENTER_CRITICAL();
+		flags_dirty |= failed; /* try again with the next commit */
+		taskEXIT_CRITICAL();
+	}
+	return (res < 0) ? res : fee_res;
+}
 
+void readFlagStored(uint8_t idx, uint8_t *wrap){
+	memcpy(wrap, flagPointers[idx], flagSize[idx]);
+}
 
 bool ptrWriteFlag(uint8_t idx, uint8_t * data, uint8_t size){
 	if(size != flagSize[idx]) return 0;	/* Check the size so we won't overwrite data */
@@ -53,6 +181,7 @@ bool ptrWriteFlag(uint8_t idx, uint8_t * data, uint8_t size){
 	for(i = sizeof(time_bytes); i < size; i++){
 		*((uint8_t *)pointer + i) = data[i];
 	}
+	flagMarkDirty(idx);	/* persisted by the filesystem service */
 	return 1;
 }
 
@@ -67,25 +67,35 @@ bool writeFlagTest();
 #define PREFIX_FLAG_INITS 	{	.flag = 'a'}
 #define GEN_TELEM_INITS 	{	.max = 700, .min = 0, .period = 10000}
 
+/* Flag backends
+ * 	- FLAG_SPIFFS: the flag store journal on the external flash (obc_flag_store.h)
+ * 	- FLAG_FEE: on-chip EEPROM emulation (obc_flag_fee.h). Read at boot before SPIFFS is mounted, so use it for flags
+ * 	  that startup needs. Only when FLAG_FEE_ENABLE is defined, otherwise they go to SPIFFS too
+ */
+#define FLAG_SPIFFS		0
+#define FLAG_FEE		1
+//#define FLAG_FEE_ENABLE			/* needs the FEE driver enabled in HALCoGen, see obc_flag_fee.h */
+
 /* Flag Table
- * - wrapper type, name, payload type and initializer #define name for a flag
+ * - wrapper type, name, payload type, initializer #define name and backend for a flag
  *
  *	Instructions:
  *		- enter the wrapper type and payload type
  *		- enter the name for the flag
  *		- assuming you've defined an initializer macro above, enter its name in the 4th column
+ *		- enter where the flag is stored in the 5th column. A FLAG_FEE flag needs a FEE block in HALCoGen, see obc_flag_fee.h
  *
  */
-/*				flag wrap type	|	flag type	|	flag name	|	initializer handle 	*/
+/*				flag wrap type	|	flag type	|	flag name	|	initializer handle 	|	backend	*/
 #define FLAG_TABLE(ENTRY)     \
-        ENTRY(flagCharWrap_t, 		flagChar_t, 	RESET_FLAG,  	RESET_FLAG_INITS) \
-        ENTRY(flagCharWrap_t,  		flagChar_t, 	PREFIX_FLAG, 	PREFIX_FLAG_INITS) \
-        ENTRY(telemConfigWrap_t, 	telemConfig_t, 	GEN_TELEM,  	GEN_TELEM_INITS)
+        ENTRY(flagCharWrap_t, 		flagChar_t, 	RESET_FLAG,  	RESET_FLAG_INITS,		FLAG_FEE) \
+        ENTRY(flagCharWrap_t,  		flagChar_t, 	PREFIX_FLAG, 	PREFIX_FLAG_INITS,		FLAG_FEE) \
+        ENTRY(telemConfigWrap_t, 	telemConfig_t, 	GEN_TELEM,  	GEN_TELEM_INITS,		FLAG_SPIFFS)
 
 /* Create the flag table used to determine offset from name
  * 	- members accessed by 'struct_name', are of wrapper type
  * */
-#define EXPAND_AS_STRUCT(wrap_type, payload_type, struct_name, init) wrap_type struct_name;
+#define EXPAND_AS_STRUCT(wrap_type, payload_type, struct_name, init, backend) wrap_type struct_name;
 
 #pragma pack(push,1)
 typedef struct{
@@ -100,27 +110,33 @@ typedef union{
 	uint8_t flagTableBytes[sizeof(flag_memory_table_t)];
 } flag_memory_table_wrap_t;
 
-#define ENUMERATE_FLAGS(wrap_type, payload_type, struct_name, init) struct_name,
-#define INIT_PAYLOAD(wrap_type, payload_type, struct_name, init) flag_memory_table.struct_name.payload = (payload_type) init;
-#define UPDATE_TIMESTAMP(wrap_type, payload_type, struct_name, init) flag_memory_table.struct_name.payload.timestamp = timestamp;
-#define WRITEFLAG_CALL(wrap_type, payload_type, struct_name, init) writeFlag(offsetof(flag_memory_table_t, struct_name), sizeof(wrap_type), flag_memory_table.struct_name.all);
-#define FLAG_SIZE_CHECK(wrap_type, payload_type, struct_name, init) sizeof(flag_memory_table.struct_name.all),
+#define ENUMERATE_FLAGS(wrap_type, payload_type, struct_name, init, backend) struct_name,
+#define INIT_PAYLOAD(wrap_type, payload_type, struct_name, init, backend) flag_memory_table.struct_name.payload = (payload_type) init;
+#define UPDATE_TIMESTAMP(wrap_type, payload_type, struct_name, init, backend) flag_memory_table.struct_name.payload.timestamp = timestamp;
+#define WRITEFLAG_CALL(wrap_type, payload_type, struct_name, init, backend) writeFlag(offsetof(flag_memory_table_t, struct_name), sizeof(wrap_type), flag_memory_table.struct_name.all);
+#define FLAG_SIZE_CHECK(wrap_type, payload_type, struct_name, init, backend) sizeof(flag_memory_table.struct_name.all),
+#define FLAG_OFFSET_INIT(wrap_type, payload_type, struct_name, init, backend) offsetof(flag_memory_table_t, struct_name),
+#define ENUMERATE_FLAG_BITS(wrap_type, payload_type, struct_name, init, backend) struct_name##_BIT = (1UL << struct_name),
+#define FLAG_FEE_BIT(wrap_type, payload_type, struct_name, init, backend) ((backend == FLAG_FEE) ? struct_name##_BIT : 0) |
 
 
 /* --- WRITE AND READ FROM FLASH
  * 	- these functions are generated to write/read a single flag to/from flash
  * 	- their names are write_FLAG_NAME and read_FLAG_NAME
+ * 	- write_ puts the flag in flag_memory_table and commits it to the flag store right away (flagCommit_noMutex). CALL WITHIN spiffsStateMutex
+ * 	- read_ gets the flag from flag_memory_table. That's the newest copy on flash since the store loaded it at boot
+ * 	  and every write since went through it, so there's nothing to read back
  */
-extern void writeFlagRaw(uint8_t *bytes, uint8_t size, uint32_t offset);
-extern void readFlagRaw(uint8_t *bytes, uint8_t size, uint32_t offset);
+void writeFlagStored(uint8_t idx, const uint8_t *wrap);
+void readFlagStored(uint8_t idx, uint8_t *wrap);
 
-#define FLAG_FLASH_WRITE_DECLARE(wrap_type, payload_type, struct_name, init) void write_##struct_name(uint8_t * wrap);
-#define FLAG_FLASH_WRITE_DEFINE(wrap_type, payload_type, struct_name, init) void write_##struct_name(uint8_t * wrap){ \
-         	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 writeFlagRaw(wrap, sizeof(wrap_type), offsetof(flag_memory_table_t, struct_name)); }
+#define FLAG_FLASH_WRITE_DECLARE(wrap_type, payload_type, struct_name, init, backend) void write_##struct_name(uint8_t * wrap);
+#define FLAG_FLASH_WRITE_DEFINE(wrap_type, payload_type, struct_name, init, backend) void write_##struct_name(uint8_t * wrap){ \
+         	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 writeFlagStored(struct_name, wrap); }
 
-#define FLAG_FLASH_READ_DECLARE(wrap_type, payload_type, struct_name, init) void read_##struct_name(uint8_t * wrap);
-#define FLAG_FLASH_READ_DEFINE(wrap_type, payload_type, struct_name, init) void read_##struct_name(uint8_t * wrap){ \
-         	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 readFlagRaw(wrap, sizeof(wrap_type), offsetof(flag_memory_table_t, struct_name)); }
+#define FLAG_FLASH_READ_DECLARE(wrap_type, payload_type, struct_name, init, backend) void read_##struct_name(uint8_t * wrap);
+#define FLAG_FLASH_READ_DEFINE(wrap_type, payload_type, struct_name, init, backend) void read_##struct_name(uint8_t * wrap){ \
+         	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 readFlagStored(struct_name, wrap); }
 /* Declare the functions to write flags to flash */
 FLAG_TABLE(FLAG_FLASH_WRITE_DECLARE)
 
@@ -137,18 +153,51 @@ flag_memory_enum_t flagEnum;
 extern flag_memory_table_t flag_memory_table;
 extern void * flagPointers[NUM_FLAGS];
 extern const uint8_t flagSize[NUM_FLAGS];
+extern const uint32_t flagOffset[NUM_FLAGS];
 
 /* Populate the array of pointers to the byte-arrays of each flag */
-#define FLAG_PTR_INIT(wrap_type, payload_type, struct_name, init) &flag_memory_table.struct_name.all,
+#define FLAG_PTR_INIT(wrap_type, payload_type, struct_name, init, backend) &flag_memory_table.struct_name.all,
+
+/* Dirty bits, one per flag
+ * 	- FLAG_SET() and ptrWriteFlag() set them, flagCommit_noMutex() writes the flags that have them to the flag store
+ * 	  as a delta record: only each changed *_Wrap_t, at its offset in flag_memory_table
+ * 	- a flag that changes several times before the commit is written once, with its latest value
+ * 	- flagMarkDirty() asks the filesystem service to commit, so the setters never wait for the flash
+ */
+typedef enum{
+	FLAG_TABLE(ENUMERATE_FLAG_BITS)
+	FLAG_BITS_END
+} flag_dirty_bit_t;
+
+typedef char flag_bits_fit_check[(NUM_FLAGS <= 32) ? 1 : -1];	/* dirty bits are a uint32_t */
+
+/* Flags that live in FEE rather than the flag store */
+#ifdef FLAG_FEE_ENABLE
+#define FLAG_FEE_MASK	((uint32_t)(FLAG_TABLE(FLAG_FEE_BIT) 0))
+#else
+#define FLAG_FEE_MASK	((uint32_t)0)
+#endif
+
+void flagInit();							/* defaults, then the FEE flags. Doesn't touch SPIFFS */
+void flagMergeStored(const flag_memory_table_t *stored);	/* take the flag store's copy of the flags that aren't in FEE */
+
+void flagMarkDirty(uint8_t idx);
+int32_t flagCommit_noMutex();				/* CALL WITHIN spiffsStateMutex. Returns < 0 on flag store errors, the bits stay set for the next try */
 
-/* Accessor macro
- * 	- use this to easily access a member of a flag
+/* Accessor macros
+ * 	- use these to easily access a member of a flag
+ * 	- FLAG_SET also updates the flag's timestamp and marks it dirty. Setting through FLAG() only changes RAM
  *
  * 	Examples:
  * 		uint32_t thingy;
  *		thingy = FLAG(GEN_TELEM, min);	// get value
- *		FLAG(GEN_TELEM,min) = 23;		// set value
+ *		FLAG_SET(GEN_TELEM, min, 23);	// set value
  */
 #define FLAG(name,value) flag_memory_table.name.payload.value
+#define FLAG_SET(name,value,x) do { \
+		FLAG(name,value) = (x); \
+		FLAG(name,timestamp) = getCurrentRTCTime(); \
+		flagMarkDirty(name); \
+	} while (0)
 
 #endif /* SFUSAT_SFU_FLAGS_H_ */
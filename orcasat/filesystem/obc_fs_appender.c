@@ -0,0 +1,298 @@
+/*
+ * obc_fs_appender.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_task.h"
+#include "obc_fs_appender.h"
+#include "obc_fs_structure.h"
+#include "obc_spiffs.h"
+#include "obc_fs_objects.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+
+fs_appender_stats_t fs_appender_stats;
+
+static fs_appender_t appenders[FSYS_NUM_SUBSYS];
+
+/* Private functions */
+static bool appender_is_open(fs_appender_t *app);
+static void appender_close(fs_appender_t *app);
+static s32_t appender_write_out(fs_appender_t *app);
+
+void fs_appender_init() {
+	uint8_t i;
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		appenders[i].fd = -1;
+		appenders[i].prefix = '\0';
+		appenders[i].mount_generation = 0;
+		appenders[i].size = 0;
+		appenders[i].staged = 0;
+		appenders[i].stage_tick = 0;
+		appenders[i].time_base = 0;
+	}
+}
+
+/* fs_appender_open_noMutex
+ * 	- returns the descriptor of the current log with f_suffix, opening it if we don't have a valid one
+ * 	- extra_flags lets the file set creation pass SPIFFS_CREAT
+ * 	- returns < 0 on error, check SPIFFS_errno
+ */
+spiffs_file fs_appender_open_noMutex(char f_suffix, spiffs_flags extra_flags) {
+	// CALL WITHIN MUTEX
+	fs_appender_t *app = fs_appender_get(f_suffix);
+	char nameBuf[3] = { '\0' };
+	spiffs_stat s;
+#ifdef FSYS_CIRCULAR_LOGS
+	s32_t res;
+#endif
+
+	if (app == NULL) {
+		return SPIFFS_ERR_BAD_DESCRIPTOR;
+	}
+
+	if (appender_is_open(app)) {
+		return app->fd;
+	}
+	appender_close(app); /* stale fd from an old prefix */
+
+	my_spiffs_mount();
+
+	nameBuf[0] = getCurrentPrefix();
+	nameBuf[1] = f_suffix;
+#ifdef FSYS_CIRCULAR_LOGS
+	app->fd = SPIFFS_open(&fs, nameBuf, extra_flags | SPIFFS_RDWR, 0); /* we seek to the head ourselves */
+#else
+	app->fd = SPIFFS_open(&fs, nameBuf, extra_flags | SPIFFS_APPEND | SPIFFS_RDWR, 0);
+#endif
+	if (app->fd >= 0) {
+		app->mount_generation = spiffs_mount_generation;
+		if (SPIFFS_fstat(&fs, app->fd, &s) < 0) {
+			appender_close(app);
+			return SPIFFS_errno(&fs);
+		}
+		/* a different or empty file doesn't have our time base in it */
+		if (app->prefix != nameBuf[0] || (s.size == 0 && app->staged == 0)) {
+			app->time_base = 0;
+		}
+		app->prefix = nameBuf[0];
+		app->size = s.size;
+#ifdef FSYS_CIRCULAR_LOGS
+		res = fs_circ_open_noMutex(app->fd, s.size, &app->circ);
+		if (res < 0) {
+			appender_close(app);
+			return res;
+		}
+		app->size = fs_circ_position(&app->circ);
+		app->time_base = 0; /* the head can be in the middle of a page we don't know the base of */
+#endif
+		fs_objects_track(nameBuf[0], &s);
+	}
+	return app->fd;
+}
+
+/* fs_appender_write_noMutex
+ * 	- stages size bytes for the current log with f_suffix
+ * 	- whenever the staged data reaches the next data page boundary of the file, that page is written out and flushed
+ * 	- on error the descriptor is dropped so the next write reopens the file. The staged data is kept for the retry
+ */
+s32_t fs_appender_write_noMutex(char f_suffix, uint8_t *data, uint32_t size) {
+	// CALL WITHIN MUTEX
+	fs_appender_t *app = fs_appender_get(f_suffix);
+	uint32_t page_end;
+	uint32_t chunk;
+	s32_t res;
+
+	res = fs_appender_open_noMutex(f_suffix, 0);
+	if (res < 0) {
+		return res;
+	}
+
+	fs_appender_stats.bytes += size;
+	while (size > 0) {
+		/* the stage starts at the end of the file, so this is how much it takes to reach the next data page boundary */
+		page_end = SPIFFS_DATA_PAGE_SIZE(&fs) - (app->size % SPIFFS_DATA_PAGE_SIZE(&fs));
+		if (app->staged >= page_end) { /* left over from a failed write out */
+			res = appender_write_out(app);
+			if (res < 0) {
+				return res;
+			}
+			continue;
+		}
+
+		chunk = page_end - app->staged;
+		if (chunk > size) {
+			chunk = size;
+		}
+		if (app->staged == 0) {
+			app->stage_tick = xTaskGetTickCount();
+		}
+		memcpy(&app->stage[app->staged], data, chunk);
+		app->staged += chunk;
+		data += chunk;
+		size -= chunk;
+
+		if (app->staged == page_end) { /* a full page, write it in one go */
+			res = appender_write_out(app);
+			if (res < 0) {
+				return res;
+			}
+		}
+	}
+	return 0;
+}
+
+/* fs_appender_flush_noMutex
+ * 	- writes out whatever is staged for f_suffix, even if it's only part of a page
+ * 	- used before anything reads the current log back, so readers see every entry
+ */
+s32_t fs_appender_flush_noMutex(char f_suffix) {
+	// CALL WITHIN MUTEX
+	fs_appender_t *app = fs_appender_get(f_suffix);
+	s32_t res;
+
+	if (app == NULL) {
+		return SPIFFS_ERR_BAD_DESCRIPTOR;
+	}
+	if (app->staged == 0) {
+		return 0;
+	}
+
+	res = fs_appender_open_noMutex(f_suffix, 0);
+	if (res < 0) {
+		return res;
+	}
+	return appender_write_out(app);
+}
+
+/* fs_appender_pad_noMutex
+ * 	- fills what's left of the current data page with 0xFF and writes the page out, so the next write starts a page
+ * 	- the decoder skips 0xFF like erased flash
+ */
+s32_t fs_appender_pad_noMutex(char f_suffix) {
+	// CALL WITHIN MUTEX
+	fs_appender_t *app = fs_appender_get(f_suffix);
+	uint32_t page_end;
+	uint32_t pad;
+	s32_t res;
+
+	res = fs_appender_open_noMutex(f_suffix, 0);
+	if (res < 0) {
+		return res;
+	}
+
+	page_end = SPIFFS_DATA_PAGE_SIZE(&fs) - (app->size % SPIFFS_DATA_PAGE_SIZE(&fs));
+	if (app->staged >= page_end) { /* already a full page, a write out failed */
+		return appender_write_out(app);
+	}
+	pad = page_end - app->staged;
+	if (app->staged == 0) {
+		app->stage_tick = xTaskGetTickCount();
+	}
+	memset(&app->stage[app->staged], 0xFF, pad);
+	app->staged += pad;
+	res = appender_write_out(app);
+	return (res < 0) ? res : (s32_t)pad;
+}
+
+/* fs_appender_flush_all_noMutex
+ * 	- flushes every appender that has had data staged for at least max_age ticks. max_age of 0 flushes everything
+ * 	- returns the first error hit, but still tries the other appenders
+ */
+s32_t fs_appender_flush_all_noMutex(TickType_t max_age) {
+	// CALL WITHIN MUTEX
+	TickType_t now = xTaskGetTickCount();
+	s32_t res = 0;
+	s32_t err = 0;
+	uint8_t i;
+
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		if (appenders[i].staged > 0 && (now - appenders[i].stage_tick) >= max_age) {
+			res = fs_appender_flush_noMutex((char) (FSYS_OFFSET + i));
+			if (res < 0 && err == 0) {
+				err = res;
+			}
+		}
+	}
+	return err;
+}
+
+/* fs_appender_close_all_noMutex
+ * 	- closes every appender. Used before prefix rotation so the outgoing file set gets its final flush
+ * 	- staged data is not written here. Call fs_appender_flush_all_noMutex(0) first
+ */
+void fs_appender_close_all_noMutex() {
+	// CALL WITHIN MUTEX
+	uint8_t i;
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		appender_close(&appenders[i]);
+	}
+}
+
+fs_appender_t *fs_appender_get(char f_suffix) {
+	if (f_suffix < FSYS_OFFSET || f_suffix >= FSYS_OFFSET + FSYS_NUM_SUBSYS) {
+		return NULL;
+	}
+	return &appenders[f_suffix - FSYS_OFFSET];
+}
+
+/* appender_is_open
+ * 	- an fd is only valid if it was opened for the current prefix and no mount has happened since
+ */
+static bool appender_is_open(fs_appender_t *app) {
+	return app->fd >= 0 && app->prefix == getCurrentPrefix() && app->mount_generation == spiffs_mount_generation;
+}
+
+static void appender_close(fs_appender_t *app) {
+	/* if SPIFFS was remounted the fd table is already wiped. Closing would hit whoever owns that fd number now */
+	if (app->fd >= 0 && app->mount_generation == spiffs_mount_generation) {
+		SPIFFS_close(&fs, app->fd);
+	}
+	app->fd = -1;
+}
+
+/* appender_write_out
+ * 	- writes everything staged to the file and flushes it through the SPIFFS cache
+ * 	- on error the stage is kept so the data goes out on the next attempt
+ */
+static s32_t appender_write_out(fs_appender_t *app) {
+	s32_t res;
+#ifdef FSYS_CIRCULAR_LOGS
+	uint32_t len = fs_circ_page_end(&app->circ, app->size + app->staged) - app->size;
+
+	/* the stage never crosses a page, so the padding fits behind the staged data */
+	memset(&app->stage[app->staged], 0xFF, len - app->staged);
+	res = SPIFFS_lseek(&fs, app->fd, app->size, SPIFFS_SEEK_SET);
+	if (res >= 0) {
+		res = SPIFFS_write(&fs, app->fd, app->stage, len);
+	}
+#else
+	res = SPIFFS_write(&fs, app->fd, app->stage, app->staged);
+#endif
+	if (res >= 0) {
+		res = SPIFFS_fflush(&fs, app->fd);
+	}
+	if (res < 0) {
+		appender_close(app);
+		return res;
+	}
+
+	fs_appender_stats.write_outs++;
+	fs_appender_stats.write_out_bytes += app->staged;
+	app->size += app->staged;
+	app->staged = 0;
+#ifdef FSYS_CIRCULAR_LOGS
+	/* the header only goes out on a wrap. If that fails the next open wraps again */
+	res = fs_circ_advance_noMutex(app->fd, &app->circ, app->size);
+	app->size = fs_circ_position(&app->circ);
+	if (res < 0) {
+		appender_close(app);
+		return res;
+	}
+#endif
+	return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * obc_fs_appender.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Log appenders keep one SPIFFS descriptor open per subsystem log (FSYS_SYS ... FSYS_BMS).
+ *
+ *      Opening a file makes SPIFFS walk the object lookup pages to find the object header by name, and closing it
+ *      flushes and rewrites the header. Doing that for every telemetry sample means most of our flash traffic is
+ *      spent finding files instead of writing data. The appenders open each log once and keep the fd around until:
+ *      	- the prefix changes (sfu_rotate_noMutex() closes them all and sfu_create_log_files_noMutex() reopens the new set)
+ *      	- SPIFFS gets remounted (a mount wipes the fd table, tracked through spiffs_mount_generation)
+ *      	- a write fails, in which case the fd is dropped and reopened on the next write
+ *
+ *      Records are also staged in RAM before they go to SPIFFS. An entry is at most SFU_WRITE_DATA_BUF bytes, so
+ *      writing each one straight through programs a partial data page and rewrites the index page every time.
+ *      Each appender collects entries until the file is at a data page boundary and then writes the full page in one go.
+ *      Staged data is written out when:
+ *      	- it completes a data page
+ *      	- it has been sitting around for FS_APPENDER_STAGE_TIMEOUT (the lifecycle task checks every FSYS_FLUSH_INTERVAL)
+ *      	- someone calls sfu_flush_logs(), which we do before rotating the prefix, before reads of the logs and before resets
+ *      Anything staged is lost on an unexpected reset. Every write out of a partial page costs a page and an index
+ *      page rewrite, so the timeout is about how long a telemetry log takes to fill a page at its normal rate (5 to 10
+ *      minutes). Most pages then go out full, and an unexpected reset loses at most the last 10 minutes of each log.
+ *      Planned resets flush first. fs_bench numbers for other timeouts are in host_sim/README.md.
+ *
+ *      With FSYS_CIRCULAR_LOGS the logs are circular (obc_fs_circular.h): the descriptor isn't opened for appending,
+ *      each page goes out at the log's head, padded to the end of the page after the first lap, and head moves along
+ *      after it. size is then the file offset the stage starts at rather than the file size.
+ *
+ *      ------ !!! ALL FUNCTIONS MUST BE CALLED FROM WITHIN spiffsTopMutex !!! --------------
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_APPENDER_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_APPENDER_H_
+
+#include "FreeRTOS.h"
+#include "spiffs.h"
+#include "obc_fs_structure.h"
+#include "obc_fs_circular.h"
+
+#define FS_APPENDER_STAGE_SIZE		256						/* must be >= SPIFFS_DATA_PAGE_SIZE. LOG_PAGE_SIZE is always enough */
+#ifndef FS_APPENDER_STAGE_TIMEOUT
+#define FS_APPENDER_STAGE_TIMEOUT	pdMS_TO_TICKS(600000)	/* staged data older than this is written out even if the page isn't full */
+#endif
+
+typedef struct fs_appender{
+	spiffs_file fd;				/* open descriptor, -1 when closed */
+	char prefix;				/* file prefix the descriptor was opened for */
+	uint32_t mount_generation;	/* spiffs_mount_generation when the descriptor was opened */
+	uint32_t size;				/* file size on flash, not counting what's staged. Used to find the page boundary. Circular: head */
+	uint16_t staged;			/* bytes waiting in stage */
+	TickType_t stage_tick;		/* tick count when the oldest staged byte came in */
+	uint32_t time_base;			/* RTC time of the last base record in this file (obc_fs_record.h), 0 if there isn't one yet */
+	fs_circ_t circ;				/* header of a circular log */
+	uint8_t stage[FS_APPENDER_STAGE_SIZE];
+} fs_appender_t;
+
+typedef struct fs_appender_stats {
+	uint32_t bytes;				/* handed to fs_appender_write_noMutex */
+	uint32_t write_outs;		/* stages written to SPIFFS, and their bytes (pads included) */
+	uint32_t write_out_bytes;
+} fs_appender_stats_t;
+
+extern fs_appender_stats_t fs_appender_stats;
+
+void fs_appender_init();
+fs_appender_t *fs_appender_get(char f_suffix);									/* NULL for a bad suffix */
+spiffs_file fs_appender_open_noMutex(char f_suffix, spiffs_flags extra_flags);	/* returns the open fd for the suffix, opening it if needed */
+s32_t fs_appender_write_noMutex(char f_suffix, uint8_t *data, uint32_t size);	/* stage data for the current log, writing out full pages */
+s32_t fs_appender_pad_noMutex(char f_suffix);									/* fill the rest of the data page with 0xFF and write it out. Returns the bytes added */
+s32_t fs_appender_flush_noMutex(char f_suffix);									/* write out whatever is staged for the suffix */
+s32_t fs_appender_flush_all_noMutex(TickType_t max_age);						/* write out staged data older than max_age ticks, 0 for everything */
+void fs_appender_close_all_noMutex();
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_APPENDER_H_ */
@@ -0,0 +1,214 @@
+/*
+ * obc_fs_check.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_task.h"
+#include "rtos_semphr.h"
+#include "obc_fs_check.h"
+#include "obc_fs_structure.h"
+#include "obc_spiffs.h"
+#include "obc_utils.h"
+#include "obc_dlog.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+
+fs_check_stats_t fs_check_stats;
+
+static spiffs *const partitions[] = { &fs, &fs_state };
+
+/* where the next step starts */
+static struct {
+	uint8_t part;
+	spiffs_block_ix bix;
+	uint32_t reports;				/* error log entries this pass */
+} progress;
+
+static u8_t lu_buf[LOG_PAGE_SIZE];	/* object lookup page of the block being checked */
+static u8_t ix_buf[LOG_PAGE_SIZE];	/* index page being checked */
+
+/* Private functions */
+static void check_block_noMutex(spiffs *p, spiffs_block_ix bix);
+static s32_t check_page(spiffs_obj_id id, const spiffs_page_header *ph);
+static void check_index_noMutex(spiffs *p, spiffs_page_ix pix, const spiffs_page_header *ph);
+static void read_header(spiffs *p, spiffs_page_ix pix, spiffs_page_header *ph);
+static void report(spiffs_page_ix pix, s32_t err);
+
+/* fs_check_step
+ * 	- never waits for the mutex, like the GC step. If anyone else has it we're not idle
+ * 	- each partition is checked under its own mutex, so a step ends where its partition does
+ */
+bool fs_check_step() {
+	SemaphoreHandle_t mutex = (partitions[progress.part] == &fs_state) ? spiffsStateMutex : spiffsTopMutex;
+	TickType_t start;
+	spiffs *p;
+	uint8_t i;
+
+	if (mutex == NULL || xSemaphoreTake(mutex, 0) != pdTRUE) {
+		return false;
+	}
+	start = xTaskGetTickCount();
+	for (i = 0; i < FS_CHECK_BLOCKS_PER_STEP; i++) {
+		p = partitions[progress.part];
+		if (SPIFFS_mounted(p) && progress.bix < p->block_count) {
+			check_block_noMutex(p, progress.bix);
+			fs_check_stats.blocks++;
+			progress.bix++;
+		}
+		if (!SPIFFS_mounted(p) || progress.bix >= p->block_count) {
+			progress.bix = 0;
+			progress.part++;
+		}
+		if (progress.part >= LEN(partitions)) {
+			if (fs_check_stats.pass_errors > 0) {
+				DLOG_FILE(FSYS_ERROR, "FSck pass: %d errors", fs_check_stats.pass_errors);
+			}
+			fs_check_stats.passes++;
+			fs_check_stats.last_pass_errors = fs_check_stats.pass_errors;
+			fs_check_stats.pass_errors = 0;
+			progress.part = 0;
+			progress.reports = 0;
+		}
+		if (partitions[progress.part] != p) {
+			break;
+		}
+	}
+	fs_check_stats.last_ticks = xTaskGetTickCount() - start;
+	if (fs_check_stats.last_ticks > fs_check_stats.max_ticks) {
+		fs_check_stats.max_ticks = fs_check_stats.last_ticks;
+	}
+	xSemaphoreGive(mutex);
+	return true;
+}
+
+/* check_block_noMutex
+ * 	- the magic, then every page against its lookup entry
+ * 	- reads go straight to the HAL. The SPIFFS cache is write through, so it can't hold anything the flash doesn't
+ */
+static void check_block_noMutex(spiffs *p, spiffs_block_ix bix) {
+	// CALL WITHIN MUTEX
+	const u32_t per_lu_page = SPIFFS_CFG_LOG_PAGE_SZ(p) / sizeof(spiffs_obj_id);
+	spiffs_page_header ph;
+	spiffs_obj_id magic;
+	spiffs_obj_id id;
+	spiffs_page_ix pix;
+	s32_t res;
+	u32_t e;
+
+	p->cfg.hal_read_f(SPIFFS_MAGIC_PADDR(p, bix), sizeof(magic), (u8_t *)&magic);
+	if (magic != SPIFFS_MAGIC(p, bix)) {
+		report(SPIFFS_PAGE_FOR_BLOCK(p, bix), SPIFFS_ERR_NOT_A_FS);
+		return; /* the rest of it is anyone's guess */
+	}
+
+	for (e = 0; e < SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(p); e++) {
+		if (e % per_lu_page == 0) {
+			p->cfg.hal_read_f(SPIFFS_BLOCK_TO_PADDR(p, bix) + (e / per_lu_page) * SPIFFS_CFG_LOG_PAGE_SZ(p),
+					SPIFFS_CFG_LOG_PAGE_SZ(p), lu_buf);
+		}
+		id = ((spiffs_obj_id *)lu_buf)[e % per_lu_page];
+		pix = SPIFFS_OBJ_LOOKUP_ENTRY_TO_PIX(p, bix, e);
+		if (id == SPIFFS_OBJ_ID_DELETED) {
+			continue;
+		}
+		read_header(p, pix, &ph);
+		if (id == SPIFFS_OBJ_ID_FREE) {
+			res = (ph.obj_id == SPIFFS_OBJ_ID_FREE && ph.flags == 0xFF) ? SPIFFS_OK : SPIFFS_SFU_ERR_DIRTY_FREE;
+		} else {
+			res = (ph.obj_id == id) ? check_page(id, &ph) : SPIFFS_SFU_ERR_ID_MISMATCH;
+		}
+		if (res != SPIFFS_OK) {
+			report(pix, res);
+		} else if (id != SPIFFS_OBJ_ID_FREE && (id & SPIFFS_OBJ_ID_IX_FLAG)) {
+			check_index_noMutex(p, pix, &ph);
+		}
+	}
+}
+
+/* check_page
+ * 	- a live page of the kind the object ID says. Same order as SPIFFS_VALIDATE_OBJIX/SPIFFS_VALIDATE_DATA
+ */
+static s32_t check_page(spiffs_obj_id id, const spiffs_page_header *ph) {
+	if (ph->flags & SPIFFS_PH_FLAG_USED) {
+		return SPIFFS_ERR_IS_FREE;
+	}
+	if ((ph->flags & SPIFFS_PH_FLAG_DELET) == 0) {
+		return SPIFFS_ERR_DELETED;
+	}
+	if (ph->flags & SPIFFS_PH_FLAG_FINAL) {
+		return SPIFFS_ERR_NOT_FINALIZED;
+	}
+	if ((id & SPIFFS_OBJ_ID_IX_FLAG) && (ph->flags & SPIFFS_PH_FLAG_INDEX)) {
+		return SPIFFS_ERR_NOT_INDEX;
+	}
+	if (!(id & SPIFFS_OBJ_ID_IX_FLAG) && (ph->flags & SPIFFS_PH_FLAG_INDEX) == 0) {
+		return SPIFFS_ERR_IS_INDEX;
+	}
+	if ((id & SPIFFS_OBJ_ID_IX_FLAG) && ph->span_ix == 0 && (ph->flags & SPIFFS_PH_FLAG_IXDELE) == 0) {
+		return SPIFFS_ERR_FILE_DELETED; /* a remove that didn't finish */
+	}
+	return SPIFFS_OK;
+}
+
+/* check_index_noMutex
+ * 	- every data page the index page at pix points at. Unused entries are 0xFFFF
+ */
+static void check_index_noMutex(spiffs *p, spiffs_page_ix pix, const spiffs_page_header *ph) {
+	// CALL WITHIN MUTEX
+	spiffs_obj_id data_id = ph->obj_id & ~SPIFFS_OBJ_ID_IX_FLAG;
+	spiffs_span_ix first = SPIFFS_DATA_SPAN_IX_FOR_OBJ_IX_SPAN_IX(p, ph->span_ix);
+	const spiffs_page_ix *entries;
+	spiffs_page_header dph;
+	u32_t count;
+	u32_t i;
+	s32_t res;
+
+	p->cfg.hal_read_f(SPIFFS_PAGE_TO_PADDR(p, pix), SPIFFS_CFG_LOG_PAGE_SZ(p), ix_buf);
+	if (ph->span_ix == 0) {
+		entries = (const spiffs_page_ix *)(ix_buf + sizeof(spiffs_page_object_ix_header));
+		count = SPIFFS_OBJ_HDR_IX_LEN(p);
+	} else {
+		entries = (const spiffs_page_ix *)(ix_buf + sizeof(spiffs_page_object_ix));
+		count = SPIFFS_OBJ_IX_LEN(p);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (entries[i] == (spiffs_page_ix)-1) {
+			continue;
+		}
+		if (entries[i] >= SPIFFS_MAX_PAGES(p)) {
+			res = SPIFFS_ERR_INDEX_REF_INVALID;
+		} else if (SPIFFS_IS_LOOKUP_PAGE(p, entries[i])) {
+			res = SPIFFS_ERR_INDEX_REF_LU;
+		} else {
+			read_header(p, entries[i], &dph);
+			if (dph.flags & SPIFFS_PH_FLAG_USED) {
+				res = SPIFFS_ERR_INDEX_REF_FREE;
+			} else if (dph.obj_id != data_id) {
+				res = SPIFFS_SFU_ERR_ID_MISMATCH;
+			} else if ((res = check_page(data_id, &dph)) == SPIFFS_OK && dph.span_ix != first + i) {
+				res = SPIFFS_ERR_DATA_SPAN_MISMATCH;
+			}
+		}
+		if (res != SPIFFS_OK) {
+			report(pix, res); /* the index page is where it's wrong */
+		}
+	}
+}
+
+static void read_header(spiffs *p, spiffs_page_ix pix, spiffs_page_header *ph) {
+	p->cfg.hal_read_f(SPIFFS_PAGE_TO_PADDR(p, pix), sizeof(*ph), (u8_t *)ph);
+}
+
+static void report(spiffs_page_ix pix, s32_t err) {
+	fs_check_stats.errors++;
+	fs_check_stats.pass_errors++;
+	if (progress.reports < FS_CHECK_MAX_REPORTS) {
+		progress.reports++;
+		DLOG_FILE(FSYS_ERROR, "FSck: %d %d %d", progress.part, pix, err);
+	}
+}
@@ -0,0 +1,53 @@
+/*
+ * obc_fs_check.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *      Background consistency check of both SPIFFS partitions.
+ *
+ *      SPIFFS_check goes over the whole image in one go and fixes what it finds, which would hold spiffsTopMutex for
+ *      seconds, so we never ran it. This one only looks: FS_CHECK_BLOCKS_PER_STEP blocks per fs_check_step, which the
+ *      GC task calls when it has nothing to collect. It keeps its place between steps and goes round both partitions
+ *      (logs, then state) forever. Nothing runs at boot.
+ *
+ *      For every block:
+ *      	- the magic has to match the partition's layout
+ *      	- a page the lookup says is free has to have an erased header
+ *      	- a page the lookup says is in use has to have a header with the same object ID that's used, finalized and not
+ *      	  deleted, an index page if the ID says so and a data page otherwise. A brownout in the middle of a write leaves
+ *      	  one of these half done
+ *      	- every data page an index page points at has to be a live data page of the same object with the right span
+ *      	  index. The pages can be in other blocks, they're read in the same mutex hold
+ *      Each problem is written to the error log (FSYS_ERROR) as "FSck: <partition> <page> <error>", with a SPIFFS error
+ *      code or SPIFFS_SFU_ERR_ID_MISMATCH / SPIFFS_SFU_ERR_DIRTY_FREE, partition 0 for logs and 1 for state. Only the
+ *      first FS_CHECK_MAX_REPORTS per pass are logged, the rest are just counted. "get fs" shows the counters.
+ *
+ *      Pages that are allocated but that no index points at (space leaked by a torn write) aren't found, that needs the
+ *      index of every object in RAM.
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_CHECK_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_CHECK_H_
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+
+#define FS_CHECK_BLOCKS_PER_STEP	1		/* a logs block is 127 pages, one header read each plus the index references */
+#define FS_CHECK_MAX_REPORTS		16		/* error log entries per pass */
+
+typedef struct fs_check_stats {
+	uint32_t passes;				/* complete rounds of both partitions */
+	uint32_t blocks;				/* blocks checked */
+	uint32_t errors;				/* since boot */
+	uint32_t pass_errors;			/* in the pass going on now */
+	uint32_t last_pass_errors;
+	uint32_t last_ticks;			/* mutex hold of the last step */
+	uint32_t max_ticks;
+} fs_check_stats_t;
+
+extern fs_check_stats_t fs_check_stats;
+
+bool fs_check_step();		/* check the next FS_CHECK_BLOCKS_PER_STEP blocks if the mutex is free, true if it did */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_CHECK_H_ */
@@ -0,0 +1,402 @@
+/*
+ * obc_fs_circular.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "obc_fs_circular.h"
+#include "obc_fs_record.h"
+#include "obc_spiffs.h"
+#include "obc_utils.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+
+fs_circ_stats_t fs_circ_stats;
+
+/* Private functions */
+static s32_t write_header_noMutex(spiffs_file fd, const fs_circ_t *circ);
+static s32_t wrap_noMutex(spiffs_file fd, fs_circ_t *circ);
+static s32_t recover_head_noMutex(spiffs_file fd, uint32_t file_size, fs_circ_t *circ);
+static s32_t start_over_noMutex(spiffs_file fd, uint32_t file_size, fs_circ_t *circ);
+static s32_t pad_header_page_noMutex(spiffs_file fd, uint32_t file_size);
+static bool parse_header(const uint8_t *buf, fs_circ_t *circ);
+static uint32_t page_count(const fs_circ_t *circ);
+static uint32_t page_offset(const fs_circ_t *circ, uint32_t k);
+static s32_t page_time_noMutex(spiffs_file fd, uint32_t offset, uint32_t *time);
+static void put_u16(uint8_t *buf, uint16_t v);
+static void put_u32(uint8_t *buf, uint32_t v);
+static uint16_t get_u16(const uint8_t *buf);
+static uint32_t get_u32(const uint8_t *buf);
+
+/* fs_circ_open_noMutex
+ * 	- reads the header of a circular log that was just opened and works out where head got to since it was written
+ * 	  (recover_head_noMutex). fd has to be open for reading and writing, without SPIFFS_APPEND
+ * 	- a new file, or one with a header we can't use (corrupt, or written with a different FS_CIRC_PAGES), gets a fresh
+ * 	  header and carries on from the end of its data
+ * 	- the file always ends up at least FS_CIRC_DATA_START long, the rest of the header page is 0xFF
+ */
+s32_t fs_circ_open_noMutex(spiffs_file fd, uint32_t file_size, fs_circ_t *circ) {
+	// CALL WITHIN MUTEX
+	uint8_t buf[FS_CIRC_HEADER_SIZE];
+	s32_t res;
+
+	if (file_size >= FS_CIRC_HEADER_SIZE) {
+		res = SPIFFS_lseek(&fs, fd, 0, SPIFFS_SEEK_SET);
+		if (res >= 0) {
+			res = SPIFFS_read(&fs, fd, buf, FS_CIRC_HEADER_SIZE);
+		}
+		if (res < 0) {
+			return SPIFFS_errno(&fs);
+		}
+		if (parse_header(buf, circ)) {
+			if (file_size < FS_CIRC_DATA_START) {
+				res = pad_header_page_noMutex(fd, file_size); /* a reset before the header page was complete */
+			} else {
+				return recover_head_noMutex(fd, file_size, circ);
+			}
+		} else {
+			fs_circ_stats.bad_headers++;
+			res = start_over_noMutex(fd, file_size, circ);
+		}
+	} else {
+		res = start_over_noMutex(fd, file_size, circ);
+	}
+
+	if (res >= 0 && SPIFFS_fflush(&fs, fd) < 0) {
+		res = SPIFFS_errno(&fs);
+	}
+	return res;
+}
+
+/* fs_circ_advance_noMutex
+ * 	- called after data up to file offset pos made it to flash. head moves there, and back to the start at the end
+ * 	  of the data pages
+ * 	- the header is only written when the log wraps. The next open finds head from the data (recover_head_noMutex)
+ */
+s32_t fs_circ_advance_noMutex(spiffs_file fd, fs_circ_t *circ, uint32_t pos) {
+	// CALL WITHIN MUTEX
+	circ->head = pos - FS_CIRC_DATA_START;
+	if (circ->head >= FS_CIRC_DATA_SIZE) {
+		return wrap_noMutex(fd, circ);
+	}
+	if (circ->wraps > 0) {
+		circ->tail = ((circ->head / SPIFFS_DATA_PAGE_SIZE(&fs) + 1) % FS_CIRC_PAGES) * SPIFFS_DATA_PAGE_SIZE(&fs);
+	}
+	return 0;
+}
+
+/* fs_circ_page_end
+ * 	- file offset the write at pos has to pad up to. After the first lap the rest of head's page still has the last
+ * 	  lap's data in it, which the next open couldn't tell from ours, so writes go to the end of the page with 0xFF
+ * 	  after the data. It's a modify of the whole page either way. On the first lap there's nothing after head
+ */
+uint32_t fs_circ_page_end(const fs_circ_t *circ, uint32_t pos) {
+	if (circ->wraps == 0 || pos % SPIFFS_DATA_PAGE_SIZE(&fs) == 0) {
+		return pos;
+	}
+	return pos + SPIFFS_DATA_PAGE_SIZE(&fs) - pos % SPIFFS_DATA_PAGE_SIZE(&fs);
+}
+
+uint32_t fs_circ_position(const fs_circ_t *circ) {
+	return FS_CIRC_DATA_START + circ->head;
+}
+
+/* fs_circ_find_noMutex
+ * 	- finds the parts of the log that hold the records between t0 and t1 (inclusive), like fs_index_find_noMutex:
+ * 	  from the last page starting at or before t0 to the first page starting after t1
+ * 	- binary search over the pages in time order, reading the base record each page starts with
+ * 	- fills starts/ends (FS_CIRC_MAX_RANGES each) with file offsets in time order. Returns the number of ranges,
+ * 	  0 if the log doesn't overlap the window, < 0 on errors
+ */
+s32_t fs_circ_find_noMutex(spiffs_file fd, const fs_circ_t *circ, uint32_t t0, uint32_t t1, uint32_t *starts, uint32_t *ends) {
+	// CALL WITHIN MUTEX
+	uint32_t count = page_count(circ);
+	uint32_t lo, hi, mid;
+	uint32_t first, last;
+	uint32_t start, end;
+	uint32_t time;
+	s32_t res;
+
+	fs_circ_stats.finds++;
+	if (count == 0) {
+		return 0;
+	}
+	res = page_time_noMutex(fd, page_offset(circ, 0), &time);
+	if (res < 0) {
+		return res;
+	}
+	if (time > t1) {
+		return 0;
+	}
+
+	/* last page starting at or before t0. Page 0 if they all start after it */
+	lo = 0;
+	hi = count;
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		res = page_time_noMutex(fd, page_offset(circ, mid), &time);
+		if (res < 0) {
+			return res;
+		}
+		if (time <= t0) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	first = lo;
+
+	/* first page starting after t1, count if there isn't one */
+	lo = first;
+	hi = count;
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		res = page_time_noMutex(fd, page_offset(circ, mid), &time);
+		if (res < 0) {
+			return res;
+		}
+		if (time <= t1) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	last = hi;
+
+	start = page_offset(circ, first);
+	end = (last == count) ? fs_circ_position(circ) : page_offset(circ, last);
+	if (end > start) {
+		starts[0] = start;
+		ends[0] = end;
+		return 1;
+	}
+	/* wraps around the end of the data pages */
+	starts[0] = start;
+	ends[0] = FS_CIRC_DATA_START + FS_CIRC_DATA_SIZE;
+	if (end == FS_CIRC_DATA_START) {
+		return 1;
+	}
+	starts[1] = FS_CIRC_DATA_START;
+	ends[1] = end;
+	return 2;
+}
+
+static s32_t write_header_noMutex(spiffs_file fd, const fs_circ_t *circ) {
+	// CALL WITHIN MUTEX
+	uint8_t buf[FS_CIRC_HEADER_SIZE] = { 0 };
+
+	put_u16(&buf[0], FS_CIRC_MAGIC);
+	put_u16(&buf[2], SPIFFS_DATA_PAGE_SIZE(&fs));
+	put_u16(&buf[4], FS_CIRC_PAGES);
+	put_u32(&buf[8], circ->head);
+	put_u32(&buf[12], circ->tail);
+	put_u32(&buf[16], circ->wraps);
+	put_u16(&buf[20], crc16_ccitt(buf, 20, 0xFFFF));
+
+	if (SPIFFS_lseek(&fs, fd, 0, SPIFFS_SEEK_SET) < 0 || SPIFFS_write(&fs, fd, buf, FS_CIRC_HEADER_SIZE) < 0) {
+		return SPIFFS_errno(&fs);
+	}
+	fs_circ_stats.header_writes++;
+	return 0;
+}
+
+/* wrap_noMutex
+ * 	- head is back at the start of the data pages. The one header write of a lap
+ */
+static s32_t wrap_noMutex(spiffs_file fd, fs_circ_t *circ) {
+	// CALL WITHIN MUTEX
+	s32_t res;
+
+	circ->head = 0;
+	circ->tail = SPIFFS_DATA_PAGE_SIZE(&fs);
+	circ->wraps++;
+	fs_circ_stats.wraps++;
+
+	res = write_header_noMutex(fd, circ);
+	if (res >= 0 && SPIFFS_fflush(&fs, fd) < 0) {
+		res = SPIFFS_errno(&fs);
+	}
+	return res;
+}
+
+/* recover_head_noMutex
+ * 	- the header has head as it was at the last wrap. On the first lap the file ends at head
+ * 	- after that the file is full size, and the pages from the header's head up to the real head were written this lap.
+ * 	  They start with base records at or after the one in the page before the header's head, which was the newest
+ * 	  page when the header was written. The pages after them are from the last lap and older, so it's a binary
+ * 	  search for the first older page, like fs_circ_find_noMutex. Setting the RTC back breaks this like it breaks finds
+ * 	- head ends up at the start of that page. The page before it is padded with 0xFF after its data
+ * 	  (fs_circ_page_end), so nothing is lost but the padding
+ */
+static s32_t recover_head_noMutex(spiffs_file fd, uint32_t file_size, fs_circ_t *circ) {
+	// CALL WITHIN MUTEX
+	uint32_t page_size = SPIFFS_DATA_PAGE_SIZE(&fs);
+	uint32_t lo, hi, mid;
+	uint32_t ref, time;
+	s32_t res;
+
+	if (circ->wraps == 0 || file_size < FS_CIRC_DATA_START + FS_CIRC_DATA_SIZE) {
+		circ->head = file_size - FS_CIRC_DATA_START;
+	} else {
+		res = page_time_noMutex(fd, FS_CIRC_DATA_START + ((circ->head / page_size + FS_CIRC_PAGES - 1) % FS_CIRC_PAGES) * page_size, &ref);
+		if (res < 0) {
+			return res;
+		}
+		lo = circ->head / page_size;
+		hi = FS_CIRC_PAGES;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			res = page_time_noMutex(fd, FS_CIRC_DATA_START + mid * page_size, &time);
+			if (res < 0) {
+				return res;
+			}
+			if (time != 0 && time >= ref) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		if (lo * page_size > circ->head) {
+			circ->head = lo * page_size;
+		}
+	}
+
+	if (circ->head >= FS_CIRC_DATA_SIZE) {
+		return wrap_noMutex(fd, circ); /* reset between the last page and the header */
+	}
+	if (circ->wraps > 0) {
+		circ->tail = ((circ->head / page_size + 1) % FS_CIRC_PAGES) * page_size;
+	}
+	return 0;
+}
+
+/* start_over_noMutex
+ * 	- a fresh header, and the rest of the header page if the file doesn't have it yet
+ * 	- data already in the file is kept. A full file counts as wrapped once, with head at 0
+ */
+static s32_t start_over_noMutex(spiffs_file fd, uint32_t file_size, fs_circ_t *circ) {
+	// CALL WITHIN MUTEX
+	s32_t res;
+
+	circ->head = 0;
+	circ->tail = 0;
+	circ->wraps = 0;
+	if (file_size >= FS_CIRC_DATA_START + FS_CIRC_DATA_SIZE) {
+		circ->tail = SPIFFS_DATA_PAGE_SIZE(&fs);
+		circ->wraps = 1;
+	} else if (file_size > FS_CIRC_DATA_START) {
+		circ->head = file_size - FS_CIRC_DATA_START;
+	}
+	res = write_header_noMutex(fd, circ);
+	if (res >= 0 && file_size < FS_CIRC_DATA_START) {
+		res = pad_header_page_noMutex(fd, (file_size > FS_CIRC_HEADER_SIZE) ? file_size : FS_CIRC_HEADER_SIZE);
+	}
+	return res;
+}
+
+/* pad_header_page_noMutex
+ * 	- fills the header page from file_size (the end of the file) with 0xFF. The data pages are written with a seek
+ * 	  to their offset, and SPIFFS can't seek past the end of a file
+ */
+static s32_t pad_header_page_noMutex(spiffs_file fd, uint32_t file_size) {
+	// CALL WITHIN MUTEX
+	uint8_t buf[32];
+	uint32_t chunk;
+
+	memset(buf, 0xFF, sizeof(buf));
+	if (SPIFFS_lseek(&fs, fd, file_size, SPIFFS_SEEK_SET) < 0) {
+		return SPIFFS_errno(&fs);
+	}
+	for (; file_size < FS_CIRC_DATA_START; file_size += chunk) {
+		chunk = (FS_CIRC_DATA_START - file_size < sizeof(buf)) ? FS_CIRC_DATA_START - file_size : sizeof(buf);
+		if (SPIFFS_write(&fs, fd, buf, chunk) < 0) {
+			return SPIFFS_errno(&fs);
+		}
+	}
+	return 0;
+}
+
+static bool parse_header(const uint8_t *buf, fs_circ_t *circ) {
+	if (get_u16(&buf[0]) != FS_CIRC_MAGIC
+			|| (uint32_t)get_u16(&buf[2]) != SPIFFS_DATA_PAGE_SIZE(&fs)
+			|| get_u16(&buf[4]) != FS_CIRC_PAGES
+			|| get_u16(&buf[20]) != crc16_ccitt(buf, 20, 0xFFFF)) {
+		return false;
+	}
+	circ->head = get_u32(&buf[8]);
+	circ->tail = get_u32(&buf[12]);
+	circ->wraps = get_u32(&buf[16]);
+	return circ->head < FS_CIRC_DATA_SIZE && circ->tail < FS_CIRC_DATA_SIZE;
+}
+
+/* page_count
+ * 	- data pages that hold records, oldest first: the ones from tail up to head's page. head's page counts once
+ * 	  something has been written to it
+ */
+static uint32_t page_count(const fs_circ_t *circ) {
+	uint32_t partial = (circ->head % SPIFFS_DATA_PAGE_SIZE(&fs) != 0) ? 1 : 0;
+
+	if (circ->wraps == 0) {
+		return circ->head / SPIFFS_DATA_PAGE_SIZE(&fs) + partial;
+	}
+	return FS_CIRC_PAGES - 1 + partial;
+}
+
+/* page_offset
+ * 	- file offset of the k'th oldest data page
+ */
+static uint32_t page_offset(const fs_circ_t *circ, uint32_t k) {
+	uint32_t page = (circ->tail / SPIFFS_DATA_PAGE_SIZE(&fs) + k) % FS_CIRC_PAGES;
+	return FS_CIRC_DATA_START + page * SPIFFS_DATA_PAGE_SIZE(&fs);
+}
+
+/* page_time_noMutex
+ * 	- time of the base record the data page at file offset offset starts with. 0 for a page that doesn't start
+ * 	  with one (written before circular mode), which sorts first
+ */
+static s32_t page_time_noMutex(spiffs_file fd, uint32_t offset, uint32_t *time) {
+	// CALL WITHIN MUTEX
+	uint8_t buf[6];
+	uint8_t shift = 0;
+	uint8_t i;
+
+	fs_circ_stats.find_reads++;
+	if (SPIFFS_lseek(&fs, fd, offset, SPIFFS_SEEK_SET) < 0 || SPIFFS_read(&fs, fd, buf, sizeof(buf)) < 0) {
+		return SPIFFS_errno(&fs);
+	}
+
+	*time = 0;
+	if (buf[0] != LOG_REC_BASE) {
+		return 0;
+	}
+	for (i = 1; i < sizeof(buf); i++) {
+		*time |= (uint32_t)(buf[i] & 0x7F) << shift;
+		if (buf[i] < 0x80) {
+			break;
+		}
+		shift += 7;
+	}
+	return 0;
+}
+
+static void put_u16(uint8_t *buf, uint16_t v) {
+	buf[0] = (uint8_t)(v >> 8);
+	buf[1] = (uint8_t)v;
+}
+
+static void put_u32(uint8_t *buf, uint32_t v) {
+	buf[0] = (uint8_t)(v >> 24);
+	buf[1] = (uint8_t)(v >> 16);
+	buf[2] = (uint8_t)(v >> 8);
+	buf[3] = (uint8_t)v;
+}
+
+static uint16_t get_u16(const uint8_t *buf) {
+	return (uint16_t)((buf[0] << 8) | buf[1]);
+}
+
+static uint32_t get_u32(const uint8_t *buf) {
+	return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
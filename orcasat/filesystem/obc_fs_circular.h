@@ -0,0 +1,80 @@
+/*
+ * obc_fs_circular.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Circular log files (FSYS_CIRCULAR_LOGS in obc_fs_structure.h).
+ *
+ *      Prefix rotation creates a new set of logs every FSYS_LOOP_INTERVAL and deletes the oldest one, so every rotation
+ *      is a burst of creates, deletes and then GC of the freed blocks. In circular mode each subsystem has one log
+ *      (FSYS_CIRC_PREFIX + suffix) of fixed capacity instead, and the oldest data is overwritten a page at a time:
+ *
+ *      	offset 0				header page: fs_circ_t as of the last wrap, big endian, CRC-16/CCITT
+ *      	FS_CIRC_DATA_START		FS_CIRC_PAGES data pages (SPIFFS_DATA_PAGE_SIZE each), written in a loop
+ *
+ *      head is where the next write goes, tail is where the oldest data left starts (both relative to
+ *      FS_CIRC_DATA_START). Once the log has wrapped, tail is the page after head's page. The rest of head's page
+ *      still has data from the last lap, so readers stop at head.
+ *
+ *      Records never cross a data page and the first one in each page is a base record (obc_fs_record.c), so any page
+ *      decodes on its own and the oldest page can be overwritten without breaking the ones after it. The space left
+ *      at the end of a page is padded with 0xFF, which the decoder skips like erased flash.
+ *
+ *      The header is only written when the log wraps, so head and tail on flash are where the lap started. On open,
+ *      head is found from the data: the end of the file on the first lap, and after that a binary search over the
+ *      base records for the first page older than the ones written this lap. After the first lap every write goes to
+ *      the end of its page with 0xFF after the data, so the page left behind by a reset decodes on its own and the
+ *      next boot starts on the page after it. Each data page written then costs a new data page and the object index
+ *      page rewrite, and nothing is ever deleted in bulk. The file grows to its full size on the first lap and stays
+ *      there. tools/log_decode.py finds head the same way when it decodes a whole file.
+ *
+ *      The data pages are in time order from tail, so fs_circ_find_noMutex() finds a time range with a binary
+ *      search over the base records at the start of each page. There's no index sidecar for circular logs.
+ *
+ *      ------ !!! ALL _noMutex FUNCTIONS MUST BE CALLED FROM WITHIN spiffsTopMutex !!! --------------
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_CIRCULAR_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_CIRCULAR_H_
+
+#include "sys_common.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+#include "obc_fs_structure.h"
+
+#define FS_CIRC_MAGIC			0xC1C0
+#define FS_CIRC_PAGES			1024								/* data pages per log, ~250 KB */
+#define FS_CIRC_DATA_START		SPIFFS_DATA_PAGE_SIZE(&fs)			/* the header has the first data page to itself */
+#define FS_CIRC_DATA_SIZE		(FS_CIRC_PAGES * SPIFFS_DATA_PAGE_SIZE(&fs))
+#define FS_CIRC_HEADER_SIZE		24
+#define FS_CIRC_MAX_RANGES		2									/* a time range can wrap around the end of the log */
+
+/* header, stored big endian field by field so tools/log_decode.py can read it:
+ * 	magic (2) | page size (2) | pages (2) | reserved (2) | head (4) | tail (4) | wraps (4) | crc (2) | reserved (2)
+ */
+typedef struct fs_circ {
+	uint32_t head;
+	uint32_t tail;
+	uint32_t wraps;				/* times the log has wrapped, 0 while it's on its first lap */
+} fs_circ_t;
+
+typedef struct fs_circ_stats {
+	uint32_t header_writes;		/* one per wrap and per fresh header */
+	uint32_t wraps;				/* since boot, all logs */
+	uint32_t bad_headers;		/* opens that found a corrupt header and started the log over */
+	uint32_t pads;				/* records moved to the next page, and the bytes that cost */
+	uint32_t pad_bytes;
+	uint32_t finds;
+	uint32_t find_reads;
+} fs_circ_stats_t;
+
+extern fs_circ_stats_t fs_circ_stats;
+
+s32_t fs_circ_open_noMutex(spiffs_file fd, uint32_t file_size, fs_circ_t *circ);	/* loads the header, or starts a new one */
+s32_t fs_circ_advance_noMutex(spiffs_file fd, fs_circ_t *circ, uint32_t pos);		/* data is written up to file offset pos. Moves head, writes the header on a wrap */
+uint32_t fs_circ_page_end(const fs_circ_t *circ, uint32_t pos);						/* where a write of data up to pos has to pad to */
+uint32_t fs_circ_position(const fs_circ_t *circ);									/* file offset of head */
+s32_t fs_circ_find_noMutex(spiffs_file fd, const fs_circ_t *circ, uint32_t t0, uint32_t t1, uint32_t *starts, uint32_t *ends); /* number of ranges */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_CIRCULAR_H_ */
@@ -0,0 +1,120 @@
+/*
+ * obc_fs_gc.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_task.h"
+#include "rtos_semphr.h"
+#include "obc_fs_gc.h"
+#include "obc_fs_check.h"
+#include "obc_spiffs.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+#include "obc_dlog.h"
+
+fs_gc_stats_t fs_gc_stats;
+
+static uint32_t seen_spiffs_runs; /* fs.stats_gc_runs after our last step */
+
+/* Private functions */
+static bool gc_step_noMutex();
+static void count_foreground_runs();
+
+/* Filesystem GC task
+ * - runs at the lowest priority. Tops up the erased block reserve one step at a time while nobody else needs SPIFFS
+ * - when there's nothing to collect, checks the next block for consistency instead (obc_fs_check.h)
+ */
+void vFilesystemGCTask(void *pvParameters) {
+	memset(&fs_gc_stats, 0, sizeof(fs_gc_stats));
+	seen_spiffs_runs = 0;
+
+	while (1) {
+		if (fs_gc_step()) {
+			vTaskDelay(FS_GC_STEP_INTERVAL);
+		} else {
+			fs_check_step();
+			vTaskDelay(FS_GC_IDLE_INTERVAL);
+		}
+	}
+}
+
+/* fs_gc_step
+ * 	- one pass of the GC task: a gc_step_noMutex if the mutex is free right now
+ * 	- returns true if it did anything to the flash
+ */
+bool fs_gc_step() {
+	TickType_t start;
+	bool worked = false;
+
+	/* spiffsTopMutex is created by the lifecycle task when it brings up SPIFFS */
+	if (spiffsTopMutex != NULL && xSemaphoreTake(spiffsTopMutex, 0) == pdTRUE) {
+		if (SPIFFS_mounted(&fs)) {
+			count_foreground_runs();
+			start = xTaskGetTickCount();
+			worked = gc_step_noMutex();
+			if (worked) {
+				fs_gc_stats.last_ticks = xTaskGetTickCount() - start;
+				if (fs_gc_stats.last_ticks > fs_gc_stats.max_ticks) {
+					fs_gc_stats.max_ticks = fs_gc_stats.last_ticks;
+				}
+			}
+			seen_spiffs_runs = fs.stats_gc_runs; /* our own runs aren't foreground */
+		}
+		xSemaphoreGive(spiffsTopMutex);
+	}
+	return worked;
+}
+
+/* gc_step_noMutex
+ * 	- erases at most one block's worth towards the reserve
+ * 	- returns true if it did anything to the flash
+ */
+static bool gc_step_noMutex() {
+	// CALL WITHIN MUTEX
+	u32_t block_pages = SPIFFS_PAGES_PER_BLOCK(&fs) - SPIFFS_OBJ_LOOKUP_PAGES(&fs);
+	s32_t free_pages;
+	s32_t res;
+
+	if (fs.free_blocks >= FS_GC_RESERVE_BLOCKS || fs.stats_p_deleted == 0) {
+		return false; /* reserve is full, or there's nothing we could get back */
+	}
+
+	res = SPIFFS_gc_quick(&fs, 0);
+	if (res == SPIFFS_OK) {
+		fs_gc_stats.quick_runs++;
+		return true;
+	}
+	if (SPIFFS_errno(&fs) != SPIFFS_ERR_NO_DELETED_BLOCKS) {
+		fs_gc_stats.errors++;
+		DLOG_SERIAL("GCqe: %d", my_spiffs_check_error(SPIFFS_errno(&fs)));
+		return true;
+	}
+
+	/* no block is all garbage, so some live pages have to move. Ask for one block of the deleted pages back
+	 * on top of what's free now, SPIFFS_gc cleans blocks until it has that much */
+	free_pages = (s32_t)(block_pages * (fs.block_count - 2)) - (s32_t)fs.stats_p_allocated - (s32_t)fs.stats_p_deleted;
+	if (free_pages < 0) {
+		free_pages = 0;
+	}
+	res = SPIFFS_gc(&fs, (free_pages + ((fs.stats_p_deleted < block_pages) ? fs.stats_p_deleted : block_pages)) * SPIFFS_DATA_PAGE_SIZE(&fs));
+	fs_gc_stats.full_runs++;
+	if (res < 0 && SPIFFS_errno(&fs) != SPIFFS_ERR_FULL) { /* FULL just means it couldn't get all of it */
+		fs_gc_stats.errors++;
+		DLOG_SERIAL("GCfe: %d", my_spiffs_check_error(SPIFFS_errno(&fs)));
+	}
+	return true;
+}
+
+/* count_foreground_runs
+ * 	- anything SPIFFS counted since our last step happened in some write. A mount resets the SPIFFS counter
+ */
+static void count_foreground_runs() {
+	if (fs.stats_gc_runs < seen_spiffs_runs) {
+		seen_spiffs_runs = 0;
+	}
+	fs_gc_stats.foreground_runs += fs.stats_gc_runs - seen_spiffs_runs;
+}
@@ -0,0 +1,46 @@
+/*
+ * obc_fs_gc.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Background garbage collection.
+ *
+ *      SPIFFS collects garbage from inside a write once it's down to 3 free blocks (spiffs_gc_check). Cleaning a block
+ *      means moving its live pages and erasing all 8 sectors of it, so whichever telemetry write hits that pays for
+ *      it while holding spiffsTopMutex. The GC task runs at the lowest priority and keeps FS_GC_RESERVE_BLOCKS erased
+ *      blocks around, so the write path shouldn't have to:
+ *      	- first SPIFFS_gc_quick, which only erases blocks that are entirely deleted pages (nothing to move)
+ *      	- then SPIFFS_gc, asking for one block's worth of the deleted pages back, which cleans one candidate block
+ *      It only does one of those per mutex hold and never waits for the mutex. If anyone else has it, we're not idle.
+ *      With the reserve full, each idle step checks a block instead (fs_check_step, obc_fs_check.h).
+ *
+ *      The counters are shown by "get gc". spiffs_runs and spiffs_free_blocks come from SPIFFS itself (SPIFFS_GC_STATS),
+ *      which resets them on every mount.
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_GC_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_GC_H_
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+
+#define FS_GC_RESERVE_BLOCKS	5						/* erased blocks to keep around. Must be > 3 or SPIFFS will GC in the write path anyway */
+#define FS_GC_IDLE_INTERVAL		pdMS_TO_TICKS(5000)		/* how often to check when the reserve is full */
+#define FS_GC_STEP_INTERVAL		pdMS_TO_TICKS(200)		/* pause between steps while working on the reserve */
+
+typedef struct fs_gc_stats {
+	uint32_t quick_runs;		/* SPIFFS_gc_quick calls that erased a block */
+	uint32_t full_runs;			/* SPIFFS_gc calls */
+	uint32_t foreground_runs;	/* GC runs SPIFFS did on its own, in somebody's write */
+	uint32_t errors;
+	uint32_t last_ticks;		/* mutex hold of the last step that did something */
+	uint32_t max_ticks;
+} fs_gc_stats_t;
+
+extern fs_gc_stats_t fs_gc_stats;
+
+void vFilesystemGCTask(void *pvParameters);
+bool fs_gc_step();		/* one pass of the GC task, true if it touched the flash */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_GC_H_ */
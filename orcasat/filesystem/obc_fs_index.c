@@ -0,0 +1,180 @@
+/*
+ * obc_fs_index.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "obc_fs_index.h"
+#include "obc_fs_structure.h"
+#include "obc_spiffs.h"
+#include "obc_fs_objects.h"
+#include "spiffs.h"
+
+static fs_index_t indexes[FSYS_NUM_SUBSYS];
+
+/* Private functions */
+static fs_index_t *get_index(char f_suffix);
+static void index_filename(char *nameBuf, char prefix, char f_suffix);
+
+void fs_index_init() {
+	uint8_t i;
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		indexes[i].prefix = '\0';
+		indexes[i].page = FS_INDEX_NO_PAGE;
+		indexes[i].pending = 0;
+		indexes[i].tracked = false;
+	}
+}
+
+/* fs_index_wants_entry
+ * 	- true if nothing in this data page of the prefix's log has been indexed yet
+ */
+bool fs_index_wants_entry(char f_suffix, char prefix, uint32_t page) {
+	fs_index_t *idx = get_index(f_suffix);
+	return idx != NULL && (idx->prefix != prefix || idx->page != page);
+}
+
+/* fs_index_add_noMutex
+ * 	- notes that the record at offset in the prefix's log has the given time
+ * 	- pending entries for an older prefix are written out to their own sidecar first
+ */
+s32_t fs_index_add_noMutex(char f_suffix, char prefix, uint32_t page, uint32_t time, uint32_t offset) {
+	// CALL WITHIN MUTEX
+	fs_index_t *idx = get_index(f_suffix);
+	s32_t res = 0;
+
+	if (idx == NULL) {
+		return SPIFFS_ERR_BAD_DESCRIPTOR;
+	}
+	if (idx->prefix != prefix) {
+		fs_index_flush_noMutex(f_suffix);
+		idx->pending = 0; /* if that didn't work they're lost, don't mix them into the new sidecar */
+		idx->prefix = prefix;
+		idx->tracked = false;
+	}
+
+	idx->page = page;
+	idx->entries[idx->pending].time = time;
+	idx->entries[idx->pending].offset = offset;
+	idx->pending++;
+
+	if (idx->pending >= FS_INDEX_PENDING) {
+		res = fs_index_flush_noMutex(f_suffix);
+	}
+	return res;
+}
+
+/* fs_index_flush_noMutex
+ * 	- appends the pending entries to the sidecar, creating it if needed
+ * 	- on error the entries stay pending, unless we've run out of room for new ones
+ */
+s32_t fs_index_flush_noMutex(char f_suffix) {
+	// CALL WITHIN MUTEX
+	fs_index_t *idx = get_index(f_suffix);
+	char nameBuf[3] = { '\0' };
+	spiffs_file fd;
+	spiffs_stat s;
+	s32_t res;
+
+	if (idx == NULL) {
+		return SPIFFS_ERR_BAD_DESCRIPTOR;
+	}
+	if (idx->pending == 0) {
+		return 0;
+	}
+
+	index_filename(nameBuf, idx->prefix, f_suffix);
+	fd = SPIFFS_open(&fs, nameBuf, SPIFFS_CREAT | SPIFFS_APPEND | SPIFFS_WRONLY, 0);
+	if (fd < 0) {
+		res = SPIFFS_errno(&fs);
+	} else {
+		res = SPIFFS_write(&fs, fd, idx->entries, idx->pending * sizeof(fs_index_entry_t));
+		if (res >= 0 && !idx->tracked && SPIFFS_fstat(&fs, fd, &s) >= 0) {
+			fs_objects_track(idx->prefix, &s);
+			idx->tracked = true;
+		}
+		if (SPIFFS_close(&fs, fd) < 0 && res >= 0) {
+			res = SPIFFS_errno(&fs);
+		}
+	}
+
+	if (res >= 0 || idx->pending >= FS_INDEX_PENDING) {
+		idx->pending = 0;
+	}
+	return res < 0 ? res : 0;
+}
+
+s32_t fs_index_flush_all_noMutex() {
+	// CALL WITHIN MUTEX
+	s32_t res;
+	s32_t err = 0;
+	uint8_t i;
+
+	for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+		res = fs_index_flush_noMutex((char) (FSYS_OFFSET + i));
+		if (res < 0 && err == 0) {
+			err = res;
+		}
+	}
+	return err;
+}
+
+/* fs_index_find_noMutex
+ * 	- looks up the byte range of the prefix's log that holds the records between t0 and t1 (inclusive)
+ * 	- start is the last indexed record at or before t0, end is the first indexed record after t1 (DUMP_TO_END if none)
+ * 	- assumes time only moves forward within a file. The range can hold records outside [t0, t1], the ground filters those
+ * 	- returns 1 if the log overlaps the range, 0 if not (or there's no index), < 0 on errors
+ */
+s32_t fs_index_find_noMutex(char prefix, char f_suffix, uint32_t t0, uint32_t t1, uint32_t *start, uint32_t *end) {
+	// CALL WITHIN MUTEX
+	static fs_index_entry_t entries[FS_INDEX_READ_ENTRIES];
+	char nameBuf[3] = { '\0' };
+	bool have_start = false;
+	bool done = false;
+	spiffs_file fd;
+	s32_t res;
+	uint32_t i;
+
+	index_filename(nameBuf, prefix, f_suffix);
+	fd = SPIFFS_open(&fs, nameBuf, SPIFFS_RDONLY, 0);
+	if (fd < 0) {
+		return SPIFFS_errno(&fs) == SPIFFS_ERR_NOT_FOUND ? 0 : SPIFFS_errno(&fs);
+	}
+
+	*end = DUMP_TO_END;
+	while (!done) {
+		res = SPIFFS_read(&fs, fd, entries, sizeof(entries));
+		if (res <= 0) {
+			break; /* SPIFFS_ERR_END_OF_OBJECT once we've read everything */
+		}
+		for (i = 0; i < res / sizeof(fs_index_entry_t); i++) {
+			if (entries[i].time > t1) { /* past the window */
+				if (have_start) {
+					*end = entries[i].offset;
+				}
+				done = true;
+				break;
+			}
+			if (entries[i].time <= t0 || !have_start) {
+				*start = entries[i].offset;
+				have_start = true;
+			}
+		}
+	}
+	SPIFFS_close(&fs, fd);
+	return have_start ? 1 : 0;
+}
+
+static fs_index_t *get_index(char f_suffix) {
+	if (f_suffix < FSYS_OFFSET || f_suffix >= FSYS_OFFSET + FSYS_NUM_SUBSYS) {
+		return NULL;
+	}
+	return &indexes[f_suffix - FSYS_OFFSET];
+}
+
+static void index_filename(char *nameBuf, char prefix, char f_suffix) {
+	nameBuf[0] = prefix;
+	nameBuf[1] = f_suffix - 'A' + 'a';
+}
@@ -0,0 +1,55 @@
+/*
+ * obc_fs_index.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Sparse time index for the log files.
+ *
+ *      Every log has a sidecar index file named <prefix><lowercase suffix> (aA is indexed by aa). It's a flat array of
+ *      fs_index_entry_t, one entry for the first record written in each data page of the log. The record layer
+ *      (obc_fs_record.c) starts every indexed record with a base record, so decoding can start right at an indexed
+ *      offset without anything that came before it.
+ *
+ *      Entries are kept in RAM until FS_INDEX_PENDING of them are waiting, so the sidecar is only opened once every
+ *      few pages. They're also written out by sfu_flush_logs(), before rotation and before a range lookup. Entries lost
+ *      on an unexpected reset only make range lookups start a bit earlier than they need to.
+ *
+ *      The sidecar shares the prefix with its log, so prefix rotation deletes it along with the log. It's registered
+ *      in the rotation table (obc_fs_objects.h) the first time it's written for a prefix.
+ *
+ *      ------ !!! ALL _noMutex FUNCTIONS MUST BE CALLED FROM WITHIN spiffsTopMutex !!! --------------
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_INDEX_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_INDEX_H_
+
+#include "sys_common.h"
+#include "spiffs.h"
+#include "obc_fs_structure.h"
+
+#define FS_INDEX_PENDING		4		/* entries buffered per log before we append them to the sidecar */
+#define FS_INDEX_READ_ENTRIES	16		/* entries read from the sidecar at once during a lookup */
+#define FS_INDEX_NO_PAGE		0xFFFFFFFF
+
+typedef struct fs_index_entry {
+	uint32_t time;		/* RTC time of the indexed record */
+	uint32_t offset;	/* byte offset of its base record in the log */
+} fs_index_entry_t;
+
+typedef struct fs_index {
+	char prefix;		/* prefix of the log the pending entries belong to */
+	uint32_t page;		/* data page of the last indexed record, FS_INDEX_NO_PAGE if none */
+	uint8_t pending;
+	bool tracked;		/* sidecar has been registered with fs_objects_track */
+	fs_index_entry_t entries[FS_INDEX_PENDING];
+} fs_index_t;
+
+void fs_index_init();
+bool fs_index_wants_entry(char f_suffix, char prefix, uint32_t page);					/* true if a record in this page of the log isn't indexed yet */
+s32_t fs_index_add_noMutex(char f_suffix, char prefix, uint32_t page, uint32_t time, uint32_t offset);
+s32_t fs_index_flush_noMutex(char f_suffix);											/* append the pending entries to the sidecar */
+s32_t fs_index_flush_all_noMutex();
+s32_t fs_index_find_noMutex(char prefix, char f_suffix, uint32_t t0, uint32_t t1, uint32_t *start, uint32_t *end); /* 1 if the log overlaps [t0, t1] */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_INDEX_H_ */
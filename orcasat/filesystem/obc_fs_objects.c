@@ -0,0 +1,143 @@
+/*
+ * obc_fs_objects.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "obc_fs_objects.h"
+#include "obc_fs_structure.h"
+#include "obc_spiffs.h"
+#include "spiffs.h"
+
+static fs_prefix_objects_t prefix_objects[PREFIX_QUANTITY];
+
+/* Private functions */
+static fs_prefix_objects_t *get_objects(char prefix);
+
+void fs_objects_init() {
+	uint8_t i;
+	for (i = 0; i < PREFIX_QUANTITY; i++) {
+		prefix_objects[i].complete = false; /* the flash can have anything on it from before the reset */
+		prefix_objects[i].count = 0;
+	}
+}
+
+void fs_objects_reset_prefix(char prefix, bool empty) {
+	fs_prefix_objects_t *t = get_objects(prefix);
+	if (t != NULL) {
+		t->complete = empty;
+		t->count = 0;
+	}
+}
+
+/* fs_objects_track
+ * 	- adds the file to the prefix's table, or updates its header page if it's already there
+ * 	- a full table can't cover the prefix anymore, so rotation falls back to scanning for it
+ */
+void fs_objects_track(char prefix, const spiffs_stat *s) {
+	fs_prefix_objects_t *t = get_objects(prefix);
+	uint8_t i;
+
+	if (t == NULL) {
+		return;
+	}
+	for (i = 0; i < t->count; i++) {
+		if (t->objs[i].obj_id == s->obj_id) {
+			t->objs[i].pix = s->pix;
+			return;
+		}
+	}
+	if (t->count < FS_OBJECTS_PER_PREFIX) {
+		t->objs[t->count].obj_id = s->obj_id;
+		t->objs[t->count].pix = s->pix;
+		t->count++;
+	} else {
+		t->complete = false;
+	}
+}
+
+/* fs_objects_delete_prefix_noMutex
+ * 	- deletes the prefix's files by opening each one at its header page, no directory scan
+ * 	- every object is checked against the table before it's removed. If something doesn't line up (or the
+ * 	  table isn't complete), returns FS_OBJECTS_NOT_TRACKED and the caller has to scan for what's left
+ */
+s32_t fs_objects_delete_prefix_noMutex(char prefix) {
+	// CALL WITHIN MUTEX
+	fs_prefix_objects_t *t = get_objects(prefix);
+	fs_object_t objs[FS_OBJECTS_PER_PREFIX];
+	spiffs_file fd;
+	spiffs_stat s;
+	uint8_t count;
+	uint8_t i;
+
+	if (t == NULL || !t->complete) {
+		return FS_OBJECTS_NOT_TRACKED;
+	}
+
+	/* removing an object calls fs_objects_file_event, which takes it out of the table. Work from a copy */
+	count = t->count;
+	memcpy(objs, t->objs, count * sizeof(fs_object_t));
+
+	for (i = 0; i < count; i++) {
+		fd = SPIFFS_open_by_page(&fs, objs[i].pix, SPIFFS_RDWR, 0);
+		if (fd < 0) {
+			break;
+		}
+		if (SPIFFS_fstat(&fs, fd, &s) < 0 || s.obj_id != objs[i].obj_id || s.name[0] != prefix) {
+			SPIFFS_close(&fs, fd);
+			break;
+		}
+		if (SPIFFS_fremove(&fs, fd) < 0) {
+			SPIFFS_close(&fs, fd);
+			break;
+		}
+		SPIFFS_close(&fs, fd); /* returns file closed or deleted, the fd is already gone */
+	}
+
+	if (i < count) {
+		fs_objects_reset_prefix(prefix, false);
+		return FS_OBJECTS_NOT_TRACKED;
+	}
+	fs_objects_reset_prefix(prefix, true);
+	return count;
+}
+
+/* fs_objects_file_event
+ * 	- registered with SPIFFS_set_file_callback_func after every mount (my_spiffs_mount)
+ * 	- runs inside SPIFFS, so it must not call back into it
+ * 	- new files don't come with a name here, they're added by fs_objects_track once they're open
+ */
+void fs_objects_file_event(spiffs *fs, spiffs_fileop_type op, spiffs_obj_id obj_id, spiffs_page_ix pix) {
+	fs_prefix_objects_t *t;
+	uint8_t p;
+	uint8_t i;
+
+	(void)fs;
+	if (op == SPIFFS_CB_CREATED) {
+		return;
+	}
+	for (p = 0; p < PREFIX_QUANTITY; p++) {
+		t = &prefix_objects[p];
+		for (i = 0; i < t->count; i++) {
+			if (t->objs[i].obj_id != obj_id) {
+				continue;
+			}
+			if (op == SPIFFS_CB_UPDATED) {
+				t->objs[i].pix = pix;
+			} else { /* SPIFFS_CB_DELETED */
+				t->count--;
+				t->objs[i] = t->objs[t->count];
+			}
+			return;
+		}
+	}
+}
+
+static fs_prefix_objects_t *get_objects(char prefix) {
+	if (prefix < PREFIX_START || prefix >= PREFIX_START + PREFIX_QUANTITY) {
+		return NULL;
+	}
+	return &prefix_objects[prefix - PREFIX_START];
+}
@@ -0,0 +1,49 @@
+/*
+ * obc_fs_objects.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      RAM table of the SPIFFS objects that belong to each prefix.
+ *
+ *      Finding a prefix's files with SPIFFS_readdir reads the header of every object on the flash, and then opening each
+ *      match by its dirent reads it again. Rotation does this while holding spiffsTopMutex. Instead, the logs and their
+ *      index sidecars are registered here when they're opened, with their object ID and the page of their object index
+ *      header. SPIFFS tells us through the file callback (fs_objects_file_event) whenever a header moves, gets rewritten
+ *      or is deleted, so the table stays current and rotation can open each object directly by its page.
+ *
+ *      The table only knows about files created since boot. A prefix is "complete" when all of its files were deleted
+ *      and its new set was created while we were watching. Anything else (the prefixes left over from before a reset,
+ *      a table that ran out of slots) still goes through the readdir scan.
+ *
+ *      ------ !!! ALL _noMutex FUNCTIONS MUST BE CALLED FROM WITHIN spiffsTopMutex !!! --------------
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_OBJECTS_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_OBJECTS_H_
+
+#include "sys_common.h"
+#include "spiffs.h"
+#include "obc_fs_structure.h"
+
+#define FS_OBJECTS_PER_PREFIX	(2 * FSYS_NUM_SUBSYS)	/* a log and an index sidecar per subsystem */
+#define FS_OBJECTS_NOT_TRACKED	(-1)					/* fs_objects_delete_prefix_noMutex: the table can't be trusted, scan instead */
+
+typedef struct fs_object {
+	spiffs_obj_id obj_id;
+	spiffs_page_ix pix;		/* object index header page, kept up to date by fs_objects_file_event */
+} fs_object_t;
+
+typedef struct fs_prefix_objects {
+	bool complete;			/* every object with this prefix is in the table */
+	uint8_t count;
+	fs_object_t objs[FS_OBJECTS_PER_PREFIX];
+} fs_prefix_objects_t;
+
+void fs_objects_init();
+void fs_objects_reset_prefix(char prefix, bool empty);				/* forget the prefix's objects. empty: none are left on the flash */
+void fs_objects_track(char prefix, const spiffs_stat *s);			/* register a file with the prefix, s from SPIFFS_fstat */
+s32_t fs_objects_delete_prefix_noMutex(char prefix);				/* returns the number of files deleted or FS_OBJECTS_NOT_TRACKED */
+void fs_objects_file_event(spiffs *fs, spiffs_fileop_type op, spiffs_obj_id obj_id, spiffs_page_ix pix); /* SPIFFS file callback */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_OBJECTS_H_ */
@@ -0,0 +1,187 @@
+/*
+ * obc_fs_record.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "obc_fs_record.h"
+#include "obc_fs_appender.h"
+#include "obc_fs_index.h"
+#include "obc_fs_circular.h"
+#include "obc_fs_structure.h"
+#include "obc_spiffs.h"
+#include "spiffs_nucleus.h"
+#include "obc_utils.h"
+
+/* Private functions */
+static int8_t record_num_fields(log_record_type_t type);
+static s32_t record_write_noMutex(char f_suffix, uint32_t time, log_record_type_t type, const uint8_t *body, uint32_t body_size);
+static uint32_t build_record(uint8_t *buf, fs_appender_t *app, uint32_t time, log_record_type_t type, const uint8_t *body, uint32_t body_size);
+static uint8_t put_varint(uint8_t *buf, uint32_t value);
+static uint8_t put_fields(uint8_t *buf, const int32_t *fields, uint8_t num_fields);
+
+/* fs_record_write_fields_noMutex
+ * 	- appends a record with num_fields integer fields to the current log for f_suffix
+ * 	- num_fields has to match the type's entry in LOG_RECORD_TABLE, or the ground can't decode the rest of the file
+ */
+s32_t fs_record_write_fields_noMutex(char f_suffix, uint32_t time, log_record_type_t type, const int32_t *fields, uint8_t num_fields) {
+	// CALL WITHIN MUTEX
+	uint8_t body[LOG_RECORD_MAX_FIELDS * 5];
+	uint8_t len;
+
+	if (num_fields > LOG_RECORD_MAX_FIELDS || record_num_fields(type) != num_fields) {
+		return SPIFFS_SFU_ERR_RECORD_FIELDS;
+	}
+
+	len = put_fields(body, fields, num_fields);
+	return record_write_noMutex(f_suffix, time, type, body, len);
+}
+
+/* fs_record_write_deferred_noMutex
+ * 	- appends a deferred format record: the format string's ID and its raw arguments. See obc_dlog.h
+ */
+s32_t fs_record_write_deferred_noMutex(char f_suffix, uint32_t time, uint32_t fmt_id, const int32_t *args, uint8_t num_args) {
+	// CALL WITHIN MUTEX
+	uint8_t body[LOG_RECORD_MAX_BODY];
+	uint8_t len = 0;
+
+	if (num_args > LOG_RECORD_MAX_FIELDS) {
+		return SPIFFS_SFU_ERR_RECORD_FIELDS;
+	}
+
+	body[len++] = (uint8_t)(fmt_id >> 24);
+	body[len++] = (uint8_t)(fmt_id >> 16);
+	body[len++] = (uint8_t)(fmt_id >> 8);
+	body[len++] = (uint8_t)fmt_id;
+	body[len++] = num_args;
+	len += put_fields(&body[len], args, num_args);
+	return record_write_noMutex(f_suffix, time, LOG_REC_DEFERRED, body, len);
+}
+
+/* fs_record_write_text_noMutex
+ * 	- appends a free form text record, including the NUL terminator
+ */
+s32_t fs_record_write_text_noMutex(char f_suffix, uint32_t time, const char *text) {
+	// CALL WITHIN MUTEX
+	return record_write_noMutex(f_suffix, time, LOG_REC_TEXT, (const uint8_t *)text, strlen(text) + 1);
+}
+
+/* record_write_noMutex
+ * 	- writes the type and time delta header followed by body
+ * 	- puts down a new base record first if the file doesn't have a usable one
+ */
+static s32_t record_write_noMutex(char f_suffix, uint32_t time, log_record_type_t type, const uint8_t *body, uint32_t body_size) {
+	// CALL WITHIN MUTEX
+	uint8_t buf[LOG_RECORD_MAX_SIZE];
+	fs_appender_t *app = fs_appender_get(f_suffix);
+	uint32_t len;
+	uint32_t pos;
+	uint32_t page;
+	bool indexed;
+	s32_t res;
+
+	if (app == NULL) {
+		return SPIFFS_ERR_BAD_DESCRIPTOR;
+	}
+	if (body_size > LOG_RECORD_MAX_BODY) {
+		body_size = LOG_RECORD_MAX_BODY;
+	}
+
+	/* opening first makes the appender forget the time base if this is a new file */
+	res = fs_appender_open_noMutex(f_suffix, 0);
+	if (res < 0) {
+		return res;
+	}
+
+	pos = app->size + app->staged;
+	page = pos / SPIFFS_DATA_PAGE_SIZE(&fs);
+#ifdef FSYS_CIRCULAR_LOGS
+	/* every page starts with a base record and records don't cross pages, so each page decodes on its own once the
+	 * ones before it have been overwritten (obc_fs_circular.h) */
+	indexed = false;
+	if (pos % SPIFFS_DATA_PAGE_SIZE(&fs) == 0) {
+		app->time_base = 0;
+	}
+	len = build_record(buf, app, time, type, body, body_size);
+	if (len > SPIFFS_DATA_PAGE_SIZE(&fs) - pos % SPIFFS_DATA_PAGE_SIZE(&fs)) {
+		res = fs_appender_pad_noMutex(f_suffix);
+		app->time_base = 0;
+		if (res < 0) {
+			return res;
+		}
+		fs_circ_stats.pads++;
+		fs_circ_stats.pad_bytes += res;
+		len = build_record(buf, app, time, type, body, body_size);
+	}
+#else
+	/* the first record in each data page goes in the time index, and has to be decodable on its own */
+	indexed = fs_index_wants_entry(f_suffix, app->prefix, page);
+	if (indexed) {
+		app->time_base = 0;
+	}
+	len = build_record(buf, app, time, type, body, body_size);
+#endif
+
+	res = fs_appender_write_noMutex(f_suffix, buf, len);
+	if (res < 0) {
+		app->time_base = 0; /* we don't know if the base made it, write another one next time */
+	} else if (indexed) {
+		fs_index_add_noMutex(f_suffix, app->prefix, page, time, pos); /* a missing entry only widens range lookups */
+	}
+	return res;
+}
+
+/* build_record
+ * 	- puts the record in buf, after a new base record if the appender doesn't have a usable one. Returns its size
+ */
+static uint32_t build_record(uint8_t *buf, fs_appender_t *app, uint32_t time, log_record_type_t type, const uint8_t *body, uint32_t body_size) {
+	uint32_t len = 0;
+
+	if (app->time_base == 0 || time < app->time_base || (time - app->time_base) > LOG_RECORD_MAX_DELTA) {
+		buf[len++] = LOG_REC_BASE;
+		len += put_varint(&buf[len], time);
+		app->time_base = time;
+	}
+
+	buf[len++] = type;
+	len += put_varint(&buf[len], time - app->time_base);
+	memcpy(&buf[len], body, body_size);
+	return len + body_size;
+}
+
+static int8_t record_num_fields(log_record_type_t type) {
+#define GENERATE_LOG_RECORD_CASE(name, id, num_fields, fmt) case name: return num_fields;
+	switch (type) {
+		LOG_RECORD_TABLE(GENERATE_LOG_RECORD_CASE)
+		default: return -1;
+	}
+#undef GENERATE_LOG_RECORD_CASE
+}
+
+/* put_fields
+ * 	- zigzag encodes each field as a varint: small negative numbers become small positive ones, so they stay short
+ */
+static uint8_t put_fields(uint8_t *buf, const int32_t *fields, uint8_t num_fields) {
+	uint8_t len = 0;
+	uint8_t i;
+
+	for (i = 0; i < num_fields; i++) {
+		len += put_varint(&buf[len], ((uint32_t)fields[i] << 1) ^ (uint32_t)(fields[i] >> 31));
+	}
+	return len;
+}
+
+/* put_varint
+ * 	- unsigned LEB128, low 7 bits first. Returns the number of bytes written, at most 5
+ */
+static uint8_t put_varint(uint8_t *buf, uint32_t value) {
+	uint8_t len = 0;
+	while (value >= 0x80) {
+		buf[len++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	buf[len++] = (uint8_t)value;
+	return len;
+}
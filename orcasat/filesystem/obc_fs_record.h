@@ -0,0 +1,74 @@
+/*
+ * obc_fs_record.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Binary log records. Every log entry is written as:
+ *
+ *      	[type][dt varint][body]
+ *
+ *      	type	one byte from LOG_RECORD_TABLE. 0x00 and 0xFF are never used so padding and erased flash can't look like a record
+ *      	dt		seconds since the file's time base, unsigned LEB128 varint (7 bits per byte, MSB set on all but the last byte)
+ *      	body	LOG_REC_TEXT: the printf output, NUL terminated
+ *      			LOG_REC_DEFERRED: 4 byte format ID (big endian), argument count byte, then the arguments as zigzag varints (obc_dlog.h)
+ *      			LOG_REC_BASE: no body, dt holds the absolute RTC time and becomes the new time base
+ *      			everything else: the record's fields, each one a zigzag encoded varint
+ *
+ *      A base record is written before the first entry of a file, whenever time goes backwards (RTC was set), and when the
+ *      delta gets past LOG_RECORD_MAX_DELTA, so dt stays at one or two bytes. A 3 field telemetry record is usually 5 bytes,
+ *      where the old "<epoch>|OBC: 23\0" text entries were ~19 bytes each.
+ *
+ *      tools/log_decode.py parses LOG_RECORD_TABLE out of this file and turns dumped logs back into "<time>|<text>" lines.
+ *
+ *      ------ !!! ALL _noMutex FUNCTIONS MUST BE CALLED FROM WITHIN spiffsTopMutex !!! --------------
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_RECORD_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_RECORD_H_
+
+#include "sys_common.h"
+#include "spiffs.h"
+#include "obc_fs_structure.h"
+#include "obc_rtc.h"
+
+/* LOG_RECORD_TABLE
+ * 	- name, type byte, number of fields, format the ground decoder renders the fields with
+ * 	- fields are int32_t. Keep one entry per line, the decoder reads this table with a regex
+ * 	- never reuse or renumber a type byte, old logs on the ground still use it
+ */
+#define LOG_RECORD_TABLE(ENTRY) \
+	ENTRY(LOG_REC_BASE,		0x01,	0,	"base") \
+	ENTRY(LOG_REC_TEXT,		0x02,	0,	"%s") \
+	ENTRY(LOG_REC_EVENT,	0x03,	2,	"%d, %d") \
+	ENTRY(LOG_REC_RAMOCCUR,	0x04,	2,	"R1: %d, R2: %d") \
+	ENTRY(LOG_REC_BMS,		0x05,	2,	"%d V, %d uA") \
+	ENTRY(LOG_REC_CURRENT,	0x06,	1,	"%d") \
+	ENTRY(LOG_REC_TEMPS,	0x07,	3,	"OBC: %d, LB: %d, UB: %d") \
+	ENTRY(LOG_REC_DEFERRED,	0x08,	0,	"%s")
+
+#define GENERATE_LOG_RECORD_ENUM(name, id, num_fields, fmt) name = id,
+
+typedef enum log_record_type {
+	LOG_RECORD_TABLE(GENERATE_LOG_RECORD_ENUM)
+} log_record_type_t;
+
+#define LOG_RECORD_MAX_FIELDS	6								/* most fields a record can have */
+#define LOG_RECORD_MAX_DELTA	0x3FFF							/* largest dt before we write a new base. Keeps dt in 2 varint bytes */
+#define LOG_RECORD_MAX_BODY		(4 + 1 + LOG_RECORD_MAX_FIELDS * 5)	/* biggest body, a deferred record. Text (SFU_WRITE_DATA_BUF) fits too */
+#define LOG_RECORD_MAX_SIZE		(2 * (1 + 5) + LOG_RECORD_MAX_BODY)	/* base record + type + worst case dt varint + body */
+
+/* SFU_WRITE_RECORD
+ * 	- writes a binary log record stamped with the current time. type is a LOG_REC_ from LOG_RECORD_TABLE
+ * 	- ex: SFU_WRITE_RECORD(FSYS_BMS, LOG_REC_BMS, volt, curr);
+ */
+#define SFU_WRITE_RECORD(f_suffix, type, ...) do { \
+		const int32_t _fields[] = { __VA_ARGS__ }; \
+		sfu_write_fields((f_suffix), getCurrentRTCTime(), (type), _fields, sizeof(_fields) / sizeof(_fields[0])); \
+	} while (0)
+
+s32_t fs_record_write_fields_noMutex(char f_suffix, uint32_t time, log_record_type_t type, const int32_t *fields, uint8_t num_fields);
+s32_t fs_record_write_text_noMutex(char f_suffix, uint32_t time, const char *text);
+s32_t fs_record_write_deferred_noMutex(char f_suffix, uint32_t time, uint32_t fmt_id, const int32_t *args, uint8_t num_args);
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_RECORD_H_ */
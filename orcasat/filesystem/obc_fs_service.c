@@ -0,0 +1,602 @@
+/*
+ * obc_fs_service.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_task.h"
+#include "rtos_queue.h"
+#include "rtos_semphr.h"
+#include "obc_fs_service.h"
+#include "obc_fs_structure.h"
+#include "obc_fs_appender.h"
+#include "obc_fs_record.h"
+#include "obc_fs_wear.h"
+#include "obc_flag_store.h"
+#include "obc_spiffs.h"
+#include "obc_flags.h"
+#include "obc_uart.h"
+#include "obc_dlog.h"
+#include "spiffs.h"
+
+QueueHandle_t xFsServiceQueue;
+QueueHandle_t xFsStateQueue;
+fs_service_stats_t fs_service_stats;
+bool fs_service_ix_maps = true;
+
+static TaskHandle_t service_task;		/* set by fs_service_start */
+static bool in_batch;					/* service task is holding spiffsTopMutex for a batch */
+static bool in_state;					/* service task is holding spiffsStateMutex for the state lane */
+static SemaphoreHandle_t wake;			/* given with every request, the service waits on it when it's idle */
+static uint32_t dropped_reported;
+
+typedef enum fs_waiter_state {
+	FS_WAITER_FREE,
+	FS_WAITER_QUEUED,		/* the request is in the queue */
+	FS_WAITER_STARTED,		/* the service has it, and the caller's buffers */
+	FS_WAITER_ABANDONED		/* the caller gave up before the service got to it */
+} fs_waiter_state_t;
+
+/* what a fs_service_call() waits on */
+typedef struct fs_waiter {
+	SemaphoreHandle_t done;			/* given by the service when it's done with the request */
+	uint8_t state;					/* fs_waiter_state_t, changed in critical sections */
+	s32_t result;
+} fs_waiter_t;
+
+static fs_waiter_t waiters[FS_SERVICE_WAITERS];
+
+/* cached descriptors for range reads, so a dump doesn't open the file for every block */
+typedef struct fs_reader {
+	spiffs_file fd;					/* 0 when closed, SPIFFS fds start at 1 */
+	char name[3];
+	uint32_t generation;
+	TickType_t last_tick;
+	bool mapped;
+	spiffs_ix_map map;
+	spiffs_page_ix map_buf[FS_SERVICE_MAP_PAGES];
+} fs_reader_t;
+
+static fs_reader_t readers[FS_SERVICE_READERS];
+
+/* Private functions */
+static s32_t handle_noMutex(const fs_request_t *req);
+static s32_t handle_state_noMutex(const fs_request_t *req);
+static QueueHandle_t lane(uint8_t type);
+static bool take_logs();
+static void serve_state();
+static s32_t handle_read_noMutex(const fs_request_t *req);
+static fs_reader_t *open_reader_noMutex(char prefix, char suffix);
+static void close_reader_noMutex(fs_reader_t *r);
+static void map_window_noMutex(fs_reader_t *r, uint32_t offset, uint32_t size);
+static fs_waiter_t *get_waiter();
+static bool start(const fs_request_t *req);
+static void complete(const fs_request_t *req, s32_t res);
+
+/* fs_service_init
+ * 	- creates the request queues and the waiters' semaphores. vMainTask calls it before it starts any task that logs
+ */
+void fs_service_init() {
+	uint8_t i;
+
+	xFsServiceQueue = xQueueCreate(FS_SERVICE_QUEUE_LENGTH, sizeof(fs_request_t));
+	xFsStateQueue = xQueueCreate(FS_SERVICE_STATE_QUEUE_LENGTH, sizeof(fs_request_t));
+	wake = xSemaphoreCreateBinary();
+	for (i = 0; i < FS_SERVICE_WAITERS; i++) {
+		waiters[i].done = xSemaphoreCreateBinary();
+		waiters[i].state = FS_WAITER_FREE;
+	}
+}
+
+/* fs_service_start
+ * 	- the calling task is the service from now on, its own fs_service_call()s are handled directly
+ * 	- the lifecycle task calls it before sfu_fs_start, which already goes through the service
+ */
+void fs_service_start() {
+	service_task = xTaskGetCurrentTaskHandle();
+}
+
+/* fs_service_post
+ * 	- queues a request that nobody waits for. Returns false (and counts it) if the queue is full
+ */
+bool fs_service_post(fs_request_t *req) {
+	QueueHandle_t q = lane(req->type);
+
+	req->waiter = NULL;
+	if (q == NULL || xQueueSend(q, req, 0) != pdPASS) {
+		fs_service_stats.dropped++;
+		return false;
+	}
+	xSemaphoreGive(wake);
+	return true;
+}
+
+/* fs_service_call
+ * 	- queues req and waits until the service has handled it. Returns the request's result
+ * 	- SPIFFS_SFU_ERR_BUSY if the service didn't start on req within FS_SERVICE_CALL_TIMEOUT (or all the waiters are
+ * 	  in use). req is dropped then: the service skips it when it comes out of the queue
+ * 	- once the service has started on req it has the caller's buffers, so the caller can't leave before it's done.
+ * 	  That part is bounded by the request itself: the service holds the mutex, and every flash wait times out
+ * 	- req->waiter is filled in here
+ */
+s32_t fs_service_call(fs_request_t *req) {
+	QueueHandle_t q = lane(req->type);
+	s32_t res = SPIFFS_SFU_ERR_BUSY;
+	TickType_t begin;
+	TickType_t waited;
+	fs_waiter_t *w;
+	bool started;
+
+	if (service_task != NULL && xTaskGetCurrentTaskHandle() == service_task) {
+		/* the service task can't wait for itself */
+		req->waiter = NULL;
+		if (q == xFsStateQueue) {
+			if (in_state) {
+				return handle_state_noMutex(req);
+			}
+			if (xSemaphoreTake(spiffsStateMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
+				res = handle_state_noMutex(req);
+				xSemaphoreGive(spiffsStateMutex);
+			}
+			return res;
+		}
+		if (in_batch) {
+			return handle_noMutex(req);
+		}
+		if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
+			res = handle_noMutex(req);
+			xSemaphoreGive(spiffsTopMutex);
+		}
+		return res;
+	}
+
+	w = get_waiter();
+	if (w == NULL) {
+		fs_service_stats.call_timeouts++;
+		return SPIFFS_SFU_ERR_BUSY;
+	}
+	req->waiter = w;
+	begin = xTaskGetTickCount();
+	if (q == NULL || xQueueSend(q, req, FS_SERVICE_CALL_TIMEOUT) != pdPASS) {
+		w->state = FS_WAITER_FREE; /* never queued, the service won't see it */
+		fs_service_stats.call_timeouts++;
+		return SPIFFS_SFU_ERR_BUSY;
+	}
+	xSemaphoreGive(wake);
+	waited = xTaskGetTickCount() - begin;
+	if (xSemaphoreTake(w->done, (waited < FS_SERVICE_CALL_TIMEOUT) ? FS_SERVICE_CALL_TIMEOUT - waited : 0) != pdTRUE) {
+		taskENTER_CRITICAL();
+		started = (w->state != FS_WAITER_QUEUED);
+		if (!started) {
+			w->state = FS_WAITER_ABANDONED; /* the service frees it */
+		}
+		taskEXIT_CRITICAL();
+		if (!started) {
+			fs_service_stats.call_timeouts++;
+			return SPIFFS_SFU_ERR_BUSY;
+		}
+		xSemaphoreTake(w->done, portMAX_DELAY);
+	}
+	res = w->result;
+	w->state = FS_WAITER_FREE;
+	return res;
+}
+
+/* fs_service_step
+ * 	- waits up to wait ticks for a request. Serves the state lane, then handles the first logs request and whatever
+ * 	  else is queued behind it (up to FS_SERVICE_BATCH) in a single spiffsTopMutex hold
+ */
+void fs_service_step(TickType_t wait) {
+	fs_request_t req;
+	uint32_t count = 0;
+	uint8_t i;
+
+	if (uxQueueMessagesWaiting(xFsServiceQueue) == 0 && uxQueueMessagesWaiting(xFsStateQueue) == 0) {
+		xSemaphoreTake(wake, wait);
+	}
+	serve_state();
+	if (xQueueReceive(xFsServiceQueue, &req, 0) != pdPASS) {
+		/* idle, let go of the read descriptors nobody's been using */
+		for (i = 0; i < FS_SERVICE_READERS; i++) {
+			if (readers[i].fd > 0 && (xTaskGetTickCount() - readers[i].last_tick) >= FS_SERVICE_READ_IDLE
+					&& take_logs()) {
+				close_reader_noMutex(&readers[i]);
+				xSemaphoreGive(spiffsTopMutex);
+			}
+		}
+		return;
+	}
+
+	if (!take_logs()) {
+		fs_service_stats.mutex_fails++;
+		if (start(&req)) {
+			complete(&req, SPIFFS_SFU_ERR_BUSY);
+		}
+		serialSendQ("FSwe: can't get top mutex");
+		return;
+	}
+	in_batch = true;
+	do {
+		if (start(&req)) {
+			complete(&req, handle_noMutex(&req));
+		}
+		count++;
+	} while (count < FS_SERVICE_BATCH && xQueueReceive(xFsServiceQueue, &req, 0) == pdPASS);
+	in_batch = false;
+	xSemaphoreGive(spiffsTopMutex);
+	serve_state(); /* the flags the batch changed */
+
+	fs_service_stats.requests += count;
+	fs_service_stats.batches++;
+	if (count > fs_service_stats.max_batch) {
+		fs_service_stats.max_batch = count;
+	}
+	if (fs_service_stats.dropped != dropped_reported) {
+		dropped_reported = fs_service_stats.dropped;
+		DLOG_SERIAL("FSdrop: %d", dropped_reported);
+	}
+}
+
+/* fs_service_commit_flags
+ * 	- wakes the service to commit the dirty flags (flagCommit_noMutex). Used by flagMarkDirty
+ * 	- false if the state lane was full. The next pass of the lane picks the flags up anyway
+ */
+bool fs_service_commit_flags() {
+	fs_request_t req;
+	req.type = FS_REQ_FLAGS;
+	return fs_service_post(&req);
+}
+
+void fs_service_close_reader_noMutex() {
+	// CALL WITHIN MUTEX
+	uint8_t i;
+
+	for (i = 0; i < FS_SERVICE_READERS; i++) {
+		close_reader_noMutex(&readers[i]);
+	}
+}
+
+static s32_t handle_noMutex(const fs_request_t *req) {
+	// CALL WITHIN MUTEX
+	s32_t res = 0;
+
+	switch (req->type) {
+		case FS_REQ_TEXT:
+			res = fs_record_write_text_noMutex(req->suffix, req->time, req->text);
+			if (res < 0) {
+				DLOG_SERIAL("FNww: %d", res);
+			}
+			break;
+		case FS_REQ_FIELDS:
+			res = fs_record_write_fields_noMutex(req->suffix, req->time, (log_record_type_t)req->record.type, req->record.fields, req->num);
+			if (res < 0) {
+				DLOG_SERIAL("FRww: %d", res);
+			}
+			break;
+		case FS_REQ_DEFERRED:
+			res = fs_record_write_deferred_noMutex(req->suffix, req->time, req->deferred.id, req->deferred.args, req->num);
+			if (res < 0) {
+				DLOG_SERIAL("FDww: %d", res);
+			}
+			break;
+		case FS_REQ_READ:
+			res = handle_read_noMutex(req);
+			break;
+		case FS_REQ_ROTATE:
+			fs_service_close_reader_noMutex(); /* it may be on a file that's about to be deleted */
+			sfu_rotate_noMutex();
+			break;
+		case FS_REQ_FLUSH:
+			sfu_flush_logs_noMutex(0);
+			res = SPIFFS_SFU_ERR_BUSY;
+			if (xSemaphoreTake(spiffsStateMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
+				res = handle_state_noMutex(req);
+				xSemaphoreGive(spiffsStateMutex);
+			}
+			if (res < 0) {
+				DLOG_SERIAL("FWwe: %d", res);
+				res = 0; /* the logs made it */
+			}
+			break;
+		case FS_REQ_FLUSH_STALE:
+			sfu_flush_logs_noMutex(FS_APPENDER_STAGE_TIMEOUT);
+			break;
+		case FS_REQ_CREATE:
+		case FS_REQ_ERASE_CHIP:
+			/* the flag file and the erase counts are on the state partition, and a chip erase starts it over */
+			if (xSemaphoreTake(spiffsStateMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) != pdTRUE) {
+				return SPIFFS_SFU_ERR_BUSY;
+			}
+			if (req->type == FS_REQ_CREATE) {
+				sfu_create_all_files_noMutex();
+			} else {
+				res = sfu_erase_chip_noMutex(); /* formats and mounts both partitions again itself */
+			}
+			xSemaphoreGive(spiffsStateMutex);
+			return res;
+		case FS_REQ_FIND:
+			res = sfu_find_log_range_noMutex(req->find.prefix, req->suffix, req->find.t0, req->find.t1, req->find.starts,
+					req->find.ends);
+			break;
+		case FS_REQ_SYNC:
+		default:
+			break;
+	}
+	return my_spiffs_check_error(res);
+}
+
+/* handle_state_noMutex
+ * 	- the state lane's requests, with spiffsStateMutex held. FS_REQ_FLAGS has nothing to do, every pass of the lane
+ * 	  commits the dirty flags anyway
+ * 	- FS_REQ_FLUSH is the state half of a flush, from handle_noMutex. Flushes are for resets, so the dirty flags and
+ * 	  the erase counts go out too
+ */
+static s32_t handle_state_noMutex(const fs_request_t *req) {
+	// CALL WITHIN spiffsStateMutex
+	s32_t res;
+
+	switch (req->type) {
+		case FS_REQ_FLUSH:
+			res = flagCommit_noMutex();
+			if (res < 0) {
+				DLOG_SERIAL("FFww: %d", res);
+			}
+			return my_spiffs_state_check_error(fs_wear_save_noMutex());
+		case FS_REQ_WEAR_SAVE:
+			return my_spiffs_state_check_error(fs_wear_save_noMutex());
+		case FS_REQ_FLAGS_WRITE:
+			return my_spiffs_state_check_error(flag_store_write_noMutex(req->flags));
+		case FS_REQ_FLAGS_READ:
+			return my_spiffs_state_check_error(flag_store_load_noMutex(req->flags));
+		case FS_REQ_FLAGS:
+		default:
+			return 0;
+	}
+}
+
+/* lane
+ * 	- the queue a request of type goes in
+ */
+static QueueHandle_t lane(uint8_t type) {
+	switch (type) {
+		case FS_REQ_FLAGS:
+		case FS_REQ_WEAR_SAVE:
+		case FS_REQ_FLAGS_WRITE:
+		case FS_REQ_FLAGS_READ:
+			return xFsStateQueue;
+		default:
+			return xFsServiceQueue;
+	}
+}
+
+/* take_logs
+ * 	- spiffsTopMutex, waiting up to SPIFFS_READ_TIMEOUT_MS for it like everyone else. The wait is in
+ * 	  FS_SERVICE_STATE_SLICE steps, with the state lane served in between
+ */
+static bool take_logs() {
+	uint32_t i;
+
+	for (i = 0; i < pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS) / FS_SERVICE_STATE_SLICE; i++) {
+		if (xSemaphoreTake(spiffsTopMutex, FS_SERVICE_STATE_SLICE) == pdTRUE) {
+			return true;
+		}
+		fs_service_stats.state_slices++;
+		serve_state();
+	}
+	return false;
+}
+
+/* serve_state
+ * 	- handles what's in the state lane (up to FS_SERVICE_BATCH), then commits every flag changed since the last pass
+ * 	  in one record. Only ever takes spiffsStateMutex, so it goes ahead whoever has the logs
+ * 	- if the mutex times out the requests stay queued for the next pass
+ */
+static void serve_state() {
+	fs_request_t req;
+	uint32_t count = 0;
+	s32_t res;
+
+	if (spiffsStateMutex == NULL) {
+		return; /* sfusat_spiffs_init hasn't run yet */
+	}
+	if (xSemaphoreTake(spiffsStateMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) != pdTRUE) {
+		fs_service_stats.mutex_fails++;
+		return;
+	}
+	in_state = true;
+	while (count < FS_SERVICE_BATCH && xQueueReceive(xFsStateQueue, &req, 0) == pdPASS) {
+		if (start(&req)) {
+			complete(&req, handle_state_noMutex(&req));
+		}
+		count++;
+	}
+	res = flagCommit_noMutex();
+	if (res < 0) {
+		DLOG_SERIAL("FFww: %d", res);
+	}
+	in_state = false;
+	xSemaphoreGive(spiffsStateMutex);
+	fs_service_stats.state_requests += count;
+}
+
+/* handle_read_noMutex
+ * 	- reads up to size bytes at offset. Returns the number of bytes read, 0 at (or past) the end of the file
+ * 	- staged appender data is only written out if the read reaches into it
+ */
+static s32_t handle_read_noMutex(const fs_request_t *req) {
+	// CALL WITHIN MUTEX
+	fs_appender_t *app;
+	fs_reader_t *r;
+	spiffs_stat s;
+	s32_t res;
+
+	my_spiffs_mount();
+
+	if (req->read.prefix == getCurrentPrefix()) {
+		app = fs_appender_get(req->suffix);
+		/* circular logs have data after head from the last lap, only flush when the read overlaps the staged bytes */
+		if (app != NULL && app->staged > 0 && req->read.offset < app->size + app->staged
+				&& req->read.offset + req->read.size > app->size) {
+			fs_appender_flush_noMutex(req->suffix);
+		}
+	}
+
+	r = open_reader_noMutex(req->read.prefix, req->suffix);
+	if (r == NULL) {
+		return SPIFFS_errno(&fs);
+	}
+	r->last_tick = xTaskGetTickCount();
+
+	if (req->read.file_size != NULL) {
+		if (SPIFFS_fstat(&fs, r->fd, &s) < 0) {
+			res = SPIFFS_errno(&fs);
+			close_reader_noMutex(r);
+			return res;
+		}
+		*req->read.file_size = s.size;
+	}
+
+	map_window_noMutex(r, req->read.offset, req->read.size);
+	res = SPIFFS_lseek(&fs, r->fd, req->read.offset, SPIFFS_SEEK_SET);
+	if (res >= 0 && req->read.size > 0) {
+		res = SPIFFS_read(&fs, r->fd, req->read.buf, req->read.size);
+	}
+	if (res < 0) {
+		if (SPIFFS_errno(&fs) == SPIFFS_ERR_END_OF_OBJECT) {
+			return 0;
+		}
+		res = SPIFFS_errno(&fs);
+		close_reader_noMutex(r);
+		return res;
+	}
+	return (req->read.size > 0) ? res : 0;
+}
+
+/* open_reader_noMutex
+ * 	- the cached descriptor for prefix + suffix, or a new one in place of a closed or the least recently used one
+ * 	- NULL if the file can't be opened, SPIFFS_errno has why
+ */
+static fs_reader_t *open_reader_noMutex(char prefix, char suffix) {
+	// CALL WITHIN MUTEX
+	fs_reader_t *r = &readers[0];
+	uint8_t i;
+
+	for (i = 0; i < FS_SERVICE_READERS; i++) {
+		if (readers[i].fd > 0 && readers[i].generation != spiffs_mount_generation) {
+			readers[i].fd = 0; /* the mount closed it */
+		}
+		if (readers[i].fd > 0 && readers[i].name[0] == prefix && readers[i].name[1] == suffix) {
+			return &readers[i];
+		}
+		if (r->fd > 0 && (readers[i].fd <= 0 || (int32_t)(readers[i].last_tick - r->last_tick) < 0)) {
+			r = &readers[i];
+		}
+	}
+
+	close_reader_noMutex(r);
+	r->name[0] = prefix;
+	r->name[1] = suffix;
+	r->name[2] = '\0';
+	r->fd = SPIFFS_open(&fs, r->name, SPIFFS_RDONLY, 0);
+	r->generation = spiffs_mount_generation;
+	if (r->fd < 0) {
+		r->fd = 0;
+		return NULL;
+	}
+	fs_service_stats.reader_opens++;
+	return r;
+}
+
+/* map_window_noMutex
+ * 	- makes sure the pages of a read at offset are in r's index map window, mapping a new descriptor or moving the
+ * 	  window to the pages of the object index page that offset's page is in. Filling the window in then only has to
+ * 	  find that one index page (the first window also reaches into the second one, the header's index is shorter)
+ * 	- if that fails the reads still work, they just look the pages up the slow way. The next read tries again
+ */
+static void map_window_noMutex(fs_reader_t *r, uint32_t offset, uint32_t size) {
+	// CALL WITHIN MUTEX
+	uint32_t first = offset / SPIFFS_DATA_PAGE_SIZE(&fs);
+	uint32_t last = (offset + size) / SPIFFS_DATA_PAGE_SIZE(&fs);
+	uint32_t start = SPIFFS_DATA_SPAN_IX_FOR_OBJ_IX_SPAN_IX(&fs, SPIFFS_OBJ_IX_ENTRY_SPAN_IX(&fs, first))
+			* SPIFFS_DATA_PAGE_SIZE(&fs);
+	s32_t res;
+
+	if (!fs_service_ix_maps) {
+		return;
+	}
+	if (!r->mapped) {
+		res = SPIFFS_ix_map(&fs, r->fd, &r->map, start, SPIFFS_ix_map_entries_to_bytes(&fs, FS_SERVICE_MAP_PAGES - 1),
+				r->map_buf);
+	} else if (first < r->map.start_spix || last > r->map.end_spix) {
+		fs_service_stats.map_moves++;
+		res = SPIFFS_ix_remap(&fs, r->fd, start);
+	} else {
+		return;
+	}
+
+	r->mapped = (res >= 0);
+	if (res < 0) {
+		fs_service_stats.map_fails++;
+		DLOG_SERIAL("FSmap: %d", SPIFFS_errno(&fs));
+		SPIFFS_ix_unmap(&fs, r->fd); /* a window that failed to move is only half filled in */
+	}
+}
+
+static void close_reader_noMutex(fs_reader_t *r) {
+	// CALL WITHIN MUTEX
+	if (r->fd > 0 && r->generation == spiffs_mount_generation) {
+		SPIFFS_close(&fs, r->fd); /* drops the map too */
+	}
+	r->fd = 0;
+	r->mapped = false;
+}
+
+/* get_waiter
+ * 	- a free waiter, marked queued. NULL if they're all in use
+ */
+static fs_waiter_t *get_waiter() {
+	fs_waiter_t *w = NULL;
+	uint8_t i;
+
+	taskENTER_CRITICAL();
+	for (i = 0; i < FS_SERVICE_WAITERS; i++) {
+		if (waiters[i].done != NULL && waiters[i].state == FS_WAITER_FREE) {
+			w = &waiters[i];
+			w->state = FS_WAITER_QUEUED;
+			break;
+		}
+	}
+	taskEXIT_CRITICAL();
+	return w;
+}
+
+/* start
+ * 	- false if req's caller has given up on it. Its waiter is free again and req must not be handled
+ * 	- otherwise the caller waits for req from here on, however long it takes
+ */
+static bool start(const fs_request_t *req) {
+	bool abandoned = false;
+
+	if (req->waiter == NULL) {
+		return true;
+	}
+	taskENTER_CRITICAL();
+	if (req->waiter->state == FS_WAITER_ABANDONED) {
+		req->waiter->state = FS_WAITER_FREE;
+		abandoned = true;
+	} else {
+		req->waiter->state = FS_WAITER_STARTED;
+	}
+	taskEXIT_CRITICAL();
+	return !abandoned;
+}
+
+static void complete(const fs_request_t *req, s32_t res) {
+	if (req->waiter != NULL) {
+		req->waiter->result = res;
+		xSemaphoreGive(req->waiter->done);
+	}
+}
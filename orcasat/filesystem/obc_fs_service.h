@@ -0,0 +1,151 @@
+/*
+ * obc_fs_service.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Filesystem service: the lifecycle task ("fs") owns SPIFFS and everyone else sends it requests.
+ *
+ *      Loggers used to take spiffsTopMutex themselves and wait up to SPIFFS_READ_TIMEOUT_MS for it, which is as long as a
+ *      rotation or a GC can take. Now sfu_write_fname(), sfu_write_fields() and sfu_write_deferred() copy the entry into
+ *      an fs_request_t and post it to xFsServiceQueue without waiting. If the queue is full the entry is dropped and
+ *      counted (fs_service_stats.dropped), the caller never blocks on flash.
+ *
+ *      The service takes the mutex once per batch and handles up to FS_SERVICE_BATCH queued requests in one hold.
+ *      Coalescing:
+ *      	- appends to the same log end up in its appender stage and go out as full data pages (obc_fs_appender.h)
+ *      	- flag writes only mark the flag dirty (flagMarkDirty). The state lane commits every dirty flag with its latest
+ *      	  value in one flag store record
+ *      	- range reads keep up to FS_SERVICE_READERS files open, so consecutive reads of a file reuse its descriptor
+ *      	- each cached descriptor gets an index map (SPIFFS_ix_map) of a window of FS_SERVICE_MAP_PAGES data pages, the
+ *      	  ones the object index page of its first read lists. A seek used to look the file's index page up in the lookup
+ *      	  pages of every block, now a page in the window is read straight away. A read outside the window moves it to
+ *      	  that read's index page (SPIFFS_ix_remap), which is the same one lookup an unmapped seek does. SPIFFS keeps the
+ *      	  map up to date as the file is written and GC moves its pages
+ *
+ *      Requests that return something (range reads, flush, sync, chip erase, flags) block the caller until the service
+ *      has handled them. Apart from the state lane's, they're in FIFO order with the appends, so a flush or read sees
+ *      everything logged before it.
+ *      Nothing but the service and the GC task takes spiffsTopMutex or spiffsStateMutex for SPIFFS calls.
+ *      The caller waits on a semaphore from a small pool of waiters, not on its task notification, which stays free
+ *      for the task's own use. If the service doesn't start on the request within FS_SERVICE_CALL_TIMEOUT the caller
+ *      gets SPIFFS_SFU_ERR_BUSY, and the service drops the request when it comes out of the queue. Once the service
+ *      has started on it, the caller waits for it to finish, since the request points at the caller's buffers.
+ *      When the service task itself makes one of these calls, it's handled directly instead of going through the queue.
+ *
+ *      The state partition has a lane of its own. Flag commits, whole flag table reads and writes and erase count saves
+ *      go to xFsStateQueue, and the service handles them under spiffsStateMutex alone: before each batch, after it (for
+ *      the flags the batch changed, like a rotation's PREFIX_FLAG), and every FS_SERVICE_STATE_SLICE while it waits for
+ *      spiffsTopMutex. A GC or check step can hold spiffsTopMutex for half a second, which a flag commit used to wait
+ *      out. The lane isn't in order with the appends, nothing on it needs to be. Posting to either queue gives the
+ *      semaphore the service sleeps on when it's idle, not its task notification: the flash driver waits on that for
+ *      every transfer (flash_mibspi.h).
+ *
+ *      fs_service_step() is everything the task does for one batch, so it can also be driven by something other than
+ *      the lifecycle loop (tests).
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_SERVICE_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_SERVICE_H_
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "rtos_task.h"
+#include "rtos_queue.h"
+#include "spiffs.h"
+#include "obc_fs_structure.h"
+#include "obc_fs_record.h"
+#include "obc_fs_circular.h"
+
+#define FS_SERVICE_QUEUE_LENGTH		16
+#define FS_SERVICE_STATE_QUEUE_LENGTH	4					/* the state lane: flags and erase counts */
+#define FS_SERVICE_STATE_SLICE		pdMS_TO_TICKS(50)		/* how often the state lane is served while the logs are busy */
+#define FS_SERVICE_BATCH			16						/* most requests handled per mutex hold */
+#define FS_SERVICE_READ_IDLE		pdMS_TO_TICKS(2000)		/* cached read fds are closed after this long without reads */
+#define FS_SERVICE_READERS			2						/* cached read fds, a downlink and a range query can interleave */
+#define FS_SERVICE_WAITERS			4						/* fs_service_call()s that can wait at once */
+#define FS_SERVICE_CALL_TIMEOUT		pdMS_TO_TICKS(10000)	/* longest a call waits for the service to start on it: a queue
+																	   full of appends and the service's own wait for the mutex */
+#define FS_SERVICE_MAP_PAGES		((LOG_PAGE_SIZE - sizeof(spiffs_page_object_ix)) / sizeof(spiffs_page_ix)) /* index map
+																	   window per reader: what one object index page holds */
+
+typedef enum fs_request_type {
+	FS_REQ_TEXT,		/* append a text record */
+	FS_REQ_FIELDS,		/* append a record of integer fields */
+	FS_REQ_DEFERRED,	/* append a deferred format record */
+	FS_REQ_READ,		/* read part of a file into the caller's buffer */
+	FS_REQ_FLAGS,		/* commit the dirty flags (state lane) */
+	FS_REQ_ROTATE,		/* move to the next prefix (sfu_rotate_noMutex) */
+	FS_REQ_FLUSH,		/* write out everything staged, and the erase counts (obc_fs_wear.h) */
+	FS_REQ_FLUSH_STALE,	/* write out what's been staged for FS_APPENDER_STAGE_TIMEOUT */
+	FS_REQ_WEAR_SAVE,	/* save the erase counts (state lane) */
+	FS_REQ_CREATE,		/* create the flag file and the current log set where they don't exist */
+	FS_REQ_ERASE_CHIP,	/* erase the flash and start the filesystem over (sfu_erase_chip) */
+	FS_REQ_FIND,		/* where in a log its records between two times are (sfu_find_log_range_noMutex) */
+	FS_REQ_FLAGS_WRITE,	/* append the whole flag table to the flag store (state lane) */
+	FS_REQ_FLAGS_READ,	/* load the newest flag store copy into the caller's table (state lane) */
+	FS_REQ_SYNC			/* nothing, just wait for the requests ahead of it */
+} fs_request_type_t;
+
+typedef struct fs_request {
+	uint8_t type;					/* fs_request_type_t */
+	char suffix;
+	uint8_t num;					/* number of fields/args */
+	uint32_t time;					/* RTC time for appends */
+	struct fs_waiter *waiter;		/* signalled when done, NULL for fire and forget requests */
+	union {
+		char text[SFU_WRITE_DATA_BUF];
+		struct {
+			uint8_t type;			/* log_record_type_t */
+			int32_t fields[LOG_RECORD_MAX_FIELDS];
+		} record;
+		struct {
+			uint32_t id;
+			int32_t args[LOG_RECORD_MAX_FIELDS];
+		} deferred;
+		struct {
+			char prefix;
+			uint32_t offset;
+			uint32_t size;
+			uint8_t *buf;
+			uint32_t *file_size;	/* optional, size of the file when it was read */
+		} read;
+		struct {
+			char prefix;
+			uint32_t t0;
+			uint32_t t1;
+			uint32_t *starts;		/* FS_CIRC_MAX_RANGES each */
+			uint32_t *ends;
+		} find;
+		flag_memory_table_t *flags;
+	};
+} fs_request_t;
+
+typedef struct fs_service_stats {
+	uint32_t requests;
+	uint32_t dropped;				/* appends that didn't fit in the queue */
+	uint32_t batches;
+	uint32_t max_batch;
+	uint32_t mutex_fails;			/* batches dropped because the mutex timed out */
+	uint32_t state_requests;		/* handled on the state lane */
+	uint32_t state_slices;			/* state lane passes while waiting for spiffsTopMutex */
+	uint32_t call_timeouts;			/* fs_service_call()s that gave up before the service started on them */
+	uint32_t reader_opens;			/* read fds opened */
+	uint32_t map_moves;				/* index map windows moved to a read outside them */
+	uint32_t map_fails;				/* index maps that couldn't be built or moved */
+} fs_service_stats_t;
+
+extern QueueHandle_t xFsServiceQueue;	/* created in vMainTask */
+extern QueueHandle_t xFsStateQueue;		/* the state lane, created with it */
+extern fs_service_stats_t fs_service_stats;
+extern bool fs_service_ix_maps;		/* map new read fds. On by default, off to compare */
+
+void fs_service_init();												/* request queues and waiters, before any task makes requests */
+void fs_service_start();											/* the calling task becomes the service */
+bool fs_service_post(fs_request_t *req);							/* fire and forget, never blocks */
+s32_t fs_service_call(fs_request_t *req);							/* waits until the service handled req, or gives up */
+void fs_service_step(TickType_t wait);								/* service task: wait up to wait for requests and handle a batch */
+void fs_service_close_reader_noMutex();								/* drop the cached read descriptors */
+bool fs_service_commit_flags();										/* wake the service to commit the dirty flags */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_SERVICE_H_ */
@@ -15,9 +15,20 @@
 #include "obc_tasks.h"
 #include "obc_task_logging.h"
 #include "obc_flags.h"
+#include "obc_fs_appender.h"
+#include "obc_fs_record.h"
+#include "obc_fs_index.h"
+#include "obc_fs_circular.h"
+#include "obc_fs_objects.h"
+#include "obc_fs_service.h"
+#include "obc_flag_store.h"
+#include "obc_flag_fee.h"
+#include "obc_fs_wear.h"
+#include "obc_dlog.h"
 #include "filesystem_test_tasks.h"
 
 uint32_t fs_num_increments;
+fs_rotation_stats_t fs_rotation_stats;
 char sfu_prefix; 					// filesystem prefix
 
 // * Todo:
@@ -26,96 +37,289 @@ char sfu_prefix; 					// filesystem prefix
 // fs rescue task
 
 /* Private functions */
-static void refresh_files(); 									/* handles deletion and creation. Note: takes about a second to run */
 static void sfu_create_log_files_noMutex(); 								/* creates files w/ current prefix and records creation time */
-static void sfu_create_all_files(); 						/* creates files w/ current prefix and records creation time, wrapped in mutex */
+static void sfu_create_all_files(); 						/* creates files w/ current prefix and records creation time, through the service */
 static void sfu_create_persistent_files_noMutex();
 static void create_filename(char* namebuf, char file_suffix); /* creates filename with appropriate prefix and suffix */
-static void sfu_write_fname_offset_noMutex(char f_suffix, uint32_t offset, char *fmt, ...);
-static void sfu_read_fname_offset_noMutex(char f_suffix, uint8_t* outbuf, uint8_t size, uint32_t offset);
-static void format_entry(char* buf, char *fmt, va_list argptr); /* formats our file entries with timestamp and data */
-static void write_fd(spiffs_file fd, char *fmt, ...); 			/* printf style write to an already open file */
+static void format_entry(char* buf, char *fmt, va_list argptr); /* formats the text of a text log record */
+static void write_log_noMutex(char f_suffix, char *fmt, ...); 	/* printf style write to a log through its appender */
 static void sfu_delete_prefix_noMutex(const char prefix); 				/* deletes the files with the specified prefix */
 static void increment_prefix_noMutex();
-static void sfu_write_fname_offset(char f_suffix, uint32_t offset, char *fmt, ...);
-static void sfu_read_fname_offset(char f_suffix, uint8_t* outbuf, uint8_t size, uint32_t offset);
-static void writeAllFlagsToFlash_noMutex();
-static bool readAllFlagsFromFlash_noMutex(flag_memory_table_wrap_t *flagWrap);
+static void set_log_prefix(); 									/* picks the prefix the logs are written under */
+static void dump_file_range(char prefix, char suffix, uint32_t start, uint32_t end); /* streams part of a file out on the UART */
 
 /* Filesystem Lifecycle
  * - creates and deletes files when they're old
+ * - this is also the filesystem service task. Everything else sends it requests, see obc_fs_service.h
  */
 void vFilesystemLifecycleTask(void *pvParameters) {
-	sfu_fs_init();
+	TickType_t lastRefresh;
+	TickType_t lastFlush;
+	TickType_t lastWearSave;
+	TickType_t now;
+#ifndef FSYS_CIRCULAR_LOGS
+	fs_request_t req;
+#endif
+
+	fs_service_start();
+	sfu_fs_start();
+//	fs_test_tasks();	// Only enable for testing
+
+	lastRefresh = xTaskGetTickCount();
+	lastFlush = lastRefresh;
+	lastWearSave = lastRefresh;
 	while (1) {
-		if(fs_num_increments == 0){
-			sfusat_spiffs_init();
-			sfu_create_all_files();
-//			fs_test_tasks();	// Only enable for testing
+		/* handle requests, but wake up often enough to write out log pages that have been staged for too long */
+		now = xTaskGetTickCount();
+		fs_service_step((now - lastFlush < FSYS_FLUSH_INTERVAL) ? FSYS_FLUSH_INTERVAL - (now - lastFlush) : 0);
+
+		now = xTaskGetTickCount();
+		if (now - lastFlush >= FSYS_FLUSH_INTERVAL) {
+			lastFlush = now;
+			sfu_flush_stale_logs();
+		}
+		if (now - lastWearSave >= FS_WEAR_SAVE_INTERVAL) {
+			lastWearSave = now;
+			fs_wear_save();
 		}
-		vTaskDelay(FSYS_LOOP_INTERVAL);
-		refresh_files(); // this handles deletion and creation
-		volatile uint32_t level;
-		level = uxTaskGetStackHighWaterMark( NULL);
+#ifndef FSYS_CIRCULAR_LOGS
+		if (now - lastRefresh >= FSYS_LOOP_INTERVAL) {
+			lastRefresh = now;
+			/* queued behind the entries already waiting, so they still go into the outgoing set */
+			req.type = FS_REQ_ROTATE;
+			if (!fs_service_post(&req)) {
+				fs_service_call(&req);
+			}
+		}
+#endif
 	}
 }
 
 
+/* sfu_fs_start
+ * - brings the filesystem up: our state, the SPIFFS mounts, then the current file set
+ * - the lifecycle task does this before it starts serving requests. Nothing else may touch SPIFFS before it's done
+ */
+void sfu_fs_start() {
+	sfu_fs_init();
+	sfusat_spiffs_init();
+	sfu_create_all_files();
+}
+
+/* sfu_erase_chip
+ * - "file erase" and "wd f_reset": wipes the flash and starts the filesystem over on it
+ * - the appenders and the service's readers let go of their fds first, and everything in RAM that describes files
+ *   (appenders, time index, object table) starts over. The flags in RAM go back into a new flag store, and the
+ *   current log set is created again
+ * - staged log entries are dropped, their files are gone
+ * - runs on the filesystem service behind whatever is queued. SPIFFS_SFU_ERR_BUSY if the service didn't get to it
+ */
+s32_t sfu_erase_chip() {
+	fs_request_t req;
+
+	req.type = FS_REQ_ERASE_CHIP;
+	return fs_service_call(&req);
+}
+
+s32_t sfu_erase_chip_noMutex() {
+	// CALL WITHIN BOTH MUTEXES
+	s32_t res;
+
+	fs_appender_close_all_noMutex();
+	fs_service_close_reader_noMutex();
+	res = my_spiffs_erase_chip();
+
+	fs_num_increments = 0;
+	fs_appender_init();
+	fs_index_init();
+	fs_objects_init();
+	if (res == SPIFFS_OK) {
+		sfu_create_persistent_files_noMutex();
+		sfu_create_log_files_noMutex();
+		res = fs_wear_save_noMutex(); /* the only copy of the lifetime counts is in RAM now */
+	}
+	return res;
+}
+
 /* Dump file
- * - reads a chunk of a file, then prints it out on the UART
+ * - streams a whole file out on the UART
  * - used for downloading an entire file
  * */
 void dumpFile(char prefix, char suffix){
-	spiffs_file fd = -1;
-	spiffs_stat s;
-	int16_t res;
+	dump_file_range(prefix, suffix, 0, DUMP_TO_END);
+}
+
+/* Dump log range
+ * - streams the parts of a subsystem's logs that hold records between t0 and t1 (RTC time, inclusive)
+ * - looks each prefix up in its time index (obc_fs_index.h), oldest first, and dumps the range it gives
+ *   in the same format as dumpFile. Data just outside the window can come along, the ground filters it
+ * - logs without an index (or that don't overlap the window) are skipped
+ * - a circular log is searched by page (obc_fs_circular.h). Its header page goes out first so the ground
+ *   knows the page layout, then up to two ranges in time order
+ * */
+void dumpLogRange(char suffix, uint32_t t0, uint32_t t1){
+	uint32_t starts[FS_CIRC_MAX_RANGES];
+	uint32_t ends[FS_CIRC_MAX_RANGES];
+	fs_request_t req;
+	s32_t res;
+	uint8_t i;
+#ifdef FSYS_CIRCULAR_LOGS
+	req.type = FS_REQ_FIND;
+	req.suffix = suffix;
+	req.find.prefix = FSYS_CIRC_PREFIX;
+	req.find.t0 = t0;
+	req.find.t1 = t1;
+	req.find.starts = starts;
+	req.find.ends = ends;
+	res = fs_service_call(&req);
+	if (res < 0) {
+		DLOG_SERIAL("DRnf: %d", res);
+		return;
+	}
+	if (res > 0) {
+		dump_file_range(FSYS_CIRC_PREFIX, suffix, 0, FS_CIRC_DATA_START);
+	}
+	for (i = 0; i < res; i++) {
+		dump_file_range(FSYS_CIRC_PREFIX, suffix, starts[i], ends[i]);
+	}
+#else
+	uint8_t j;
+
+	for (i = 1; i <= PREFIX_QUANTITY; i++) {
+		req.type = FS_REQ_FIND;
+		req.suffix = suffix;
+		req.find.prefix = PREFIX_START + ((getCurrentPrefix() - PREFIX_START + i) % PREFIX_QUANTITY);
+		req.find.t0 = t0;
+		req.find.t1 = t1;
+		req.find.starts = starts;
+		req.find.ends = ends;
+		res = fs_service_call(&req);
+		if (res < 0) {
+			DLOG_SERIAL("DRnf: %d", res);
+		}
+		for (j = 0; j < res; j++) {
+			dump_file_range(req.find.prefix, suffix, starts[j], ends[j]);
+		}
+	}
+#endif
+}
+
+/* sfu_find_log_range_noMutex
+ * - the parts of a log that hold its records between t0 and t1, for dumpLogRange. Returns how many ranges are in
+ *   starts and ends (at most FS_CIRC_MAX_RANGES), 0 if the log doesn't overlap the window or has no index
+ * - a circular log is searched by page (obc_fs_circular.h), the others with their time index (obc_fs_index.h)
+ * - what's staged goes out first, so the ranges cover everything logged so far
+ */
+s32_t sfu_find_log_range_noMutex(char prefix, char suffix, uint32_t t0, uint32_t t1, uint32_t *starts, uint32_t *ends) {
+	// CALL WITHIN MUTEX
+	s32_t res;
+#ifdef FSYS_CIRCULAR_LOGS
+	fs_appender_t *app;
+
+	my_spiffs_mount();
+	res = fs_appender_flush_noMutex(suffix); /* the head in circ covers everything logged so far */
+	if (res >= 0) {
+		res = fs_appender_open_noMutex(suffix, 0);
+	}
+	if (res >= 0) {
+		app = fs_appender_get(suffix);
+		res = fs_circ_find_noMutex(app->fd, &app->circ, t0, t1, starts, ends);
+	}
+#else
+	my_spiffs_mount();
+	if (prefix == getCurrentPrefix()) {
+		sfu_flush_logs_noMutex(0); /* puts the pending index entries in the sidecar */
+	}
+	res = fs_index_find_noMutex(prefix, suffix, t0, t1, &starts[0], &ends[0]);
+#endif
+	return res;
+}
+
+/* dump_file_range
+ * - streams bytes [start, end) of a file out on the UART. end is clamped to the file size
+ * - the file is read DUMP_BLOCK_SIZE bytes at a time through the filesystem service (sfu_read_range), so loggers
+ *   get the filesystem between blocks while the (slow) UART transmission happens
+ * - binary safe: each DUMP_LINE_BYTES of data go out base64 encoded in a line tagged with their file offset:
+ * 		FILE: <name> <size>
+ * 		DF,<offset>,<base64>
+ * 		...
+ * 		FILE_END: <name>
+ *   tools/log_decode.py --capture rebuilds the file from this
+ * */
+static void dump_file_range(char prefix, char suffix, uint32_t start, uint32_t end){
+	static uint8_t block[DUMP_BLOCK_SIZE];
+	static char line[DUMP_LINE_SIZE];
+	s32_t res;
+	uint32_t size;
+	uint32_t offset = start;
+	uint32_t len;
+	uint32_t i;
 	char fname[3] = {'\0'};
-	char buf[DUMP_BUF_SIZE + 1] = {'\0'}; /* +1 to allow for null, which is required for UART transmission */
 	fname[0] = prefix;
 	fname[1] = suffix;
 
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		my_spiffs_mount();
-		fd = SPIFFS_open(&fs, (const char *)fname, SPIFFS_RDONLY, 0);
+	/* the first read also gets us the size for the header */
+	len = (end - offset < DUMP_BLOCK_SIZE) ? end - offset : DUMP_BLOCK_SIZE;
+	res = sfu_read_range(prefix, suffix, offset, block, len, &size);
+	if (res < 0) {
+		DLOG_SERIAL("DFno: %d", res);
+		return;
+	}
 
-		if (fd < 0) { 	/* if there's an error opening */
-			snprintf(buf, DUMP_BUF_SIZE, "DFno: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
+	if (end > size) {
+		end = size; /* anything appended while we're dumping waits for the next dump */
+	}
+	snprintf(line, DUMP_LINE_SIZE, "FILE: %s %d", fname, size);
+	serialSendln(line);	/* send file name and size */
+
+	while (offset < end) {
+		if (offset != start) {
+			len = (end - offset < DUMP_BLOCK_SIZE) ? end - offset : DUMP_BLOCK_SIZE;
+			res = sfu_read_range(prefix, suffix, offset, block, len, NULL);
 		}
-		else {
-			res = SPIFFS_fstat(&fs,fd , &s);
-			uint32_t i;
-
-			snprintf(buf, DUMP_BUF_SIZE, "FILE: %s %d", fname, s.size);
-			serialSendln(( char*)buf);	/* send file name and size */
-
-			for(i = 0; i < s.size + 1; i += DUMP_BUF_SIZE){ /* loop through, read and transmit DUMP_BUF_SIZE bytes at a time */
-				res = SPIFFS_lseek(&fs, fd, i, SPIFFS_SEEK_SET);	/* lseek increments file index to i'th byte */
-				if(res < 0){
-					snprintf(buf, DUMP_BUF_SIZE, "DFnr: %i", SPIFFS_errno(&fs));
-				}
-				if (SPIFFS_read(&fs, fd, buf, DUMP_BUF_SIZE) < 0) {
-					snprintf(buf, DUMP_BUF_SIZE, "DFnr: %i", SPIFFS_errno(&fs));
-				}
-
-				/* Read in bytes which can have nulls embedded. Need to remove nulls for transmission as a chunk, since serial functions use strlen */
-				uint8_t cnt;
-				for(cnt = 0; cnt < DUMP_BUF_SIZE; cnt ++){
-					if(buf[cnt] == '\0') buf[cnt] = '\7'; /* replace empty with weird character so it's easy to pick out  */
-				}
-				buf[DUMP_BUF_SIZE] = '\0';	/* null terminate the chunk so that send function's strlen works */
-				serialSendln(( char*)buf);	/* either send out err msg or the data itself */
-				clearBuf(buf,DUMP_BUF_SIZE);
+		if (res > (s32_t)(end - offset)) {
+			res = end - offset;
+		}
+		if (res <= 0) {
+			if (res < 0) {
+				DLOG_SERIAL("DFnr: %d", res);
 			}
-			SPIFFS_close(&fs, fd);
-			snprintf(buf, DUMP_BUF_SIZE, "FILE_END: %s", fname);
-			serialSendln(( char*)buf);	/* either send out err msg or the data itself */
+			break;
 		}
-		xSemaphoreGive(spiffsTopMutex);
-	}
-	else {
-		serialSendQ("DFwe: can't get top mutex");
+
+		for (i = 0; i < (uint32_t)res; i += DUMP_LINE_BYTES) {
+			line[0] = 'D';
+			line[1] = 'F';
+			line[2] = ',';
+			utoa2(offset + i, &line[3], 10, 0);
+			len = strlen(line);
+			line[len++] = ',';
+			base64_encode(&block[i], ((uint32_t)res - i < DUMP_LINE_BYTES) ? (uint32_t)res - i : DUMP_LINE_BYTES, &line[len]);
+			serialSendln(line);
+		}
+		offset += res;
 	}
+
+	snprintf(line, DUMP_LINE_SIZE, "FILE_END: %s", fname);
+	serialSendln(line);
+}
+
+/* sfu_read_range
+ * 	- reads up to size bytes at offset in file <prefix><suffix> into buf, through the filesystem service
+ * 	- if file_size isn't NULL, it gets the size of the file
+ * 	- returns the number of bytes read (0 at the end of the file) or < 0 on errors
+ * 	- blocks until the service gets to it
+ */
+s32_t sfu_read_range(char prefix, char suffix, uint32_t offset, uint8_t *buf, uint32_t size, uint32_t *file_size) {
+	fs_request_t req;
+	req.type = FS_REQ_READ;
+	req.suffix = suffix;
+	req.read.prefix = prefix;
+	req.read.offset = offset;
+	req.read.size = size;
+	req.read.buf = buf;
+	req.read.file_size = file_size;
+	return fs_service_call(&req);
 }
 
 /* CurrentPrefix
@@ -126,31 +330,110 @@ char getCurrentPrefix(){
 }
 
 
+/* sfu_flush_logs
+ * 	- writes out everything the log appenders have staged
+ * 	- call before anything that would lose RAM contents (resets) or needs the logs complete on flash
+ */
+void sfu_flush_logs() {
+	fs_request_t req;
+	s32_t res;
+
+	req.type = FS_REQ_FLUSH;
+	res = fs_service_call(&req); /* behind any entries still queued, so those are written too */
+	if (res < 0) {
+		DLOG_SERIAL("FLwe: %d", res);
+	}
+}
+
+/* sfu_fs_sync
+ * 	- returns once the service has handled everything queued before the call
+ */
+void sfu_fs_sync() {
+	fs_request_t req;
+	req.type = FS_REQ_SYNC;
+	fs_service_call(&req);
+}
+
+/* sfu_flush_stale_logs
+ * 	- writes out staged log data that has been waiting for FS_APPENDER_STAGE_TIMEOUT or longer
+ * 	- run periodically by the lifecycle task
+ */
+void sfu_flush_stale_logs() {
+	fs_request_t req;
+	s32_t res;
+
+	req.type = FS_REQ_FLUSH_STALE;
+	res = fs_service_call(&req);
+	if (res < 0) {
+		DLOG_SERIAL("FLwe: %d", res);
+	}
+}
+
+void sfu_flush_logs_noMutex(TickType_t max_age) {
+	// CALL WITHIN MUTEX
+	s32_t res;
+
+	res = fs_appender_flush_all_noMutex(max_age);
+	if (res < 0) {
+		DLOG_SERIAL("FLwf: %d", res);
+	}
+	if (max_age == 0) {
+		res = fs_index_flush_all_noMutex();
+		if (res < 0) {
+			DLOG_SERIAL("FLif: %d", res);
+		}
+	}
+}
+
 void sfu_fs_init() {
-	// Todo: grab this from FEE or from config file
 	fs_num_increments = 0;
-	sfu_prefix = PREFIX_START;
+	flagInit(); /* FEE flags (PREFIX_FLAG) are ready before SPIFFS is mounted */
+	set_log_prefix();
+	fs_appender_init();
+	fs_index_init();
+	fs_objects_init();
+	memset(&fs_rotation_stats, 0, sizeof(fs_rotation_stats));
 }
 
-/* refresh_files
- * - this function is run at the end of every day.
+/* sfu_rotate_noMutex
+ * - this function is run at the end of every day, by the service (FS_REQ_ROTATE)
  * - it increments the file prefix and deletes any old files
  */
-static void refresh_files() {
-	// take the mutex since we don't want any writes while we're messing with this
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		increment_prefix_noMutex();
-
-		// delete the files with the current prefix since we're replacing it
-		if (fs_num_increments >= PREFIX_QUANTITY) {
+void sfu_rotate_noMutex() {
+	// CALL WITHIN MUTEX
+	TickType_t start;
+	TickType_t del_start;
+	s32_t deleted = 0;
+
+	start = xTaskGetTickCount();
+	sfu_flush_logs_noMutex(0); // write out what's staged for the outgoing set
+	fs_appender_close_all_noMutex(); // outgoing set gets its final flush, new set is opened below
+	increment_prefix_noMutex();
+
+	// delete the files with the current prefix since we're replacing it
+	del_start = xTaskGetTickCount();
+	if (fs_num_increments >= PREFIX_QUANTITY) {
+		deleted = fs_objects_delete_prefix_noMutex(sfu_prefix);
+		if (deleted == FS_OBJECTS_NOT_TRACKED) { // created before the last reset, or the table lost track
 			sfu_delete_prefix_noMutex(sfu_prefix);
+			fs_rotation_stats.scans++;
 		}
-		// create fresh files
-		sfu_create_log_files_noMutex();
-		xSemaphoreGive(spiffsTopMutex);
+		fs_objects_reset_prefix(sfu_prefix, true);
 	} else {
-		serialSendQ("Del oldest can't get top mutex");
+		fs_objects_reset_prefix(sfu_prefix, false); // may still have files from before the reset
+	}
+	fs_rotation_stats.last_delete_ticks = xTaskGetTickCount() - del_start;
+
+	// create fresh files
+	sfu_create_log_files_noMutex();
+	fs_rotation_stats.last_ticks = xTaskGetTickCount() - start;
+
+	fs_rotation_stats.count++;
+	if (fs_rotation_stats.last_ticks > fs_rotation_stats.max_ticks) {
+		fs_rotation_stats.max_ticks = fs_rotation_stats.last_ticks;
 	}
+	DLOG_SERIAL("Rot: %d ms, del %d ms, %d files", fs_rotation_stats.last_ticks * portTICK_PERIOD_MS,
+			fs_rotation_stats.last_delete_ticks * portTICK_PERIOD_MS, deleted);
 }
 
 /* increment_prefix_noMutex
@@ -163,29 +446,12 @@ static void increment_prefix_noMutex() {
 	sfu_prefix = PREFIX_START;
 		// RA: FLAGS
 //		write_flag_prefix(PREFIX_START);
-		FLAG(PREFIX_FLAG,flag) = PREFIX_START;
-		FLAG(PREFIX_FLAG,timestamp) = getCurrentRTCTime();
-		write_PREFIX_FLAG(flag_memory_table.PREFIX_FLAG.all);
+		FLAG_SET(PREFIX_FLAG, flag, PREFIX_START);
 	} else { 							// else just increment to next prefix
 		sfu_prefix = sfu_prefix + 1;
 		// RA: FLAGS
 //		write_flag_prefix(sfu_prefix + 1);
-		FLAG(PREFIX_FLAG,flag) = sfu_prefix;
-		FLAG(PREFIX_FLAG,timestamp) = getCurrentRTCTime();
-		write_PREFIX_FLAG(flag_memory_table.PREFIX_FLAG.all);
-
-		/* read back and check. Set to PREFIX_START if there's an issue */
-		flagCharWrap_t pfix_read;
-		read_PREFIX_FLAG(pfix_read.all);
-		if(pfix_read.payload.flag != sfu_prefix){
-			serialSendQ("PREFIX MISMATCH");
-			sfu_prefix = PREFIX_START;
-			FLAG(PREFIX_FLAG,flag) = sfu_prefix;
-			write_PREFIX_FLAG(flag_memory_table.PREFIX_FLAG.all);
-		}
-		else{
-			serialSendln("PREFIX MATCH");
-		}
+		FLAG_SET(PREFIX_FLAG, flag, sfu_prefix); /* written with the rest of the batch's flags */
 	}
 	fs_num_increments++;
 }
@@ -193,6 +459,8 @@ static void increment_prefix_noMutex() {
 /*	sfu_delete_prefix_noMutex
  * 		- This function deletes all files with the specified prefix
  * 		- Used to get rid of the oldest set of files when we loop back around
+ * 		- Reads every object header on the flash. Rotation only falls back to this when the object table
+ * 		  (obc_fs_objects.h) doesn't cover the prefix, which is the first time around after a reset
  */
 static void sfu_delete_prefix_noMutex(const char prefix) {
 	// MUST CALL WITHIN MUTEX
@@ -206,7 +474,7 @@ static void sfu_delete_prefix_noMutex(const char prefix) {
 
 	SPIFFS_opendir(&fs, "/", &d);
 	while ((pe = SPIFFS_readdir(&d, pe))) {
-		if ((const char *) prefix == (char *) pe->name[0]) { // we kinda don't have strncmp, but we only compare one char anyway
+		if (prefix == (char) pe->name[0]) { // we kinda don't have strncmp, but we only compare one char anyway
 			// found one
 			fd = SPIFFS_open_by_dirent(&fs, pe, SPIFFS_RDWR, 0);
 			if (fd < 0) {
@@ -252,17 +520,25 @@ static void sfu_delete_prefix_noMutex(const char prefix) {
  * 		- call this function
  */
 static void sfu_create_all_files(){
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		sfu_create_persistent_files_noMutex();
-		sfu_create_log_files_noMutex();
-		xSemaphoreGive(spiffsTopMutex);
-	} else {
-		serialSendQ("FCnm");
+	fs_request_t req;
+	s32_t res;
+
+	req.type = FS_REQ_CREATE;
+	res = fs_service_call(&req);
+	if (res < 0) {
+		DLOG_SERIAL("FCnm: %d", res);
 	}
 }
 
+void sfu_create_all_files_noMutex(){
+	// CALL WITHIN BOTH MUTEXES
+	sfu_create_persistent_files_noMutex();
+	sfu_create_log_files_noMutex();
+}
+
 /* sfu_create_log_files_noMutex
  * - create the set of filesystem log files for the current sfu_prefix
+ * - files are created through their appenders, which stay open for the following writes
  */
 static void sfu_create_log_files_noMutex() {
 	// CALL WITHIN MUTEX
@@ -275,18 +551,13 @@ static void sfu_create_log_files_noMutex() {
 	// Create and write to the file
 	for (i = 0; i < FSYS_NUM_SUBSYS; i++) { // run through each subsys and create a file for it
 		create_filename(nameBuf, (char) (FSYS_OFFSET + i));
-		fd = SPIFFS_open(&fs, nameBuf, SPIFFS_CREAT | SPIFFS_APPEND | SPIFFS_RDWR, 0); // create file with appropriate name
+		fd = fs_appender_open_noMutex((char) (FSYS_OFFSET + i), SPIFFS_CREAT); // create file with appropriate name
 
 		if (fd < 0) { // check that the create worked
 			snprintf(genBuf, 20, "OpenFile: %i", SPIFFS_errno(&fs));
 			serialSendQ(genBuf);
 		} else { // write to it
-			write_fd(fd, "Created"); // first entry is creation time
-		}
-
-		if (SPIFFS_close(&fs, fd) < 0) {
-			snprintf(genBuf, 20, "CloseF: %i", SPIFFS_errno(&fs));
-			serialSendQ(genBuf);
+			write_log_noMutex((char) (FSYS_OFFSET + i), "Created"); // first entry is creation time
 		}
 		clearBuf(genBuf, 20);
 		snprintf(genBuf, 11, "Create: %s", nameBuf);
@@ -299,152 +570,147 @@ static void sfu_create_log_files_noMutex() {
 
 
 /* sfu_create_persistent_files
- * - Creates the flag file if it doesn't yet exist
+ * - loads the flags from the flag store, or writes the defaults if it has no valid copy
+ * - flagInit() already put in the defaults and the FEE flags, the store only fills in the others
+ * - loads the erase counts (obc_fs_wear.h). A new flash has none, they're saved the first time round
  */
 static void sfu_create_persistent_files_noMutex() {
-	// CALL WITHIN MUTEX
-	char genBuf[20] = { '\0' };
-	char nameBuf[3] = { '\0' };
-	spiffs_file fd;
-	my_spiffs_mount();
-
-	// Create file to contain flags information
-	create_filename(nameBuf, FSYS_FLAGS);
-	fd = SPIFFS_open(&fs, (const char *) nameBuf, SPIFFS_RDWR, 0); /* attempt to open */
-
-	if (fd < 0) {
-		/* doesn't already exist, so create it */
-		fd = SPIFFS_open(&fs, (const char *) nameBuf, SPIFFS_CREAT | SPIFFS_RDWR, 0); // create file with appropriate name
-		if(fd < 0){
-			/* uh oh. some sort of error and we're hosed */
-			snprintf(genBuf, 20, "OpenFile: %i", SPIFFS_errno(&fs));
-			serialSendQ(genBuf);
-		} else{
-			/* created ok - write out the default flags*/
-			snprintf(genBuf, 20, "Create Flags");
-			serialSendQ(genBuf);
-			if (SPIFFS_close(&fs, fd) < 0) {
-				snprintf(genBuf, 20, "CloseF: %i", SPIFFS_errno(&fs));
-				serialSendQ(genBuf);
-			}
+	// CALL WITHIN spiffsStateMutex
+	flag_memory_table_t stored;
+	s32_t res;
+	my_spiffs_mount_state();
 
-			/* initialize flag table and write to flash */
-			initFlagTable();
-			writeAllFlagsToFlash_noMutex();
-			// RA: FLAGS
-//			sfu_write_fname_offset_noMutex(nameBuf[1], PREFIX_FLAG_START, PREFIX_FLAG_BASE);
-			/* file closed above implicitly */
-//			sfu_prefix = read_flag_prefix_noMutex();
-			if (SPIFFS_close(&fs, fd) < 0) {
-					snprintf(genBuf, 20, "CloseF: %i", SPIFFS_errno(&fs));
-					serialSendQ(genBuf);
-			}
-			sfu_prefix = FLAG(PREFIX_FLAG, flag);
-		}
-	} else {
-		/* already existed */
+	res = flag_store_load_noMutex(&stored);
+	if (res > 0) {
 		serialSendQ("Detected flag file");
-		// RA: FLAGS
-//		sfu_prefix = read_flag_prefix_noMutex();
-//		sfu_prefix = 'a';
-		flag_memory_table_wrap_t flags;
-		readAllFlagsFromFlash_noMutex(&flags);
-		flag_memory_table = flags.flagTable;
-		sfu_prefix = FLAG(PREFIX_FLAG, flag);
-
-		/* implicit closure above */
+		flagMergeStored(&stored);
+	} else {
+		/* new flash, or nothing in the file survived. Start from the defaults */
+		DLOG_SERIAL("Create Flags: %d", res);
+		res = flag_store_write_noMutex(&flag_memory_table);
+		if (res < 0) {
+			DLOG_SERIAL("FFww: %d", res);
+		}
 	}
-
-	if(serialSendQ((const char*)genBuf) != pdPASS){
-		serialSendQ("CREATE PRINT FAIL");
+	res = fs_wear_load_noMutex();
+	if (res < 0 && res != SPIFFS_ERR_NOT_FOUND) {
+		DLOG_SERIAL("FWlr: %d", res);
 	}
+	set_log_prefix();
 }
-/* write_fd
+
+/* set_log_prefix
+ * - circular logs always use FSYS_CIRC_PREFIX, PREFIX_FLAG only matters for rotation
+ */
+static void set_log_prefix() {
+#ifdef FSYS_CIRCULAR_LOGS
+	sfu_prefix = FSYS_CIRC_PREFIX;
+#else
+	sfu_prefix = FLAG(PREFIX_FLAG, flag);
+#endif
+}
+
+/* write_log_noMutex
  *
- * Given a file descriptor handle, write the printf style data to it and auto-timestamp.
+ * Given a log suffix, write the printf style data to its appender and auto-timestamp.
  *  ------ !!! MUST BE CALLED FROM WITHIN A MUTEX !!! --------------
- * Having a file descriptor means we've already opened the file up
+ * The entry is a text record staged like any other log write, so it goes out with the rest of the page
  */
-static void write_fd(spiffs_file fd, char *fmt, ...) {
+static void write_log_noMutex(char f_suffix, char *fmt, ...) {
 	char buf[SFU_WRITE_DATA_BUF] = { '\0' };
-	volatile va_list argptr;
+	s32_t res;
+	va_list argptr;
 	va_start(argptr, fmt);
 	format_entry(buf, fmt, argptr);
 	va_end(argptr);
 
-	if (SPIFFS_write(&fs, fd, buf, strlen(buf) + 1) < 0) {
-		snprintf(buf, 20, "FDwe: %i", SPIFFS_errno(&fs));
-		serialSendQ(buf);
+	res = fs_record_write_text_noMutex(f_suffix, getCurrentRTCTime(), buf);
+	if (res < 0) {
+		DLOG_SERIAL("FDwe: %d", res);
 	}
-	// YOU MUST CLOSE THE FILE
 }
 
 /* sfu_write_fname
  * - Given a file name (through the #define), write the printf-formatted data to it and timestamp
+ * - the file is written through its log appender, so we don't pay for an open/close (and remount) per entry
+ * - entries are queued to the filesystem service without waiting (dropped if the queue is full), then staged in RAM
+ *   until a data page fills up or they time out. Use sfu_flush_logs() to force them out
+ * - the entry is stored as a LOG_REC_TEXT record. For regular telemetry prefer sfu_write_fields(), it's a fraction of the size
+ * - this formats on the OBC. For integer-only messages DLOG_FILE() (obc_dlog.h) leaves that to the ground
  */
 void sfu_write_fname(char f_suffix, char *fmt, ...) {
-	char nameBuf[3] = { '\0' };
 	char buf[SFU_WRITE_DATA_BUF] = { '\0' };
+	uint32_t time = getCurrentRTCTime();
+	fs_request_t req;
 
-	volatile va_list argptr;
+	va_list argptr;
 	va_start(argptr, fmt);
 	format_entry(buf, fmt, argptr);
 	va_end(argptr);
-	spiffs_file fd;
 
-	// Formatting done, enter mutex and open + write the file
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		create_filename(nameBuf, f_suffix);
+	// Formatting done, hand it to the filesystem service
+	req.type = FS_REQ_TEXT;
+	req.suffix = f_suffix;
+	req.time = time;
+	strncpy(req.text, buf, SFU_WRITE_DATA_BUF);
+	fs_service_post(&req);
+}
 
-		my_spiffs_mount();
-		 fd = SPIFFS_open(&fs, nameBuf, SPIFFS_APPEND | SPIFFS_RDWR, 0);
+/* sfu_write_fields
+ * - writes a binary record of the given type to a log. See obc_fs_record.h for the format
+ * - time is the RTC time the record is stamped with, usually getCurrentRTCTime()
+ * - use the SFU_WRITE_RECORD() macro rather than calling this directly
+ */
+void sfu_write_fields(char f_suffix, uint32_t time, uint8_t type, const int32_t *fields, uint8_t num_fields) {
+	fs_request_t req;
+
+	if (num_fields > LOG_RECORD_MAX_FIELDS) {
+		DLOG_SERIAL("FRww: %d", SPIFFS_SFU_ERR_RECORD_FIELDS);
+		return;
+	}
+	req.type = FS_REQ_FIELDS;
+	req.suffix = f_suffix;
+	req.time = time;
+	req.num = num_fields;
+	req.record.type = type;
+	memcpy(req.record.fields, fields, num_fields * sizeof(int32_t));
+	fs_service_post(&req);
+}
 
-		if (fd < 0) { 	// if there's an error opening
-			snprintf(buf, 20, "FNoe: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-		else { 		// no error, write to it
-			if (SPIFFS_write(&fs, fd, buf, strlen(buf) + 1) < 0) {
-				snprintf(buf, 20, "FNww: %i", SPIFFS_errno(&fs));
-				serialSendQ(buf);
-			}
-			if (SPIFFS_close(&fs, fd) < 0) {
-				//clearBuf(genBuf, 20);
-				snprintf(buf, 20, "FNce: %i", SPIFFS_errno(&fs));
-				serialSendQ(buf);
-			}
-		}
-		xSemaphoreGive(spiffsTopMutex);
+/* sfu_write_deferred
+ * - writes a log entry from a format ID and its raw arguments. See obc_dlog.h, use DLOG_FILE() rather than calling this
+ * - with DEFERRED_FORMATTING off we get the format string too and write a regular text record instead
+ */
+void sfu_write_deferred(char f_suffix, uint32_t id, const char *fmt, const int32_t *args, uint8_t num_args) {
+	fs_request_t req;
+
+	req.suffix = f_suffix;
+	req.time = getCurrentRTCTime();
+	if (fmt != NULL) {
+		req.type = FS_REQ_TEXT;
+		dlog_format(req.text, SFU_WRITE_DATA_BUF, fmt, args, num_args);
 	} else {
-		serialSendQ("FNwe: can't get top mutex");
+		if (num_args > LOG_RECORD_MAX_FIELDS) {
+			DLOG_SERIAL("FDww: %d", SPIFFS_SFU_ERR_RECORD_FIELDS);
+			return;
+		}
+		req.type = FS_REQ_DEFERRED;
+		req.deferred.id = id;
+		req.num = num_args;
+		memcpy(req.deferred.args, args, num_args * sizeof(int32_t));
 	}
+	fs_service_post(&req);
 }
 
 /* Lets us write data to the filesystem using printf format specifiers.
  *
- * 	Max data supported varies with the time stamp, but consider SFU_MAX_DATA_WRITE
- * 	= #SFU_WRITE_DATA_BUF - 12 characters, as the max to be safe.
- *  This value is to allow for 10-char stamp, separator character between stamp and data, and an
- *  end character to allow us to separate file entries.
- *
- * File entry format: "<timestamp>|<data>\0"
- * where:
- * 		timestamp is max 10 chars (maxed out 32-bit int)
- * 		| separates timestamp and arbitrary data
- * 		\0 is the null terminator and also the end of the entry
+ * 	Max data supported is SFU_WRITE_DATA_BUF - 1 characters, the last byte is always the \0.
+ * 	The timestamp isn't part of the text anymore, the record header carries it (obc_fs_record.h).
  *
  * 	In the comments, SFU_WRITE_DATA_BUF has an assumed value of 33 bytes
  */
 static void format_entry(char* buf, char *fmt, va_list argptr) {
-	uint32_t x;
-	x = getCurrentRTCTime();
-
-	utoa2(x, buf, 10, 0); 	// We can store time has hex in the future for byte savings, but it'd be kinda gross.
-	x = strlen(buf); 		// reuse this
-	buf[x] = '|'; 			// add a separator between time and data
-	x++; 					// new strlen after adding sep
-
-	if (sfu_vsnprintf(&buf[x], SFU_WRITE_DATA_BUF - 1 - x, fmt, argptr) > (SFU_WRITE_DATA_BUF - 2 - x)) { // 32 - x so that we always end with a \0, 31 - x for warning
+	if (sfu_vsnprintf(buf, SFU_WRITE_DATA_BUF - 1, fmt, argptr) > (SFU_WRITE_DATA_BUF - 2)) { // 32 so that we always end with a \0, 31 for warning
 		serialSendQ("Error: file write data too big.");
 		// we'll log this error for our notice. However, vsnprintf will protect us from writing past the end of the buffer. Worst case we lose some data.
 		addLogItem(logtype_filesystem, error_1);
@@ -455,105 +721,11 @@ static void format_entry(char* buf, char *fmt, va_list argptr) {
  * 		- given a file suffix (the log type to access), reads <size> bytes from the current log into outbuf
  */
 void sfu_read_fname(char f_suffix, uint8_t * outbuf, uint32_t size){
-	char nameBuf[3] = { '\0' };
-	char buf[20] = {'\0'};
-	spiffs_file fd;
-	create_filename(nameBuf, f_suffix);
+	s32_t res;
 
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		my_spiffs_mount();
-		fd = SPIFFS_open(&fs, (const char *)nameBuf, SPIFFS_RDONLY, 0);
-
-		if (fd < 0) { 	// if there's an error opening
-			snprintf(buf, 20, "FRno: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-		else { // read the file
-		  if (SPIFFS_read(&fs, fd, (uint8_t *)outbuf, size) < 0) {
-			  snprintf(buf, 20, "FRnr: %i", SPIFFS_errno(&fs));
-			  serialSendQ(buf);
-		  }
-		  SPIFFS_close(&fs, fd);
-		}
-		xSemaphoreGive(spiffsTopMutex);
-	}
-	else {
-		serialSendQ("FRwe: can't get top mutex");
-	}
-}
-
-static void sfu_write_fname_offset(char f_suffix, uint32_t offset, char *fmt, ...) {
-	char nameBuf[3] = { '\0' };
-	char buf[SFU_WRITE_DATA_BUF] = { '\0' };
-
-	volatile va_list argptr;
-	va_start(argptr, fmt);
-	format_entry(buf, fmt, argptr);
-	va_end(argptr);
-	spiffs_file fd;
-
-	// Formatting done, enter mutex and open + write the file
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		create_filename(nameBuf, f_suffix);
-
-		my_spiffs_mount();
-
-		fd = SPIFFS_open(&fs, nameBuf, SPIFFS_RDWR, 0);
-		SPIFFS_lseek(&fs, fd, offset, SPIFFS_SEEK_SET);
-
-		if (fd < 0) { 	// if there's an error opening
-			snprintf(buf, 20, "FNoe: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-		else { 		// no error, write to it
-			if (SPIFFS_write(&fs, fd, fmt, strlen(fmt) + 1) < 0) {
-				snprintf(buf, 20, "FNww: %i", SPIFFS_errno(&fs));
-				serialSendQ(buf);
-			}
-			if (SPIFFS_close(&fs, fd) < 0) {
-				//clearBuf(genBuf, 20);
-				snprintf(buf, 20, "FNce: %i", SPIFFS_errno(&fs));
-				serialSendQ(buf);
-			}
-		}
-		xSemaphoreGive(spiffsTopMutex);
-	} else {
-		serialSendQ("ONwe: can't get top mutex");
-	}
-}
-
-static void sfu_write_fname_offset_noMutex(char f_suffix, uint32_t offset, char *fmt, ...) {
-	char nameBuf[3] = { '\0' };
-	char buf[SFU_WRITE_DATA_BUF] = { '\0' };
-
-	volatile va_list argptr;
-	va_start(argptr, fmt);
-	format_entry(buf, fmt, argptr);
-	va_end(argptr);
-	spiffs_file fd;
-
-	// Formatting done, enter mutex and open + write the file
-	create_filename(nameBuf, f_suffix);
-
-	my_spiffs_mount();
-
-	fd = SPIFFS_open(&fs, nameBuf, SPIFFS_RDWR, 0);
-	SPIFFS_lseek(&fs, fd, offset, SPIFFS_SEEK_SET);
-
-	if (fd < 0) { 	// if there's an error opening
-		snprintf(buf, 20, "FNoe: %i", SPIFFS_errno(&fs));
-		serialSendQ(buf);
-	}
-	else { 		// no error, write to it
-		if (SPIFFS_write(&fs, fd, fmt, strlen(fmt) + 1) < 0) {
-			snprintf(buf, 20, "FNww: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-		if (SPIFFS_close(&fs, fd) < 0) {
-			//clearBuf(genBuf, 20);
-			snprintf(buf, 20, "FNce: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
+	res = sfu_read_range(getCurrentPrefix(), f_suffix, 0, outbuf, size, NULL);
+	if (res < 0) {
+		DLOG_SERIAL("FRnr: %d", res);
 	}
 }
 
@@ -568,240 +740,40 @@ static void create_filename(char* namebuf, char file_suffix) {
 	namebuf[1] = file_suffix;
 }
 
-static void sfu_read_fname_offset_noMutex(char f_suffix, uint8_t* outbuf, uint8_t size, uint32_t offset){
-	char buf[20] = {'\0'};
-	char nameBuf[3] = { '\0' };
-	create_filename(nameBuf, f_suffix);
-
-	int16_t res;
-	spiffs_file fd;
-
-	my_spiffs_mount();
-	fd = SPIFFS_open(&fs, (const char *) nameBuf, SPIFFS_RDWR, 0);
-
-	res = SPIFFS_lseek(&fs, fd, offset, SPIFFS_SEEK_SET);	/* lseek increments file index to i'th byte */
-	if (res < 0) { 	// if there's an error opening
-		snprintf(buf, 20, "FROno: %i", SPIFFS_errno(&fs));
-		serialSendQ(buf);
-	}
-	else { // read the file
-	  if (SPIFFS_read(&fs, fd, (uint8_t *)outbuf, size) < 0) {
-		  snprintf(buf, 20, "FROnr: %i", SPIFFS_errno(&fs));
-		  serialSendQ(buf);
-	  }
-
-	  SPIFFS_close(&fs, fd);
-	}
-}
-
-static void sfu_read_fname_offset(char f_suffix, uint8_t* outbuf, uint8_t size, uint32_t offset){
-	char buf[20] = {'\0'};
-	char nameBuf[3] = { '\0' };
-
-	int16_t res;
-	spiffs_file fd;
-
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		create_filename(nameBuf, f_suffix);
-		my_spiffs_mount();
-		fd = SPIFFS_open(&fs, (const char *) nameBuf, SPIFFS_RDWR, 0);
-
-		res = SPIFFS_lseek(&fs, fd, offset, SPIFFS_SEEK_SET);	/* lseek increments file index to i'th byte */
-		if (res < 0) { 	// if there's an error opening
-			snprintf(buf, 20, "FROno: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-		else { // read the file
-		  if (SPIFFS_read(&fs, fd, (uint8_t *)outbuf, size) < 0) {
-			  snprintf(buf, 20, "FROnr: %i", SPIFFS_errno(&fs));
-			  serialSendQ(buf);
-		  }
-
-		  SPIFFS_close(&fs, fd);
-		}
-		xSemaphoreGive(spiffsTopMutex);
-	}
-	else {
-		serialSendQ("FROwe: can't get top mutex");
-	}
-}
-
-
-
-
-/* New flag file system */
+/* New flag file system
+ * 	- see obc_flag_store.h and obc_flag_fee.h
+ */
 void writeAllFlagsToFlash(){
-	flag_memory_table_wrap_t flags;
-	flags.flagTable = flag_memory_table;
-	char nameBuf[3] = { '\0' };
-	char buf[SFU_WRITE_DATA_BUF] = { '\0' };
+	fs_request_t req;
+	s32_t res;
 
-	spiffs_file fd;
-
-	// Formatting done, enter mutex and open + write the file
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		create_filename(nameBuf, FSYS_FLAGS);
-		my_spiffs_mount();
-		fd = SPIFFS_open(&fs, nameBuf, SPIFFS_APPEND | SPIFFS_RDWR, 0);
-
-		if (fd < 0) { 	// if there's an error opening
-			snprintf(buf, 20, "FNoe: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-		else { 		// no error, write to it
-			if (SPIFFS_write(&fs, fd, flags.flagTableBytes, sizeof(flags)) < 0) {
-				snprintf(buf, 20, "FFww: %i", SPIFFS_errno(&fs));
-				serialSendQ(buf);
-			}
-			if (SPIFFS_close(&fs, fd) < 0) {
-				//clearBuf(genBuf, 20);
-				snprintf(buf, 20, "FFce: %i", SPIFFS_errno(&fs));
-				serialSendQ(buf);
-			}
-		}
-		xSemaphoreGive(spiffsTopMutex);
-	} else {serialSendQ("FFwe: can't get top mutex");
+	req.type = FS_REQ_FLAGS_WRITE;
+	req.flags = &flag_memory_table;
+	res = fs_service_call(&req);
+	if (res < 0) {
+		DLOG_SERIAL("FFww: %d", res);
 	}
-}
-
-bool readAllFlagsFromFlash(flag_memory_table_wrap_t *flagWrap){
-	char nameBuf[3] = { '\0' };
-	char buf[20] = {'\0'};
-	spiffs_file fd;
-	create_filename(nameBuf, FSYS_FLAGS);
-
-	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
-		my_spiffs_mount();
-		fd = SPIFFS_open(&fs, (const char *)nameBuf, SPIFFS_RDONLY, 0);
-
-		if (fd < 0) { 	// if there's an error opening
-			snprintf(buf, 20, "FFno: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-			xSemaphoreGive(spiffsTopMutex);
-			return 0;
-		}
-		else { // read the file
-		  if (SPIFFS_read(&fs, fd, flagWrap, FLAG_TABLE_SIZE) < 0) {
-			  snprintf(buf, 20, "FDnr: %i", SPIFFS_errno(&fs));
-			  serialSendQ(buf);
-		  }
-		  SPIFFS_close(&fs, fd);
-		}
-		xSemaphoreGive(spiffsTopMutex);
-		return 1;
-	}
-	else {
-		serialSendQ("FRwe: can't get top mutex");
-	}
-	return 0;
-}
-
-static void writeAllFlagsToFlash_noMutex(){
-	flag_memory_table_wrap_t flags;
-	flags.flagTable = flag_memory_table;
-	char nameBuf[3] = { '\0' };
-	char buf[SFU_WRITE_DATA_BUF] = { '\0' };
-
-	spiffs_file fd;
-
-	// Formatting done, enter mutex and open + write the file
-	create_filename(nameBuf, FSYS_FLAGS);
-	my_spiffs_mount();
-	fd = SPIFFS_open(&fs, nameBuf, SPIFFS_APPEND | SPIFFS_RDWR, 0);
-
-	if (fd < 0) { 	// if there's an error opening
-		snprintf(buf, 20, "FNoe: %i", SPIFFS_errno(&fs));
-		serialSendQ(buf);
-	}
-	else { 		// no error, write to it
-		if (SPIFFS_write(&fs, fd, flags.flagTableBytes, sizeof(flags)) < 0) {
-			snprintf(buf, 20, "FFww: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-		if (SPIFFS_close(&fs, fd) < 0) {
-			//clearBuf(genBuf, 20);
-			snprintf(buf, 20, "FFce: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
+	res = flag_fee_commit(&flag_memory_table, FLAG_FEE_MASK);
+	if (res < 0) {
+		DLOG_SERIAL("FEww: %d", res);
 	}
 }
 
-static bool readAllFlagsFromFlash_noMutex(flag_memory_table_wrap_t *flagWrap){
-	char nameBuf[3] = { '\0' };
-	char buf[20] = {'\0'};
-	spiffs_file fd;
-	create_filename(nameBuf, FSYS_FLAGS);
-	fd = SPIFFS_open(&fs, (const char *)nameBuf, SPIFFS_RDONLY, 0);
-
-	if (fd < 0) { 	// if there's an error opening
-		snprintf(buf, 20, "FFno: %i", SPIFFS_errno(&fs));
-		serialSendQ(buf);
-		xSemaphoreGive(spiffsTopMutex);
+/* readAllFlagsFromFlash
+ * 	- 1 only if the flag store had a valid copy, which is then in flagWrap. 0 if it had none (flagWrap is untouched,
+ * 	  whatever defaults it held are still there) or on errors
+ */
+bool readAllFlagsFromFlash(flag_memory_table_wrap_t *flagWrap){
+	fs_request_t req;
+	s32_t res;
+
+	req.type = FS_REQ_FLAGS_READ;
+	req.flags = &flagWrap->flagTable;
+	res = fs_service_call(&req);
+	if (res <= 0) { /* SPIFFS_SFU_ERR_NO_FLAGS: nothing valid, defaults in use */
+		DLOG_SERIAL("FFnr: %d", res);
 		return 0;
 	}
-	else { // read the file
-	  if (SPIFFS_read(&fs, fd, flagWrap, FLAG_TABLE_SIZE) < 0) {
-		  snprintf(buf, 20, "FDnr: %i", SPIFFS_errno(&fs));
-		  serialSendQ(buf);
-	  }
-	  SPIFFS_close(&fs, fd);
-	}
+	flag_fee_load(&flagWrap->flagTable); /* the FEE copies of those flags are the current ones */
 	return 1;
 }
-
-
-
-void writeFlagRaw(uint8_t *bytes, uint8_t size, uint32_t offset){
-	char nameBuf[3] = { '\0' };
-	char buf[SFU_WRITE_DATA_BUF] = { '\0' };
-	spiffs_file fd;
-
-	// Formatting done, enter mutex and open + write the file
-	create_filename(nameBuf, FSYS_FLAGS);
-	my_spiffs_mount();
-
-	fd = SPIFFS_open(&fs, nameBuf, SPIFFS_RDWR, 0);
-	SPIFFS_lseek(&fs, fd, offset, SPIFFS_SEEK_SET);
-
-	if (fd < 0) { 	// if there's an error opening
-		snprintf(buf, 20, "FNoe: %i", SPIFFS_errno(&fs));
-		serialSendQ(buf);
-	}
-	else { 		// no error, write to it
-		if (SPIFFS_write(&fs, fd, bytes, size) < 0) {
-			snprintf(buf, 20, "FNww: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-		if (SPIFFS_close(&fs, fd) < 0) {
-			//clearBuf(genBuf, 20);
-			snprintf(buf, 20, "FNce: %i", SPIFFS_errno(&fs));
-			serialSendQ(buf);
-		}
-	}
-}
-
-void readFlagRaw(uint8_t *bytes, uint8_t size, uint32_t offset){
-	char buf[20] = {'\0'};
-	char nameBuf[3] = { '\0' };
-
-	int16_t res;
-	spiffs_file fd;
-
-	create_filename(nameBuf, FSYS_FLAGS);
-	my_spiffs_mount();
-	fd = SPIFFS_open(&fs, (const char *) nameBuf, SPIFFS_RDWR, 0);
-
-	res = SPIFFS_lseek(&fs, fd, offset, SPIFFS_SEEK_SET);	/* lseek increments file index to i'th byte */
-	if (res < 0) { 	// if there's an error opening
-		snprintf(buf, 20, "FROno: %i", SPIFFS_errno(&fs));
-		serialSendQ(buf);
-	}
-	else { // read the file
-	  if (SPIFFS_read(&fs, fd, (uint8_t *)bytes, size) < 0) {
-		  snprintf(buf, 20, "FROnr: %i", SPIFFS_errno(&fs));
-		  serialSendQ(buf);
-	  }
-	  SPIFFS_close(&fs, fd);
-	}
-}
-
@@ -18,6 +18,9 @@
  * SPIFFS doesn't have directories, which is why we need to do this. We bulk-delete files based on the index prefix, making it most
  * efficient to have this indicator first. A well-defined name structure makes it easy to construct the file name, and it can be compact
  * since we don't have a particularly large number of files at any one time.
+ *
+ * With FSYS_CIRCULAR_LOGS there's no rotation: each subsystem has one fixed size log under FSYS_CIRC_PREFIX that overwrites
+ * its oldest pages (obc_fs_circular.h). The prefix scheme above is what you get without it.
  */
 
 #ifndef SPIFFS_SFU_FS_STRUCTURE_H_
@@ -33,10 +36,11 @@ void vFilesystemLifecycleTask(void *pvParameters);
 
 /* commands */
 void dumpFile(char prefix, char suffix);
+void dumpLogRange(char suffix, uint32_t t0, uint32_t t1);	/* dumps the parts of a subsystem's logs between two RTC times */
 char getCurrentPrefix(void);
 
 /* SFUSat Configs */
-#define SFU_MAX_DATA_WRITE 21  							/* bytes or chars. The max amount of data we can write to a file at once that is GUARANTEED not to be chopped off. The actual max depends on the time stamp. */
+#define SFU_MAX_DATA_WRITE 21  							/* bytes or chars. The max amount of data we can write to a file at once that is GUARANTEED not to be chopped off. Text records have room for SFU_WRITE_DATA_BUF - 1 */
 #define SFU_WRITE_DATA_BUF (SFU_MAX_DATA_WRITE + 12) 	/* DON'T TOUCH: to size the file write buffer */
 #define FSYS_OFFSET 65 									/* the first char of file names is 'A' */
 #define FSYS_NUM_SUBSYS 5 								/* number of subsystem logs */
@@ -54,30 +58,72 @@ char getCurrentPrefix(void);
 
 #define FSYS_FLAGS		90		/* Z, flags */
 
-#define DUMP_BUF_SIZE 30		/* number of bytes to send out at once. Should eventually match radio TX buffer size */
+#define DUMP_BLOCK_SIZE 240		/* bytes read from the file per mutex hold while dumping. Multiple of DUMP_LINE_BYTES */
+#define DUMP_LINE_BYTES 48		/* file bytes per dump line, 64 characters of base64. Should eventually match radio TX buffer size */
+#define DUMP_LINE_SIZE (3 + 10 + 1 + 4 * (DUMP_LINE_BYTES / 3) + 1)	/* "DF," + offset + "," + base64 + \0 */
+#define DUMP_TO_END 0xFFFFFFFF	/* dump until the end of the file */
+
+/* Log layout
+ * 	- FSYS_CIRCULAR_LOGS: one fixed size log per subsystem (FSYS_CIRC_PREFIX + suffix) that wraps around, see obc_fs_circular.h
+ * 	- without it: a new set of logs every FSYS_LOOP_INTERVAL, PREFIX_QUANTITY sets kept, the oldest deleted on rotation
+ * 	- circular by default: over 240 h in fs_bench they program a quarter of what rotation does and erase less than an
+ * 	  eighth as often (host_sim/README.md). Define FSYS_ROTATING_LOGS to build with rotation
+ * 	- with circular logs the time index sidecars (obc_fs_index.h) are never written and the object table
+ * 	  (obc_fs_objects.h) tracks files that are never deleted by prefix, so both are dead code
+ */
+#ifndef FSYS_ROTATING_LOGS
+#define FSYS_CIRCULAR_LOGS
+#endif
+#define FSYS_CIRC_PREFIX 121 			/* y, circular logs. z is the flag file */
 
 #define FSYS_LOOP_INTERVAL pdMS_TO_TICKS(90000) /* we create new file sets on this interval */
+#define FSYS_FLUSH_INTERVAL pdMS_TO_TICKS(5000) /* how often the lifecycle task checks for staged log data that timed out */
 /* Prefix stuff */
 #define PREFIX_START 97 				/* a, start of prefixes */
 #define PREFIX_QUANTITY 3 				/* number of unique prefixes to loop through */
 
+/* Rotation metrics
+ * 	- the service holds spiffsTopMutex for the whole rotation (sfu_rotate_noMutex), so last_ticks is how long the log queue stalled
+ * 	- scans counts rotations that had to fall back to the readdir scan (see obc_fs_objects.h)
+ */
+typedef struct fs_rotation_stats {
+	uint32_t count;
+	uint32_t scans;
+	uint32_t last_ticks;
+	uint32_t max_ticks;
+	uint32_t last_delete_ticks;
+} fs_rotation_stats_t;
+
 /* variables */
 extern uint32_t fs_num_increments;
+extern fs_rotation_stats_t fs_rotation_stats;
 
 
 
 /* Functions */
 void sfu_fs_init();
+void sfu_fs_start();									/* sfu_fs_init, mount and create the files. The lifecycle task's startup */
 void sfu_write_fname(char f_suffix, char *fmt, ...); 	/* write printf style data to a file name */
+void sfu_write_fields(char f_suffix, uint32_t time, uint8_t type, const int32_t *fields, uint8_t num_fields); /* write a binary record, see SFU_WRITE_RECORD in obc_fs_record.h */
 void sfu_read_fname(char f_suffix, uint8_t* outbuf, uint32_t size);
+void sfu_flush_logs(); 									/* write out all staged log entries. Call before resets */
+void sfu_flush_stale_logs(); 							/* write out staged log entries that have timed out */
+void sfu_fs_sync(); 									/* wait for the filesystem service to catch up with queued requests */
+s32_t sfu_erase_chip();									/* erase the flash and start the filesystem over. Takes seconds */
+s32_t sfu_read_range(char prefix, char suffix, uint32_t offset, uint8_t *buf, uint32_t size, uint32_t *file_size); /* read part of any log */
+
+/* Service side, CALL WITHIN MUTEX (obc_fs_service.c). Creating files and erasing the chip need spiffsStateMutex too */
+void sfu_rotate_noMutex();
+void sfu_flush_logs_noMutex(TickType_t max_age);
+void sfu_create_all_files_noMutex();
+s32_t sfu_erase_chip_noMutex();
+s32_t sfu_find_log_range_noMutex(char prefix, char suffix, uint32_t t0, uint32_t t1, uint32_t *starts, uint32_t *ends);
 
 
 
 /* New flags */
 void writeAllFlagsToFlash();
 bool readAllFlagsFromFlash(flag_memory_table_wrap_t *flagWrap);
-void writeFlagRaw(uint8_t *bytes, uint8_t size, uint32_t offset);
-void readFlagRaw(uint8_t *bytes, uint8_t size, uint32_t offset);
 #endif /* SPIFFS_SFU_FS_STRUCTURE_H_ */
 
 
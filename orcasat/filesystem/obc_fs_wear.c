@@ -0,0 +1,286 @@
+/*
+ * obc_fs_wear.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ */
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "obc_fs_wear.h"
+#include "obc_fs_service.h"
+#include "obc_spiffs.h"
+#include "obc_utils.h"
+#include "obc_uart.h"
+#include "obc_dlog.h"
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+
+uint32_t fs_wear_counts[FS_WEAR_SECTORS];
+fs_wear_stats_t fs_wear_stats;
+bool fs_wear_gc = true;
+
+static uint32_t changes;		/* bumped whenever fs_wear_counts changes */
+static uint32_t saved_changes;	/* changes when the last save started */
+static bool saved;				/* there's a copy on flash with these counts in it */
+static uint32_t loaded[FS_WEAR_SECTORS];	/* the copy fs_wear_load_noMutex reads, added once its CRC matches */
+
+/* Private functions */
+static s32_t read_copy_noMutex(const char *name, fs_wear_trailer_t *t, uint32_t *counts);
+static uint32_t most_worn(uint32_t addr, uint32_t size);
+static uint16_t trailer_crc(const fs_wear_trailer_t *t, uint16_t crc);
+
+/* fs_wear_erased
+ * 	- called by the HAL for every sector it erases, with spiffsHALMutex held
+ */
+void fs_wear_erased(uint32_t addr) {
+	if (addr < SPIFFS_FLASH_SIZE) {
+		fs_wear_counts[addr / SPIFFS_PHYS_ERASE_SIZE]++;
+	}
+	fs_wear_stats.erases++;
+	changes++;
+}
+
+/* fs_wear_chip_erased
+ * 	- called by my_spiffs_erase_chip, with spiffsHALMutex held. A chip erase wears every sector once
+ * 	- both copies on the state partition went with it, so the counts in RAM are the only ones left until the next save
+ */
+void fs_wear_chip_erased() {
+	uint32_t i;
+
+	for (i = 0; i < FS_WEAR_SECTORS; i++) {
+		fs_wear_counts[i]++;
+	}
+	fs_wear_stats.erases += FS_WEAR_SECTORS;
+	changes++;
+	saved = false;
+}
+
+/* fs_wear_load_noMutex
+ * 	- adds the counts in the newest copy that passes its CRC to the ones in RAM. Nothing is added unless the whole
+ * 	  copy was read and matched
+ * 	- returns SPIFFS_ERR_NOT_FOUND if there's no copy at all (new flash), SPIFFS_SFU_ERR_CRC if neither is good
+ * 	- the erases since the last save (FS_WEAR_SAVE_INTERVAL, or the flush before a planned reset) were never saved.
+ * 	  After an unplanned reset they're gone, and the counts are that much low for good
+ */
+s32_t fs_wear_load_noMutex() {
+	// CALL WITHIN MUTEX
+	fs_wear_trailer_t a;
+	fs_wear_trailer_t b;
+	s32_t res_a;
+	s32_t res_b;
+	s32_t res;
+	uint32_t i;
+
+	my_spiffs_mount_state();
+	res_a = read_copy_noMutex(FS_WEAR_NAME_A, &a, NULL);
+	res_b = read_copy_noMutex(FS_WEAR_NAME_B, &b, NULL);
+	if (res_a == SPIFFS_SFU_ERR_CRC) {
+		fs_wear_stats.bad_copies++;
+	}
+	if (res_b == SPIFFS_SFU_ERR_CRC) {
+		fs_wear_stats.bad_copies++;
+	}
+	if (res_a < 0 && res_b < 0) {
+		return (res_a == SPIFFS_ERR_NOT_FOUND) ? res_b : res_a;
+	}
+
+	if (res_a >= 0 && (res_b < 0 || (int32_t)(a.seq - b.seq) > 0)) {
+		res = read_copy_noMutex(FS_WEAR_NAME_A, &a, loaded);
+		fs_wear_stats.seq = a.seq;
+	} else {
+		res = read_copy_noMutex(FS_WEAR_NAME_B, &b, loaded);
+		fs_wear_stats.seq = b.seq;
+	}
+	if (res < 0) {
+		return res; /* it was good a moment ago, but what we read this time wasn't */
+	}
+	for (i = 0; i < FS_WEAR_SECTORS; i++) {
+		fs_wear_counts[i] += loaded[i];
+	}
+	changes++;
+	return res;
+}
+
+/* fs_wear_save_noMutex
+ * 	- writes the counts over the older copy. Does nothing if they haven't changed since the last save
+ * 	- our own writes can erase sectors while we're at it, so the counts are copied out a chunk at a time and the CRC
+ * 	  is over what actually went out. Those erases are in the next save
+ */
+s32_t fs_wear_save_noMutex() {
+	// CALL WITHIN MUTEX
+	uint32_t chunk[FS_WEAR_CHUNK];
+	uint32_t start = changes;
+	fs_wear_trailer_t t;
+	spiffs_file fd;
+	uint16_t crc = 0xFFFF;
+	uint32_t i;
+	s32_t res = 0;
+
+	if (saved && start == saved_changes) {
+		return 0;
+	}
+	my_spiffs_mount_state();
+
+	t.magic = FS_WEAR_MAGIC;
+	t.sectors = FS_WEAR_SECTORS;
+	t.seq = fs_wear_stats.seq + 1;
+	t.crc = 0;
+	t.reserved = 0;
+	fd = SPIFFS_open(&fs_state, (t.seq & 1) ? FS_WEAR_NAME_B : FS_WEAR_NAME_A, SPIFFS_CREAT | SPIFFS_TRUNC | SPIFFS_WRONLY, 0);
+	if (fd < 0) {
+		fs_wear_stats.save_errors++;
+		return SPIFFS_errno(&fs_state);
+	}
+	for (i = 0; i < FS_WEAR_SECTORS && res >= 0; i += FS_WEAR_CHUNK) {
+		memcpy(chunk, &fs_wear_counts[i], sizeof(chunk));
+		crc = crc16_ccitt((const uint8_t *)chunk, sizeof(chunk), crc);
+		res = SPIFFS_write(&fs_state, fd, chunk, sizeof(chunk));
+	}
+	if (res >= 0) {
+		t.crc = trailer_crc(&t, crc);
+		res = SPIFFS_write(&fs_state, fd, &t, sizeof(t));
+	}
+	if (res < 0) {
+		res = SPIFFS_errno(&fs_state);
+	}
+	SPIFFS_close(&fs_state, fd);
+	if (res < 0) {
+		fs_wear_stats.save_errors++; /* the older copy is torn, the newer one is still good */
+		return res;
+	}
+
+	fs_wear_stats.seq = t.seq;
+	fs_wear_stats.saves++;
+	saved_changes = start;
+	saved = true;
+	return 0;
+}
+
+/* fs_wear_save
+ * 	- for the lifecycle task, every FS_WEAR_SAVE_INTERVAL
+ */
+void fs_wear_save() {
+	fs_request_t req;
+	s32_t res;
+
+	req.type = FS_REQ_WEAR_SAVE;
+	res = fs_service_call(&req);
+	if (res < 0) {
+		DLOG_SERIAL("FWwe: %d", res);
+	}
+}
+
+/* fs_wear_histogram
+ * 	- min, max and FS_WEAR_BINS equal bins between them for the sectors in addr..addr + size
+ */
+void fs_wear_histogram(uint32_t addr, uint32_t size, fs_wear_hist_t *h) {
+	uint32_t first = addr / SPIFFS_PHYS_ERASE_SIZE;
+	uint32_t i;
+	uint32_t c;
+
+	memset(h, 0, sizeof(*h));
+	h->sectors = size / SPIFFS_PHYS_ERASE_SIZE;
+	if (h->sectors == 0 || first + h->sectors > FS_WEAR_SECTORS) {
+		h->sectors = 0;
+		return;
+	}
+	h->min = 0xFFFFFFFF;
+	for (i = first; i < first + h->sectors; i++) {
+		c = fs_wear_counts[i];
+		h->min = (c < h->min) ? c : h->min;
+		h->max = (c > h->max) ? c : h->max;
+		h->total += c;
+	}
+	h->width = (h->max - h->min) / FS_WEAR_BINS + 1;
+	for (i = first; i < first + h->sectors; i++) {
+		h->bins[(fs_wear_counts[i] - h->min) / h->width]++;
+	}
+}
+
+/* fs_wear_gc_age
+ * 	- the erase age spiffs_gc_find_candidate scores a block with. SPIFFS's own age is how many blocks were erased since
+ * 	  this one was, which spreads erases evenly from the last format on but knows nothing from before it. On top of
+ * 	  that, every erase the block is behind the most worn block of its partition (by its most worn sector) counts as
+ * 	  a whole round of the partition's blocks
+ * 	- the partition's most worn block is only looked for again when the counts have changed. GC goes through every
+ * 	  block of one partition in a row, so that's once per candidate search
+ */
+spiffs_obj_id fs_wear_gc_age(spiffs *p, spiffs_block_ix bix, spiffs_obj_id age) {
+	static struct {
+		uint32_t addr;
+		uint32_t changes;
+		uint32_t max;
+	} partition = { 0xFFFFFFFF, 0, 0 };
+	uint32_t count;
+
+	if (!fs_wear_gc) {
+		return age;
+	}
+	if (partition.addr != p->cfg.phys_addr || partition.changes != changes) {
+		partition.addr = p->cfg.phys_addr;
+		partition.changes = changes;
+		partition.max = most_worn(p->cfg.phys_addr, p->cfg.phys_size);
+	}
+	count = most_worn(p->cfg.phys_addr + bix * SPIFFS_CFG_LOG_BLOCK_SZ(p), SPIFFS_CFG_LOG_BLOCK_SZ(p));
+	return age + (partition.max - count) * p->block_count;
+}
+
+/* read_copy_noMutex
+ * 	- checks the copy in name against its trailer (returned in t). Its counts go in counts (FS_WEAR_SECTORS of them)
+ * 	  if that isn't NULL, and are only any good if the result isn't negative
+ * 	- a copy that's too short (torn before the trailer) or fails the CRC is SPIFFS_SFU_ERR_CRC
+ */
+static s32_t read_copy_noMutex(const char *name, fs_wear_trailer_t *t, uint32_t *counts) {
+	// CALL WITHIN MUTEX
+	uint32_t chunk[FS_WEAR_CHUNK];
+	uint32_t *dst = chunk;
+	spiffs_file fd;
+	uint16_t crc = 0xFFFF;
+	uint32_t i;
+	s32_t res = 0;
+
+	fd = SPIFFS_open(&fs_state, name, SPIFFS_RDONLY, 0);
+	if (fd < 0) {
+		return SPIFFS_errno(&fs_state);
+	}
+	if (SPIFFS_lseek(&fs_state, fd, sizeof(fs_wear_counts), SPIFFS_SEEK_SET) < 0
+			|| SPIFFS_read(&fs_state, fd, t, sizeof(*t)) != sizeof(*t)) {
+		res = (SPIFFS_errno(&fs_state) == SPIFFS_ERR_END_OF_OBJECT) ? SPIFFS_SFU_ERR_CRC : SPIFFS_errno(&fs_state);
+	} else if (t->magic != FS_WEAR_MAGIC || t->sectors != FS_WEAR_SECTORS) {
+		res = SPIFFS_SFU_ERR_CRC;
+	} else if (SPIFFS_lseek(&fs_state, fd, 0, SPIFFS_SEEK_SET) < 0) {
+		res = SPIFFS_errno(&fs_state);
+	}
+	for (i = 0; i < FS_WEAR_SECTORS && res >= 0; i += FS_WEAR_CHUNK) {
+		if (counts != NULL) {
+			dst = &counts[i];
+		}
+		if (SPIFFS_read(&fs_state, fd, dst, sizeof(chunk)) != sizeof(chunk)) {
+			res = SPIFFS_errno(&fs_state);
+			break;
+		}
+		crc = crc16_ccitt((const uint8_t *)dst, sizeof(chunk), crc);
+	}
+	SPIFFS_close(&fs_state, fd);
+	if (res >= 0 && trailer_crc(t, crc) != t->crc) {
+		res = SPIFFS_SFU_ERR_CRC;
+	}
+	return res;
+}
+
+static uint32_t most_worn(uint32_t addr, uint32_t size) {
+	uint32_t i;
+	uint32_t max = 0;
+
+	for (i = addr / SPIFFS_PHYS_ERASE_SIZE; i < (addr + size) / SPIFFS_PHYS_ERASE_SIZE && i < FS_WEAR_SECTORS; i++) {
+		max = (fs_wear_counts[i] > max) ? fs_wear_counts[i] : max;
+	}
+	return max;
+}
+
+static uint16_t trailer_crc(const fs_wear_trailer_t *t, uint16_t crc) {
+	fs_wear_trailer_t zeroed = *t;
+	zeroed.crc = 0;
+	return crc16_ccitt((const uint8_t *)&zeroed, sizeof(zeroed), crc);
+}
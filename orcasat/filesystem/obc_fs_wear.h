@@ -0,0 +1,84 @@
+/*
+ * obc_fs_wear.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *      Erase counts for every 4 KB sector of the flash.
+ *
+ *      SPIFFS keeps an erase count per logical block for its GC heuristic, but it starts over when a partition is
+ *      formatted and nothing outside SPIFFS can see it. fs_wear counts every sector my_spiffs_erase erases, for the
+ *      life of the chip. my_spiffs_erase_chip ("file erase", "wd f_reset") counts one erase for every sector:
+ *      	- the counts are in RAM and saved to the state partition every FS_WEAR_SAVE_INTERVAL, and on sfu_flush_logs
+ *      	  before a reset. An unplanned reset loses the erases since the last save, so the counts can be a little low
+ *      	- there are two copies, written alternately. The counts go first and a trailer with a sequence number and a
+ *      	  CRC goes last, so a torn save just fails its CRC and the other copy is used. Boot loads the newest good copy
+ *      	  and adds it to whatever was counted before it (the mount, or a format)
+ *      	- "get wear" prints a histogram of each partition's counts
+ *      	- with fs_wear_gc set, the GC's erase age (gc_erase_age_f in spiffs_config) also counts how far each block is
+ *      	  behind the most worn one in its partition, so the blocks that were worn before a format are left alone
+ *      	  until the others catch up
+ *      	- flash_erase_chip called directly, outside the filesystem (the radiation test in obc_triumf.c, the flash unit
+ *      	  tests), isn't counted. Neither are erases done before fs_wear was added
+ *
+ *      ------ !!! ALL _noMutex FUNCTIONS MUST BE CALLED FROM WITHIN spiffsStateMutex !!! --------------
+ */
+
+#ifndef SFUSAT_OBC_FILESYSTEM_OBC_FS_WEAR_H_
+#define SFUSAT_OBC_FILESYSTEM_OBC_FS_WEAR_H_
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "spiffs.h"
+#include "obc_spiffs.h"
+
+#define FS_WEAR_SECTORS			(SPIFFS_FLASH_SIZE / SPIFFS_PHYS_ERASE_SIZE)
+#define FS_WEAR_NAME_A			"zW"							/* the two copies, on the state partition */
+#define FS_WEAR_NAME_B			"zX"
+#define FS_WEAR_MAGIC			0xE5C7
+#define FS_WEAR_SAVE_INTERVAL	pdMS_TO_TICKS(3600000)			/* an hour */
+#define FS_WEAR_CHUNK			64								/* counts per SPIFFS read/write */
+#define FS_WEAR_BINS			8								/* histogram bins. "get wear" prints all 8 */
+
+/* trailer, after the FS_WEAR_SECTORS counts */
+#pragma pack(push,1)
+typedef struct fs_wear_trailer {
+	uint16_t magic;
+	uint16_t sectors;
+	uint32_t seq;
+	uint16_t crc;					/* over the counts, then the trailer with crc = 0 */
+	uint16_t reserved;
+} fs_wear_trailer_t;
+#pragma pack(pop)
+
+typedef struct fs_wear_stats {
+	uint32_t erases;				/* sectors erased since boot */
+	uint32_t seq;					/* of the newest copy on flash */
+	uint32_t saves;
+	uint32_t save_errors;
+	uint32_t bad_copies;			/* copies that failed their CRC at boot */
+} fs_wear_stats_t;
+
+/* histogram of the counts of a range of sectors. Bin i holds counts from min + i * width */
+typedef struct fs_wear_hist {
+	uint32_t min;
+	uint32_t max;
+	uint32_t total;
+	uint32_t sectors;
+	uint32_t width;
+	uint16_t bins[FS_WEAR_BINS];
+} fs_wear_hist_t;
+
+extern uint32_t fs_wear_counts[FS_WEAR_SECTORS];
+extern fs_wear_stats_t fs_wear_stats;
+extern bool fs_wear_gc;				/* GC erase ages from fs_wear_counts. On by default */
+
+void fs_wear_erased(uint32_t addr);							/* my_spiffs_erase erased the sector at addr */
+void fs_wear_chip_erased();										/* my_spiffs_erase_chip erased every sector */
+s32_t fs_wear_load_noMutex();								/* adds the newest good copy on flash to the counts */
+s32_t fs_wear_save_noMutex();								/* writes the counts to the older copy, if they changed */
+void fs_wear_save();										/* fs_wear_save_noMutex, taking the mutex */
+void fs_wear_histogram(uint32_t addr, uint32_t size, fs_wear_hist_t *h);
+spiffs_obj_id fs_wear_gc_age(spiffs *p, spiffs_block_ix bix, spiffs_obj_id age);	/* spiffs_config gc_erase_age_f */
+
+#endif /* SFUSAT_OBC_FILESYSTEM_OBC_FS_WEAR_H_ */
@@ -6,6 +6,7 @@
  */
 #include "spiffs.h"
 #include "spiffs_config.h"
+#include "spiffs_nucleus.h"
 #include "obc_spiffs.h"
 #include "flash_mibspi.h"
 #include "obc_uart.h"
@@ -16,11 +17,40 @@
 #include "rtos_semphr.h"
 #include "obc_utils.h"
 #include "obc_fs_structure.h"
+#include "obc_fs_objects.h"
+#include "obc_fs_wear.h"
+#include "system.h"
 
 spiffs fs;
 spiffs_config cfg;
+spiffs fs_state;
+spiffs_config cfg_state;
 SemaphoreHandle_t spiffsHALMutex; // protects the low level HAL functions in SPIFFS
 SemaphoreHandle_t spiffsTopMutex; 	// ensures we won't interrupt a read with a write and v/v
+SemaphoreHandle_t spiffsStateMutex;	// the same for fs_state
+uint32_t spiffs_mount_generation;
+spiffs_hal_stats_t spiffs_hal_stats;
+spiffs_mount_stats_t spiffs_mount_stats;
+spiffs_mount_stats_t spiffs_state_mount_stats;
+
+static bool logs_may_format; // the next mount formats the partition if there's no filesystem on it
+static bool state_may_format;
+
+static u8_t spiffs_work_buf[LOG_PAGE_SIZE*2];
+static u8_t spiffs_fds[32*16]; // spiffs_fd is 56 bytes: room for the FSYS_NUM_SUBSYS log appenders plus a few short-lived fds
+static u8_t spiffs_cache_buf[(LOG_PAGE_SIZE+32)*SPIFFS_LOGS_CACHE_PAGES];
+static u8_t spiffs_state_work_buf[LOG_PAGE_SIZE*2];
+static u8_t spiffs_state_fds[32*8]; // the flag store opens one fd at a time
+static u8_t spiffs_state_cache_buf[(LOG_PAGE_SIZE+32)*SPIFFS_STATE_CACHE_PAGES];
+
+/* Private functions */
+static s32_t my_spiffs_read(u32_t addr, u32_t size, u8_t *dst);
+static s32_t my_spiffs_write(u32_t addr, u32_t size, u8_t *src);
+static s32_t my_spiffs_erase(u32_t addr, u32_t size);
+static void config_partition(spiffs_config *c, u32_t addr, u32_t size, u32_t block_size, u16_t fh_offset);
+static s32_t mount_partition(spiffs *p, spiffs_config *c, u8_t *work, u8_t *fd_buf, u32_t fd_size, u8_t *cache, u32_t cache_size, spiffs_mount_stats_t *stats, bool *may_format);
+static bool is_fatal(s32_t err);
+static void hal_latency(spiffs_hal_latency_t *l, uint32_t start);
 
 void spiffs_read_task(void *pvParameters) {
 	spiffs_stat s;
@@ -28,7 +58,7 @@ void spiffs_read_task(void *pvParameters) {
 
 	while (1) {
 		if ( xSemaphoreTake( spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS) ) == pdTRUE) {
-			my_spiffs_mount(); // need to mount every time because as task gets suspended, we lose the mount
+			my_spiffs_mount(); // no-op unless something unmounted it
 			serialSendQ("Read");
 			spiffs_file fd = SPIFFS_open(&fs, "new", SPIFFS_RDWR, 0);
 			if (fd < 0) {
@@ -73,48 +103,266 @@ void spiffs_read_task(void *pvParameters) {
 void sfusat_spiffs_init() {
 	spiffsHALMutex = xSemaphoreCreateMutex(); // protects HAL functions
 	spiffsTopMutex = xSemaphoreCreateMutex(); // makes sure we can't interrupt a read with a write and v/v
-	my_spiffs_mount();
+	spiffsStateMutex = xSemaphoreCreateMutex(); // same for the state partition, so flag commits don't wait for the logs
+	memset(&spiffs_mount_stats, 0, sizeof(spiffs_mount_stats));
+	memset(&spiffs_state_mount_stats, 0, sizeof(spiffs_state_mount_stats));
+	my_spiffs_allow_format(); // blank chip, or the partitions moved
+	config_partition(&cfg, SPIFFS_LOGS_ADDR, SPIFFS_LOGS_SIZE, SPIFFS_LOGS_BLOCK_SIZE, 0);
+	config_partition(&cfg_state, SPIFFS_STATE_ADDR, SPIFFS_STATE_SIZE, SPIFFS_STATE_BLOCK_SIZE, SPIFFS_STATE_FH_OFFSET);
+	my_spiffs_mount_state(); // small, and the flags are loaded from it first
+	my_spiffs_mount(); // the one mount scan, everything after this finds it mounted
 }
 
-void my_spiffs_mount() {
-//    spiffs_config cfg;
-//    cfg.phys_size = 2*1024*1024; // use all spi flash (bytes?)
-//    cfg.phys_addr = 0; // start spiffs at start of spi flash
-//    cfg.phys_erase_block = 4096; // according to datasheet
-//    cfg.log_block_size = 65536; // let us not complicate things
-//    cfg.log_page_size = LOG_PAGE_SIZE; // as we said
+/* my_spiffs_mount
+ * 	- runs the mount scan if the logs partition isn't mounted, otherwise does nothing
+ * 	- CALL WITHIN MUTEX (or before anyone else uses SPIFFS)
+ */
+s32_t my_spiffs_mount() {
+	s32_t res;
+
+	if (SPIFFS_mounted(&fs)) {
+		spiffs_mount_stats.cached++;
+		return SPIFFS_OK;
+	}
+
+	res = mount_partition(&fs, &cfg, spiffs_work_buf, spiffs_fds, sizeof(spiffs_fds), spiffs_cache_buf, sizeof(spiffs_cache_buf), &spiffs_mount_stats, &logs_may_format);
+	spiffs_mount_generation++; /* mount wipes the fd table, so any fd held across this call is gone */
+	if (res == SPIFFS_OK) {
+		SPIFFS_set_file_callback_func(&fs, fs_objects_file_event); /* mount clears it too */
+	}
+	return res;
+}
+
+/* my_spiffs_unmount
+ * 	- closes every fd and unmounts. The next my_spiffs_mount() scans again
+ * 	- CALL WITHIN MUTEX
+ */
+void my_spiffs_unmount() {
+	if (SPIFFS_mounted(&fs)) {
+		SPIFFS_unmount(&fs);
+	}
+}
+
+/* my_spiffs_check_error
+ * 	- for errors that mean our RAM view of the filesystem is wrong. We unmount so the next operation remounts,
+ * 	  which rebuilds it from flash
+ * 	- anything else is passed through untouched
+ * 	- CALL WITHIN MUTEX
+ */
+s32_t my_spiffs_check_error(s32_t err) {
+	if (is_fatal(err)) {
+		spiffs_mount_stats.fatal_errors++;
+		my_spiffs_unmount();
+	}
+	return err;
+}
+
+/* my_spiffs_mount_state
+ * 	- my_spiffs_mount for the state partition. Nothing holds a state fd across calls, so there's no generation
+ * 	- CALL WITHIN spiffsStateMutex (or before anyone else uses SPIFFS)
+ */
+s32_t my_spiffs_mount_state() {
+	if (SPIFFS_mounted(&fs_state)) {
+		spiffs_state_mount_stats.cached++;
+		return SPIFFS_OK;
+	}
+	return mount_partition(&fs_state, &cfg_state, spiffs_state_work_buf, spiffs_state_fds, sizeof(spiffs_state_fds),
+			spiffs_state_cache_buf, sizeof(spiffs_state_cache_buf), &spiffs_state_mount_stats, &state_may_format);
+}
+
+void my_spiffs_unmount_state() {
+	if (SPIFFS_mounted(&fs_state)) {
+		SPIFFS_unmount(&fs_state);
+	}
+}
+
+s32_t my_spiffs_state_check_error(s32_t err) {
+	if (is_fatal(err)) {
+		spiffs_state_mount_stats.fatal_errors++;
+		my_spiffs_unmount_state();
+	}
+	return err;
+}
+
+/* my_spiffs_erase_chip
+ * 	- erases the whole chip under both partitions, then formats and mounts them again
+ * 	- every sector's erase count goes up by one (obc_fs_wear.h). The saved counts were on the chip, sfu_erase_chip saves
+ * 	  them again once the state partition is back
+ * 	- CALL WITHIN BOTH MUTEXES, with every fd closed. Anything in RAM that describes files on the flash is stale afterwards
+ */
+s32_t my_spiffs_erase_chip() {
+	s32_t res;
+	s32_t res_state;
+
+	my_spiffs_unmount();
+	my_spiffs_unmount_state();
+	xSemaphoreTake(spiffsHALMutex, portMAX_DELAY); // like every other flash access from the HAL
+	flash_erase_chip();
+	fs_wear_chip_erased();
+	xSemaphoreGive(spiffsHALMutex);
+
+	my_spiffs_allow_format();
+	res_state = my_spiffs_mount_state();
+	res = my_spiffs_mount();
+	return (res_state < 0) ? res_state : res;
+}
+
+/* my_spiffs_allow_format
+ * 	- the next mount of each partition formats it if it finds no filesystem there (SPIFFS_ERR_NOT_A_FS). At boot,
+ * 	  for a blank chip or a new layout, and after the chip was erased on purpose. Any other time that error means
+ * 	  something went wrong with the flash, and formatting would throw away everything on it
+ * 	- CALL WITHIN MUTEX (or before anyone else uses SPIFFS)
+ */
+void my_spiffs_allow_format() {
+	logs_may_format = true;
+	state_may_format = true;
+}
 
-	cfg.hal_read_f = my_spiffs_read;
-	cfg.hal_write_f = my_spiffs_write;
-	cfg.hal_erase_f = my_spiffs_erase;
+/* config_partition
+ * 	- the partitions share the HAL, they only differ in where they are on the chip and their block size
+ * 	- GC scores erase age with our own erase counts (obc_fs_wear.h)
+ */
+static void config_partition(spiffs_config *c, u32_t addr, u32_t size, u32_t block_size, u16_t fh_offset) {
+	c->hal_read_f = my_spiffs_read;
+	c->hal_write_f = my_spiffs_write;
+	c->hal_erase_f = my_spiffs_erase;
+	c->phys_addr = addr;
+	c->phys_size = size;
+	c->phys_erase_block = SPIFFS_PHYS_ERASE_SIZE;
+	c->log_block_size = block_size;
+	c->log_page_size = LOG_PAGE_SIZE;
+	c->fh_ix_offset = fh_offset;
+	c->gc_erase_age_f = fs_wear_gc_age;
+}
 
-	int res = SPIFFS_mount(&fs, &cfg, spiffs_work_buf, spiffs_fds, sizeof(spiffs_fds), spiffs_cache_buf,sizeof(spiffs_cache_buf), 0);
-//	printf("mount res: %i\n", res);
+/* mount_partition
+ * 	- mount scan, with the numbers in stats
+ * 	- SPIFFS_ERR_NOT_A_FS with *may_format set (my_spiffs_allow_format) formats the partition and mounts again.
+ * 	  *may_format is cleared by the attempt, whatever comes of it
+ */
+static s32_t mount_partition(spiffs *p, spiffs_config *c, u8_t *work, u8_t *fd_buf, u32_t fd_size, u8_t *cache, u32_t cache_size, spiffs_mount_stats_t *stats, bool *may_format) {
+	uint32_t reads;
+	TickType_t start;
+	s32_t res;
+
+	reads = spiffs_hal_stats.reads;
+	start = xTaskGetTickCount();
+	res = SPIFFS_mount(p, c, work, fd_buf, fd_size, cache, cache_size, 0);
+	if (res == SPIFFS_ERR_NOT_A_FS && *may_format) {
+		/* the failed mount left the config in p, which is all SPIFFS_format needs */
+		res = SPIFFS_format(p);
+		if (res == SPIFFS_OK) {
+			stats->formats++;
+			res = SPIFFS_mount(p, c, work, fd_buf, fd_size, cache, cache_size, 0);
+		}
+	}
+	*may_format = false;
+	stats->last_ticks = xTaskGetTickCount() - start;
+	stats->last_reads = spiffs_hal_stats.reads - reads;
+	stats->last_result = res;
+	stats->mounts++;
+	if (res != SPIFFS_OK) {
+		stats->failures++;
+	}
+	return res;
+}
+
+static bool is_fatal(s32_t err) {
+	switch (err) {
+		case SPIFFS_ERR_NOT_MOUNTED:
+		case SPIFFS_ERR_NOT_A_FS:
+		case SPIFFS_ERR_IS_FREE:
+		case SPIFFS_ERR_INDEX_REF_FREE:
+		case SPIFFS_ERR_INDEX_REF_LU:
+		case SPIFFS_ERR_INDEX_REF_INVALID:
+		case SPIFFS_SFU_ERR_FLASH: /* SPIFFS may have cached what it thinks it wrote, or half a read */
+			return true;
+		default:
+			return false;
+	}
+}
+
+void spiffs_hal_stats_reset() {
+	memset(&spiffs_hal_stats, 0, sizeof(spiffs_hal_stats));
+}
+
+/* my_spiffs_usage
+ * 	- everything in spiffs_usage_t comes from RAM, nothing is read from the flash. The mutex is so the numbers are
+ * 	  from the same moment
+ */
+s32_t my_spiffs_usage(spiffs *p, spiffs_usage_t *u, TickType_t wait) {
+	SemaphoreHandle_t mutex = (p == &fs_state) ? spiffsStateMutex : spiffsTopMutex;
+	s32_t res;
+
+	if (xSemaphoreTake(mutex, wait) != pdTRUE) {
+		return SPIFFS_SFU_ERR_BUSY;
+	}
+	res = SPIFFS_info(p, &u->total, &u->used);
+	if (res == SPIFFS_OK) {
+		u->free_blocks = p->free_blocks;
+		u->pages_deleted = p->stats_p_deleted;
+		u->pages_free = u->total / SPIFFS_DATA_PAGE_SIZE(p) - p->stats_p_allocated - p->stats_p_deleted;
+		u->cache_hits = p->cache_hits;
+		u->cache_misses = p->cache_misses;
+		u->gc_runs = p->stats_gc_runs;
+	}
+	xSemaphoreGive(mutex);
+	return res;
+}
+
+/* hal_latency
+ * 	- start is the PMU cycle count when the callback started. It wraps every minute or so, far longer than any call
+ */
+static void hal_latency(spiffs_hal_latency_t *l, uint32_t start) {
+	uint32_t us = ((uint32_t)portGET_RUN_TIME_COUNTER_VALUE() - start) / SPIFFS_HAL_CYCLES_PER_US;
+
+	l->calls++;
+	l->total_us += us;
+	if (us > l->max_us) {
+		l->max_us = us;
+	}
 }
 
 static s32_t my_spiffs_read(u32_t addr, u32_t size, u8_t *dst) {
+	uint32_t start = portGET_RUN_TIME_COUNTER_VALUE();
+	s32_t res = SPIFFS_OK;
+
 	if ( xSemaphoreTake( spiffsHALMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS) ) == pdTRUE) {
-		flash_read_arbitrary(addr, size, dst);
+		if (!flash_read_arbitrary(addr, size, dst)) {
+			res = SPIFFS_SFU_ERR_FLASH; // a transfer never finished, dst isn't what's on the flash
+		}
+		spiffs_hal_stats.reads++;
+		spiffs_hal_stats.read_bytes += size;
 		xSemaphoreGive(spiffsHALMutex);
 	} else {
 		serialSendQ("Read, can't get mutex");
 	}
-	return SPIFFS_OK;
+	hal_latency(&spiffs_hal_stats.read_time, start);
+	return res;
 }
 
 static s32_t my_spiffs_write(u32_t addr, u32_t size, u8_t *src) {
+	uint32_t start = portGET_RUN_TIME_COUNTER_VALUE();
+	s32_t res = SPIFFS_OK;
+
 	if ( xSemaphoreTake( spiffsHALMutex, pdMS_TO_TICKS(SPIFFS_WRITE_TIMEOUT_MS) ) == pdTRUE) {
-		flash_write_arbitrary(addr, size, src);
-		while (flash_status() != 0) { // wait for the write to complete
+		if (!flash_write_arbitrary(addr, size, src)) {
+			res = SPIFFS_SFU_ERR_FLASH; // part of it may have gone out
 		}
+		flash_wait_done(FLASH_T_PP_US); // wait for the write to complete
+		spiffs_hal_stats.writes++;
+		spiffs_hal_stats.write_bytes += size;
 		xSemaphoreGive(spiffsHALMutex);
 	} else {
 		serialSendQ("Write can't get mutex");
 	}
-	return SPIFFS_OK;
+	hal_latency(&spiffs_hal_stats.write_time, start);
+	return res;
 }
 
 static s32_t my_spiffs_erase(u32_t addr, u32_t size) {
+	uint32_t start = portGET_RUN_TIME_COUNTER_VALUE();
+
 	if ( xSemaphoreTake( spiffsHALMutex, pdMS_TO_TICKS(SPIFFS_ERASE_TIMEOUT_MS) ) == pdTRUE) {
 		/* We erase pages - 4096 bytes
 		 * Logical block size = 65536 bytes
@@ -126,20 +374,24 @@ static s32_t my_spiffs_erase(u32_t addr, u32_t size) {
 		 * It's also not clear whether SPIFFS handles this loop or not.
 		 */
 
-		if(size % SPIFFS_CFG_PHYS_ERASE_SZ(fs) != 0){ 	// make sure size is a multiple of our erase page size
+		if(size % SPIFFS_PHYS_ERASE_SIZE != 0){ 	// make sure size is a multiple of our erase page size
 			return SPIFFS_SFU_ERR_ERASE_SZ;
 		}
 
 		uint32_t num_runs;
 
-		for (num_runs = size / SPIFFS_CFG_PHYS_ERASE_SZ(fs); num_runs > 0; num_runs--) { // erase however many times we need
+		for (num_runs = size / SPIFFS_PHYS_ERASE_SIZE; num_runs > 0; num_runs--) { // erase however many times we need
 			flash_erase_sector(addr);
-			addr = addr + SPIFFS_CFG_PHYS_ERASE_SZ(fs);
+			flash_wait_done(FLASH_T_SE_US); // the chip ignores the next erase (and reads back garbage) until this one's done
+			fs_wear_erased(addr);
+			addr = addr + SPIFFS_PHYS_ERASE_SIZE;
+			spiffs_hal_stats.erases++;
 		}
 		xSemaphoreGive(spiffsHALMutex);
 	} else {
 		serialSendQ("Erase can't get mutex");
 	}
+	hal_latency(&spiffs_hal_stats.erase_time, start);
 	return SPIFFS_OK;
 }
 
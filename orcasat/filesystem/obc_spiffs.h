@@ -5,6 +5,20 @@
  *      Author: Richard
  *
  *      This header includes our mods to spiffs and code required for integration, such as HAL functions.
+ *
+ *      Partitions
+ *      	The flash chip holds two SPIFFS instances (SPIFFS_SINGLETON is 0), each with its own cache, fd table and GC:
+ *      		fs			logs: the subsystem logs and their index sidecars. Bulk data that keeps cycling through blocks
+ *      		fs_state	state: the flag store, the erase counts (obc_fs_wear.h) and other small files we can't lose
+ *      	A flag commit used to land in whatever block the logs had left free, and could start a GC that moved log
+ *      	pages around first. Now state writes only ever GC state blocks, and log traffic doesn't push the flag file
+ *      	out of the cache. Each partition has its own lock: spiffsTopMutex for the logs, spiffsStateMutex for the state. A
+ *      	flag commit doesn't wait for a logs GC or a rotation to let go (obc_fs_service.h). Whoever needs both takes
+ *      	spiffsTopMutex first.
+ *
+ *      	Every block holds a magic that depends on the partition's size (SPIFFS_USE_MAGIC_LENGTH). If a partition
+ *      	doesn't match its layout at boot (blank chip, or written with an older layout) it's formatted. Only the first
+ *      	mount after boot formats: a remount that fails leaves the flash alone.
  */
 
 #ifndef SPIFFS_SFUSAT_SPIFFS_H_
@@ -14,9 +28,74 @@
 #include "rtos_semphr.h"
 #include "obc_fs_structure.h"
 
-extern spiffs fs;
+extern spiffs fs;						// logs partition
 extern spiffs_config cfg;
+extern spiffs fs_state;					// state partition
+extern spiffs_config cfg_state;
 extern SemaphoreHandle_t spiffsTopMutex; // ensures we won't interrupt a read with a write and v/v
+extern SemaphoreHandle_t spiffsStateMutex; // the same for the state partition. Taken after spiffsTopMutex, never before it
+extern uint32_t spiffs_mount_generation; // bumped on every SPIFFS_mount. A mount closes every open fd, so holders of long-lived fds check this
+
+/* HAL call counters
+ * 	- counts calls into the flash HAL and the bytes moved by them
+ * 	- used to benchmark how much flash traffic a filesystem operation really costs
+ * 	- the time each callback took, mutex wait and status polling included, from the PMU cycle counter
+ * 	  (portGET_RUN_TIME_COUNTER_VALUE). erases counts sectors, erase_time counts calls
+ */
+typedef struct spiffs_hal_latency{
+	uint32_t calls;
+	uint32_t max_us;
+	uint64_t total_us;
+} spiffs_hal_latency_t;
+
+typedef struct spiffs_hal_stats{
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t erases;
+	uint32_t read_bytes;
+	uint32_t write_bytes;
+	spiffs_hal_latency_t read_time;
+	spiffs_hal_latency_t write_time;
+	spiffs_hal_latency_t erase_time;
+} spiffs_hal_stats_t;
+
+extern spiffs_hal_stats_t spiffs_hal_stats;
+
+/* Mount state
+ * 	- SPIFFS is mounted once at boot and stays mounted. my_spiffs_mount() only runs the mount scan (which reads the
+ * 	  lookup pages of every block) if it isn't mounted, so filesystem paths call it freely to make sure
+ * 	- after my_spiffs_unmount() or a fatal error (my_spiffs_check_error) the next my_spiffs_mount() remounts
+ */
+typedef struct spiffs_mount_stats{
+	uint32_t mounts;		/* mount scans run */
+	uint32_t cached;		/* my_spiffs_mount calls that found it already mounted */
+	uint32_t failures;		/* mount scans that failed */
+	uint32_t fatal_errors;	/* errors that made us unmount */
+	uint32_t last_reads;	/* HAL reads done by the last mount scan */
+	uint32_t last_ticks;
+	s32_t last_result;
+	uint32_t formats;		/* mounts that found no filesystem and formatted (my_spiffs_allow_format) */
+} spiffs_mount_stats_t;
+
+extern spiffs_mount_stats_t spiffs_mount_stats;			/* logs */
+extern spiffs_mount_stats_t spiffs_state_mount_stats;
+
+/* Partition usage, for "get fs" and stdtelem (my_spiffs_usage)
+ * 	- total and used are SPIFFS_info: data bytes, not counting the two blocks SPIFFS keeps spare
+ * 	- free pages are data pages that are neither in use nor deleted. Deleted pages come back when GC erases their block
+ * 	- the cache and GC counters are SPIFFS_CACHE_STATS and SPIFFS_GC_STATS, which start over on every mount. A low
+ * 	  hit rate means SPIFFS_LOGS_CACHE_PAGES is too small for the files we keep open
+ */
+typedef struct spiffs_usage{
+	uint32_t total;
+	uint32_t used;
+	uint32_t free_blocks;
+	uint32_t pages_free;
+	uint32_t pages_deleted;
+	uint32_t cache_hits;
+	uint32_t cache_misses;
+	uint32_t gc_runs;
+} spiffs_usage_t;
 
 #define SPIFFS_READ_TIMEOUT_MS 5000 // number of ms to wait before giving up on a write instruction. Long since these can take quite a while
 #define SPIFFS_WRITE_TIMEOUT_MS 2000
@@ -30,18 +109,38 @@ void spiffs_read_task(void *pvParameters); // WIP
 void test_spiffs();
 void read_write_example();
 void sfusat_spiffs_init();
+void spiffs_hal_stats_reset();
+s32_t my_spiffs_usage(spiffs *p, spiffs_usage_t *u, TickType_t wait);	/* snapshot under p's mutex, SPIFFS_SFU_ERR_BUSY if it's held for longer than wait */
 // test sequences with RTOS are in test_sequences/test_spiffs_rtos.c
 
 // SPIFFS Config stuff
 #define LOG_PAGE_SIZE       256
-static u8_t spiffs_work_buf[LOG_PAGE_SIZE*2];
-static u8_t spiffs_fds[32*4];
-static u8_t spiffs_cache_buf[(LOG_PAGE_SIZE+32)*4];
+#define SPIFFS_FLASH_SIZE			(1024 * 1024 * 2)
+#define SPIFFS_PHYS_ERASE_SIZE		4096								/* flash_erase_sector() */
+#define SPIFFS_STATE_SIZE			(1024 * 64)							/* top of the chip */
+#define SPIFFS_STATE_ADDR			(SPIFFS_FLASH_SIZE - SPIFFS_STATE_SIZE)
+#define SPIFFS_STATE_BLOCK_SIZE		SPIFFS_PHYS_ERASE_SIZE				/* 16 blocks, so a GC moves at most a few pages */
+#define SPIFFS_LOGS_ADDR			0
+#define SPIFFS_LOGS_SIZE			SPIFFS_STATE_ADDR
+#define SPIFFS_LOGS_BLOCK_SIZE		32768
+#define SPIFFS_STATE_FH_OFFSET		100									/* state fds are 101 and up, logs fds start at 1 */
+#ifndef SPIFFS_LOGS_CACHE_PAGES
+#define SPIFFS_LOGS_CACHE_PAGES		4									/* check the hit rate in "get fs" before changing these */
+#endif
+#ifndef SPIFFS_STATE_CACHE_PAGES
+#define SPIFFS_STATE_CACHE_PAGES	2
+#endif
+#define SPIFFS_HAL_CYCLES_PER_US	((uint32_t)GCLK_FREQ)				/* PMU cycle counter rate, GCLK in MHz (system.h) */
+// the work, fd and cache buffers for both partitions are in obc_spiffs.c
 
 // SPIFFS HAL
-void my_spiffs_mount();
-static s32_t my_spiffs_read(u32_t addr, u32_t size, u8_t *dst);
-static s32_t my_spiffs_write(u32_t addr, u32_t size, u8_t *src);
-static s32_t my_spiffs_erase(u32_t addr, u32_t size);
+s32_t my_spiffs_mount();					/* mounts the logs partition if not mounted already */
+void my_spiffs_unmount();
+s32_t my_spiffs_check_error(s32_t err);		/* unmounts on errors a remount could fix, returns err */
+s32_t my_spiffs_mount_state();				/* same for the state partition */
+void my_spiffs_unmount_state();
+s32_t my_spiffs_state_check_error(s32_t err);
+s32_t my_spiffs_erase_chip();				/* chip erase, both partitions formatted and mounted again */
+void my_spiffs_allow_format();				/* the next mounts format a partition with no filesystem on it */
 
 #endif /* SPIFFS_SFUSAT_SPIFFS_H_ */
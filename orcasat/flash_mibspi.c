@@ -16,6 +16,11 @@
 #include "obc_spiffs.h"
 #include "obc_utils.h"
 #include "flash_mibspi.h"
+#if FLASH_USE_DMA
+#include "sys_dma.h"
+#endif
+#include "system.h"
+#include "rtos_task.h"
 
 // Transfer group completion flags
 uint8_t TG0_IS_Complete;
@@ -23,6 +28,32 @@ uint8_t TG1_IS_Complete;
 uint8_t TG2_IS_Complete;
 uint8_t TG3_IS_Complete;
 uint8_t TG4_IS_Complete;
+uint8_t TG5_IS_Complete;
+
+flash_wait_stats_t flash_wait_stats;
+
+// TG5 buffer control words. Buffer mode 4 is what HALCoGen uses for the other groups, 0 means the buffer is skipped
+#define STREAM_BUF_ACTIVE	((uint16_t)((uint16_t)4U << 13U) | ((uint16_t)(~((uint16_t)0xFFU ^ (uint16_t)CS_0)) & (uint16_t)0x00FFU))
+#define STREAM_BUF_SKIP		((uint16_t)(~((uint16_t)0xFFU ^ (uint16_t)CS_0)) & (uint16_t)0x00FFU)
+#define STREAM_BUF_CSHOLD	((uint16_t)((uint16_t)1U << 12U))
+
+// the low byte of a buffer's 16 bit data field, where the DMA reads and writes. Big-endian, so the second byte
+#define STREAM_DATA_LSB		1U
+
+static volatile TaskHandle_t stream_task; // waiting for TG5, notified by mibspiGroupNotification when it completes
+static uint32_t stream_start; // first buffer of TG5
+static uint32_t stream_count; // buffers TG5 is set up to send, and whether the last one holds CS
+static bool stream_hold;
+
+static void flash_stream_init();
+static void flash_stream_config(uint32_t count, bool hold);
+static bool flash_stream_transfer();
+#if FLASH_USE_DMA
+static bool flash_dma_copy(uint32_t src, uint32_t dst, uint32_t count, bool to_buffers);
+#endif
+static bool flash_stream(uint16_t command, uint32_t address, const uint8_t *src, uint8_t *dst, uint32_t size);
+static bool flash_page_program(uint32_t address, uint32_t size, const uint8_t *src);
+static bool flash_spin_expired(uint32_t start);
 
 void mibspi_write_byte(uint16_t toWrite){
     while (TG1_IS_Complete != 0xA5){} // wait for other transfers to complete
@@ -42,15 +73,43 @@ void flash_erase_chip(){
 }
 
 void flash_busy_erasing_chip(){
-    uint16_t buf[2] = {0};
-
-    mibspi_write_two(READ_REG_STATUS,0x0000);
-    mibspi_receive(FLASH_2_BYTE_GROUP,buf);
+    flash_wait_done(FLASH_T_CE_US);
+}
 
-    while(buf[1] == 0x0003 && buf[0] == 0x00ff){ // reports 131 while still erasing. Takes ~45ms to do a chip erase
-        mibspi_write_two(READ_REG_STATUS,0x0000);
-        mibspi_receive(FLASH_2_BYTE_GROUP,buf);
-    }
+void flash_wait_done(uint32_t typ_us){
+	// Sleeps the typical time, then polls every typ_us / FLASH_WAIT_POLLS. Less than a tick (Page Program) can't sleep,
+	// so polls with a yield in between for the tasks at our priority. Without the scheduler, just polls
+	TickType_t first = pdMS_TO_TICKS(typ_us / 1000);
+	TickType_t delay = pdMS_TO_TICKS(typ_us / 1000 / FLASH_WAIT_POLLS);
+	uint32_t start = portGET_RUN_TIME_COUNTER_VALUE();
+	uint32_t sleep_start;
+	bool rtos = (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING);
+
+	flash_wait_stats.waits++;
+	if(rtos && first > 0){
+		sleep_start = portGET_RUN_TIME_COUNTER_VALUE();
+		vTaskDelay(first);
+		flash_wait_stats.sleeps++;
+		flash_wait_stats.slept_us += ((uint32_t)portGET_RUN_TIME_COUNTER_VALUE() - sleep_start) / SPIFFS_HAL_CYCLES_PER_US;
+	}
+	while(1){
+		flash_wait_stats.polls++;
+		if((flash_status() & STATUS_WIP) == 0){
+			break;
+		}
+		if(!rtos){
+			continue;
+		}
+		if(first == 0){
+			taskYIELD();
+			continue;
+		}
+		sleep_start = portGET_RUN_TIME_COUNTER_VALUE();
+		vTaskDelay((delay > 0) ? delay : 1);
+		flash_wait_stats.sleeps++;
+		flash_wait_stats.slept_us += ((uint32_t)portGET_RUN_TIME_COUNTER_VALUE() - sleep_start) / SPIFFS_HAL_CYCLES_PER_US;
+	}
+	flash_wait_stats.wait_us += ((uint32_t)portGET_RUN_TIME_COUNTER_VALUE() - start) / SPIFFS_HAL_CYCLES_PER_US;
 }
 
 void flash_set_burst_64(){
@@ -189,59 +248,231 @@ void construct_send_packet_16(uint16_t command, uint32_t address, uint16_t *pack
     mibspi_send(FLASH_20_BYTE_GROUP, sendOut);
 }
 
-void flash_write_arbitrary(uint32_t address, uint32_t size, uint8_t *src){
-	// for size, every 16 bytes, construct a packet and send it out.
-
-	uint16_t sendOut[16] = { 0 };
-	uint32_t outIndex; // the place in each output frame
-	uint32_t inIndex; // the place in the input data buffer
-	uint32_t numDummy;
-
-		outIndex = 0; // the place in each frame
-		for(inIndex = 0; inIndex < size; inIndex ++){
-			sendOut[outIndex] = src[inIndex]; // put the next char into the send buffer
-			outIndex++;
-			if(outIndex == 16){ // (16 not 15 since we increment it right above) - every 16, send out and increment address for the next one
-				construct_send_packet_16(FLASH_WRITE, address, sendOut);
-				  while(flash_status() != 0){ // wait for the write to complete
-					}
-				outIndex = 0;
-				address += 16;
+bool flash_write_arbitrary(uint32_t address, uint32_t size, uint8_t *src){
+	// one Page Program per page the data touches. Waits for each one but the last, the caller polls for that.
+	// Stops at the first page whose transfer didn't finish
+	uint32_t n;
+
+	while(size > 0){
+		n = FLASH_PAGE_SIZE - (address % FLASH_PAGE_SIZE); // to the end of this page
+		if(n > size){
+			n = size;
+		}
+		if(!flash_page_program(address, n, src)){
+			return false;
+		}
+		address += n;
+		src += n;
+		size -= n;
+		if(size > 0){
+			flash_wait_done(FLASH_T_PP_US); // wait for the write to complete
+		}
+	}
+	return true;
+}
+
+static bool flash_page_program(uint32_t address, uint32_t size, const uint8_t *src){
+	// size bytes from address, all within one page
+	mibspi_write_byte(WRITE_ENABLE);
+	return flash_stream(FLASH_WRITE, address, src, NULL, size);
+}
+
+static bool flash_stream(uint16_t command, uint32_t address, const uint8_t *src, uint8_t *dst, uint32_t size){
+	// one command: command and address, then size bytes, sent from src or received into dst. CS stays low until the
+	// end. FLASH_STREAM_LEN bytes per TG5 transfer, the last buffer of all but the last transfer holds CS.
+	// false if a transfer or a DMA copy didn't finish in time: the rest of the command is dropped
+	uint16_t header[4];
+	uint32_t header_len = 4; // header words left to send
+	uint32_t remaining = 4 + size;
+	uint32_t count;
+	uint32_t skip; // header words in this transfer
+	uint32_t i;
+
+	header[0] = command;
+	header[1] = (address & 0xFF0000) >> 16;
+	header[2] = (address & 0xFF00) >> 8;
+	header[3] = (address) & 0xFF;
+
+	while(remaining > 0){
+		count = (remaining < FLASH_STREAM_LEN) ? remaining : FLASH_STREAM_LEN;
+		skip = (header_len < count) ? header_len : count;
+		for(i = 0; i < skip; i++){
+			FLASH_MIBSPI_RAM->tx[stream_start + i].data = header[4 - header_len];
+			header_len--;
+		}
+		if(src != NULL && count > skip){
+#if FLASH_USE_DMA
+			if(!flash_dma_copy((uint32_t)src, (uint32_t)&FLASH_MIBSPI_RAM->tx[stream_start + skip].data + STREAM_DATA_LSB,
+					count - skip, true)){
+				return false;
 			}
+			src += count - skip;
+#else
+			for(i = skip; i < count; i++){
+				FLASH_MIBSPI_RAM->tx[stream_start + i].data = *src++;
+			}
+#endif
+		} // when receiving, whatever's left in the TX buffers goes out. The chip ignores it
+		remaining -= count;
+		flash_stream_config(count, remaining > 0);
+
+		if(!flash_stream_transfer()){
+			return false;
 		}
 
-		// Handle packing in dummy bytes for cases where data isn't a multiple of 16 bytes
-		if(outIndex != 0){
-			for(numDummy = 16 - outIndex; numDummy > 0; numDummy--){
-				sendOut[outIndex] = 0xff; // empty or unprogrammed value for flash is 1
-				outIndex++;
+		if(dst != NULL && count > skip){ // straight out of the RX buffers, only the low byte of each is data
+#if FLASH_USE_DMA
+			if(!flash_dma_copy((uint32_t)&FLASH_MIBSPI_RAM->rx[stream_start + skip].data + STREAM_DATA_LSB, (uint32_t)dst,
+					count - skip, false)){
+				return false;
+			}
+			dst += count - skip;
+#else
+			for(i = skip; i < count; i++){
+				*dst++ = (uint8_t)FLASH_MIBSPI_RAM->rx[stream_start + i].data;
 			}
-			construct_send_packet_16(FLASH_WRITE, address, sendOut);
+#endif
+		}
+	}
+	return true;
+}
+
+static bool flash_stream_transfer(){
+	// one TG5 transfer. The calling task blocks on its notification until mibspiGroupNotification says it's done
+	// (~100 us for 64 bytes at 5 MHz). Without the scheduler, spins. Either way false (and counted) if it isn't done
+	// within FLASH_STREAM_TIMEOUT. The flag decides: whatever else was pending on the notification is cleared first,
+	// and a notification from anyone else just means another look
+	TickType_t begin;
+	uint32_t start;
+
+	TG5_IS_Complete = 0x0000;
+	if(xTaskGetSchedulerState() == taskSCHEDULER_RUNNING){
+		ulTaskNotifyTake(pdTRUE, 0);
+		stream_task = xTaskGetCurrentTaskHandle();
+		begin = xTaskGetTickCount();
+		mibspiTransfer(FLASH_MIBSPI_REG, FLASH_STREAM_GROUP);
+		while(TG5_IS_Complete != 0xA5 && (xTaskGetTickCount() - begin) < FLASH_STREAM_TIMEOUT){
+			ulTaskNotifyTake(pdTRUE, FLASH_STREAM_TIMEOUT - (xTaskGetTickCount() - begin));
+		}
+		stream_task = NULL;
+	} else {
+		start = portGET_RUN_TIME_COUNTER_VALUE();
+		mibspiTransfer(FLASH_MIBSPI_REG, FLASH_STREAM_GROUP);
+		while(TG5_IS_Complete != 0xA5 && !flash_spin_expired(start)){
+			// wait for the transfer to finish up
 		}
+	}
+	if(TG5_IS_Complete != 0xA5){
+		flash_wait_stats.stream_timeouts++;
+		return false;
+	}
+	return true;
 }
 
-void flash_read_arbitrary(uint32_t address, uint32_t size, uint8_t *dest){
-	uint32_t readCounter; // the place in each output frame
-	uint32_t inIndex; // the place in the input data buffer
-	uint16_t readBuffer[16] = {0xFFFF}; // since F is empty flash value but we only ever use the 8 LSB's
+void flash_stream_complete_fromISR(){
+	// mibspiGroupNotification for TG5
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	TaskHandle_t task = stream_task;
 
-	readCounter = 0;
-	inIndex = 0;
+	TG5_IS_Complete = 0xA5;
+	if(task != NULL){
+		vTaskNotifyGiveFromISR(task, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+}
 
-	flash_read_16(address, readBuffer); // read first 16 bytes
+static bool flash_spin_expired(uint32_t start){
+	// for the waits too short to block on. start is the PMU cycle count when the wait started
+	return ((uint32_t)portGET_RUN_TIME_COUNTER_VALUE() - start) / SPIFFS_HAL_CYCLES_PER_US >= FLASH_SPIN_TIMEOUT_US;
+}
 
-		for(readCounter = 0; readCounter < size; readCounter++){ // loop through entire size and stick the bytes into the dest array
-			dest[readCounter] = readBuffer[inIndex];
-			inIndex++;
+#if FLASH_USE_DMA
+static bool flash_dma_copy(uint32_t src, uint32_t dst, uint32_t count, bool to_buffers){
+	// count bytes between RAM and consecutive TG5 buffers (4 bytes apart in the MibSPI RAM), one software triggered
+	// block. Waits for the block transfer complete flag: 64 bytes take the DMA less than a context switch would.
+	// false (and counted) if the flag isn't up within FLASH_SPIN_TIMEOUT_US, the channel is stopped then
+	g_dmaCTRL pkt;
+	uint32_t start;
+
+	pkt.SADD = src;
+	pkt.DADD = dst;
+	pkt.CHCTRL = 0;
+	pkt.FRCNT = 1;
+	pkt.ELCNT = count;
+	pkt.ELDOFFSET = to_buffers ? 4 : 0;
+	pkt.ELSOFFSET = to_buffers ? 0 : 4;
+	pkt.FRDOFFSET = 0;
+	pkt.FRSOFFSET = 0;
+	pkt.PORTASGN = 4; // port B, the MibSPI RAM is a peripheral
+	pkt.RDSIZE = ACCESS_8_BIT;
+	pkt.WRSIZE = ACCESS_8_BIT;
+	pkt.TTYPE = BLOCK_TRANSFER;
+	pkt.ADDMODERD = to_buffers ? ADDR_INC1 : ADDR_OFFSET;
+	pkt.ADDMODEWR = to_buffers ? ADDR_OFFSET : ADDR_INC1;
+	pkt.AUTOINIT = AUTOINIT_OFF;
+	pkt.COMBO = 0;
+
+	dmaSetCtrlPacket(FLASH_DMA_CH, pkt);
+	start = portGET_RUN_TIME_COUNTER_VALUE();
+	dmaSetChEnable(FLASH_DMA_CH, DMA_SW);
+	while((dmaREG->BTCFLAG & ((uint32)1U << FLASH_DMA_CH)) == 0U){
+		if(flash_spin_expired(start)){
+			dmaREG->SWCHENAR = (uint32)1U << FLASH_DMA_CH;
+			flash_wait_stats.stream_timeouts++;
+			return false;
+		}
+	}
+	dmaREG->BTCFLAG = (uint32)1U << FLASH_DMA_CH; // write 1 to clear
+	return true;
+}
+#endif /* FLASH_USE_DMA */
 
-			// Read the next 16 bytes
-			if(inIndex == 16){ // since we increment it above
-				inIndex = 0;
-				address += 16;
-				flash_read_16(address, readBuffer); // read first 16 bytes
-			}
+static void flash_stream_config(uint32_t count, bool hold){
+	// send the first count buffers of TG5 and skip the rest. The last one drops CS unless hold
+	uint32_t i;
+	uint16_t control;
+
+	if(count == stream_count && hold == stream_hold){
+		return;
+	}
+	for(i = 0; i < FLASH_STREAM_LEN; i++){
+		control = (i < count) ? STREAM_BUF_ACTIVE : STREAM_BUF_SKIP;
+		if(i + 1 < count || hold){
+			control |= STREAM_BUF_CSHOLD;
 		}
+		FLASH_MIBSPI_RAM->tx[stream_start + i].control = control;
+	}
+	stream_count = count;
+	stream_hold = hold;
+}
+
+static void flash_stream_init(){
+	// TG5 goes in the FLASH_STREAM_LEN buffers after TG4. HALCoGen leaves TG5-7 empty, so they all start where TG4
+	// ends (LTGPEND). Move the start of everything after TG5 and LTGPEND past it. Only while no group is running
+	uint32_t g;
+
+	stream_start = ((FLASH_MIBSPI_REG->LTGPEND & 0x00007F00U) >> 8U) + 1U;
+	for(g = FLASH_STREAM_GROUP + 1; g <= 8; g++){
+		FLASH_MIBSPI_REG->TGCTRL[g] = (FLASH_MIBSPI_REG->TGCTRL[g] & 0xFFFF00FFU) | ((stream_start + FLASH_STREAM_LEN) << 8U);
+	}
+	FLASH_MIBSPI_REG->LTGPEND = (FLASH_MIBSPI_REG->LTGPEND & 0xFFFF00FFU) | ((stream_start + FLASH_STREAM_LEN - 1U) << 8U);
+
+	stream_count = 0;
+	flash_stream_config(FLASH_STREAM_LEN, true);
 
+#if FLASH_USE_DMA
+	// the DMA's interrupt lines are off in HALCoGen, enabling BTC here just sets the flag flash_dma_copy waits on
+	dmaEnable();
+	dmaEnableInterrupt(FLASH_DMA_CH, BTC);
+#endif
+}
+
+bool flash_read_arbitrary(uint32_t address, uint32_t size, uint8_t *dest){
+	// one Read command for all of it, the chip carries on to the next address for as long as CS is low
+	if(size > 0){
+		return flash_stream(FLASH_READ, address, NULL, dest, size);
+	}
+	return true;
 }
 
 boolean flash_test_JEDEC(void){
@@ -299,12 +530,15 @@ void flash_mibspi_init(){
 	mibspiEnableGroupNotification(FLASH_MIBSPI_REG,FLASH_2_BYTE_GROUP,FLASH_DATA_FORMAT);
 	mibspiEnableGroupNotification(FLASH_MIBSPI_REG,FLASH_4_BYTE_GROUP,FLASH_DATA_FORMAT);
 	mibspiEnableGroupNotification(FLASH_MIBSPI_REG,FLASH_20_BYTE_GROUP,FLASH_DATA_FORMAT);
+	flash_stream_init();
+	mibspiEnableGroupNotification(FLASH_MIBSPI_REG,FLASH_STREAM_GROUP,FLASH_DATA_FORMAT);
 
 	TG0_IS_Complete = 0xA5; // start as complete
 	TG1_IS_Complete = 0xA5; // start as complete
 	TG2_IS_Complete = 0xA5; // start as complete
 	TG3_IS_Complete = 0xA5; // start as complete
 	TG4_IS_Complete = 0xA5;
+	TG5_IS_Complete = 0xA5;
 
 	// Init by write enable and global unlock
 	flash_write_enable();
@@ -329,6 +563,9 @@ void mibspi_send(uint8_t transfer_group, uint16_t * TX_DATA){
     case 4:
         TG4_IS_Complete = 0x0000;
         break;
+    case 5:
+        TG5_IS_Complete = 0x0000;
+        break;
     }
 
     mibspiSetData(FLASH_MIBSPI_REG,transfer_group, TX_DATA);
@@ -369,6 +606,11 @@ void mibspi_receive(uint8_t transfer_group,uint16_t * RX_DATA){
             // wait for the transfer to finish up
         }
         break;
+    case 5:
+        while(TG5_IS_Complete != 0xA5){
+            // wait for the transfer to finish up
+        }
+        break;
     }
     mibspiGetData(FLASH_MIBSPI_REG,transfer_group,RX_DATA);
 }
@@ -14,6 +14,29 @@
  *      2			2
  *      3			20
  *      4			4
+ *      5			FLASH_STREAM_LEN, in the buffers after TG4. Not in HALCoGen, flash_mibspi_init sets it up
+ *
+ *      TG5 is for commands longer than a transfer group. Every buffer holds CS low after it, so the command carries on
+ *      over as many TG5 transfers as it needs, and the last one drops CS after its last byte. flash_write_arbitrary
+ *      sends a whole page (256 bytes) per Page Program this way, and flash_read_arbitrary reads everything it's asked
+ *      for with one Read, straight from the RX buffers into the caller's buffer.
+ *
+ *      The data of a TG5 transfer is copied into and out of the buffers by DMA (FLASH_DMA_CH) on the platforms with
+ *      FLASH_USE_DMA set in obc_hardwaredefs.h, and by the CPU on the others. Either way the calling task
+ *      blocks on its task notification until TG5 completes instead of spinning, so a task that uses the flash can't
+ *      use its notification for anything else. The other groups are a few bytes long, quicker than blocking and waking
+ *      up again, so they still spin. A TG5 transfer or DMA copy that doesn't finish in time fails its command:
+ *      flash_read_arbitrary and flash_write_arbitrary return false, and the SPIFFS HAL returns SPIFFS_SFU_ERR_FLASH.
+ *
+ *      Waiting for a program or erase to finish goes through flash_wait_done, which sleeps the calling task for most
+ *      of it instead of polling the status register. flash_wait_stats says how much CPU time that gave the other tasks.
+ *
+ *      Erases aren't suspended for reads (FLASH_SUSPEND). Every SPIFFS read and every sector erase, GC's included,
+ *      runs under its partition's mutex, so no read waits on spiffsHALMutex for an erase on its own partition. A state
+ *      partition read can wait for one logs sector erase (SPIFFS erases a block a sector per HAL call), which is what
+ *      the filesystem service's state lane trades for not waiting out a whole GC step (obc_fs_service.h).
+ *      Chip Erase can't be suspended on either chip (only Sector/Block Erase and Page Program can), and while it runs
+ *      there is nothing on the chip left to read.
  *
  *      Keep in mind that ERASED flash is all 1's. So don't fill space with 0's if you will want to use it later, since erasing
  *      is slow.
@@ -36,6 +59,7 @@ extern uint8_t TG1_IS_Complete;
 extern uint8_t TG2_IS_Complete;
 extern uint8_t TG3_IS_Complete;
 extern uint8_t TG4_IS_Complete;
+extern uint8_t TG5_IS_Complete;
 
 // Flash Specific
 void flash_mibspi_init();
@@ -59,8 +83,8 @@ void construct_send_packet_6(uint16_t command, uint32_t address, uint16_t * pack
 void construct_send_packet_16(uint16_t command, uint32_t address, uint16_t * packet);
 
 // For SPIFFS
-void flash_write_arbitrary(uint32_t address, uint32_t size, uint8_t *src); // write an arbitrary data buffer to flash
-void flash_read_arbitrary(uint32_t address, uint32_t size, uint8_t *dest);
+bool flash_write_arbitrary(uint32_t address, uint32_t size, uint8_t *src); // write an arbitrary data buffer to flash. false if a transfer timed out
+bool flash_read_arbitrary(uint32_t address, uint32_t size, uint8_t *dest); // false if a transfer timed out, dest isn't all read then
 
 // SPI drivers
 void mibspi_send(uint8_t transfer_group, uint16_t * TX_DATA);
@@ -68,6 +92,38 @@ void mibspi_receive(uint8_t transfer_group,uint16_t * RX_DATA);
 void mibspi_write_byte(uint16_t toWrite);
 void mibspi_write_two(uint16_t arg1, uint16_t arg2);
 
+// Stream transfer group
+#define FLASH_STREAM_LEN 64 // buffers (bytes) in FLASH_STREAM_GROUP
+#define FLASH_PAGE_SIZE 256 // Page Program wraps around within a page, so commands are split at page boundaries
+#define FLASH_DMA_CH 0 // DMA channel for copies into and out of the TG5 buffers
+#define FLASH_STREAM_TIMEOUT pdMS_TO_TICKS(10) // a TG5 transfer takes ~100 us. One that isn't done after this never will be
+#define FLASH_SPIN_TIMEOUT_US 1000 // same for the waits that spin: DMA copies (~1 us) and TG5 without the scheduler
+
+void flash_stream_complete_fromISR(); // from mibspiGroupNotification, TG5 is done
+
+// Program and erase times. flash_wait_done sleeps this long before it polls, so better a little short than long
+#define FLASH_T_PP_US 200 // Page Program, typical
+#define FLASH_T_SE_US 70000 // Sector Erase, typical
+#if FLASH_CHIP_TYPE == 1
+#define FLASH_T_CE_US 5000000 // Chip Erase, IS25LP016D. Seconds
+#else
+#define FLASH_T_CE_US 35000 // Chip Erase, SST26
+#endif
+#define FLASH_WAIT_POLLS 16 // after the typical time, poll every typical / FLASH_WAIT_POLLS (at least a tick)
+
+typedef struct flash_wait_stats {
+	uint32_t waits;
+	uint32_t polls; // status register reads
+	uint32_t sleeps;
+	uint64_t wait_us; // from the start of each wait until the chip was done
+	uint64_t slept_us; // of which asleep in vTaskDelay, CPU time the other tasks got instead of us polling
+	uint32_t stream_timeouts; // TG5 transfers and DMA copies that didn't finish, their command was dropped
+} flash_wait_stats_t;
+
+extern flash_wait_stats_t flash_wait_stats;
+
+void flash_wait_done(uint32_t typ_us); // until the program or erase in progress is done
+
 // Flash Commands
 #define FLASH_READ 0x0003
 #define FLASH_RDID 0xAB00 // flash read product ID + 1 dummy byte
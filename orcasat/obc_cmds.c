@@ -16,6 +16,11 @@
 #include "obc_task_radio.h"
 #include "deployables.h"
 #include "obc_fs_structure.h"
+#include "obc_fs_gc.h"
+#include "obc_fs_wear.h"
+#include "obc_fs_appender.h"
+#include "obc_fs_check.h"
+#include "obc_spiffs.h"
 #include "flash_mibspi.h"
 #include "obc_gps.h"
 
@@ -73,6 +78,9 @@ static const struct subcmd_opt CMD_HELP_OPTS[] = {
 							  "  minheap -- Show lowest size of free heap ever reached\n"
 							  "  types   -- Show size of various types (debugging)\n"
 							  "	 epoch   -- Show current OBC epoch\n"
+							  "  gc      -- Show flash garbage collection stats\n"
+							  "  wear    -- Show flash erase count histograms\n"
+							  "  fs      -- Show partition usage, cache hit rates, flash HAL latency and consistency checks\n"
 		},
 		{
 				.subcmd_id	= CMD_HELP_EXEC,
@@ -153,6 +161,12 @@ static const struct subcmd_opt CMD_HELP_OPTS[] = {
 				.info		=  "File commands."
 								"  dump\n"
 								"    Dumps a file.\n"
+								"  range <suffix><t0><t1>\n"
+								"    Dumps a log between two RTC times (hex, 4 bytes each).\n"
+								"  size <prefix><suffix>\n"
+								"    Shows the size of a file.\n"
+								"  stats\n"
+								"    Shows the current logs' sizes and the appender totals.\n"
 		},
 		{
 				.subcmd_id	= CMD_RESTART,
@@ -213,6 +227,18 @@ static const struct subcmd_opt CMD_GET_OPTS[] = {
 				.subcmd_id	= CMD_GET_EPOCH,
 				.name		= "epoch",
 		},
+		{
+				.subcmd_id	= CMD_GET_GC,
+				.name		= "gc",
+		},
+		{
+				.subcmd_id	= CMD_GET_WEAR,
+				.name		= "wear",
+		},
+		{
+				.subcmd_id	= CMD_GET_FS,
+				.name		= "fs",
+		},
 };
 char buffer[250];
 int8_t cmdGet(const CMD_t *cmd) {
@@ -262,6 +288,77 @@ int8_t cmdGet(const CMD_t *cmd) {
 			serialSend(buffer);
 			return 1;
 		}
+		case CMD_GET_GC: {
+			sprintf(buffer, "free blocks: %u (reserve %u)\n"
+					"pages alloc: %u, deleted: %u\n"
+					"spiffs runs: %u\n"
+					"bg quick: %u, full: %u, err: %u\n"
+					"fg runs: %u\n"
+					"last: %u ms, max: %u ms\n"
+					, fs.free_blocks, FS_GC_RESERVE_BLOCKS, fs.stats_p_allocated, fs.stats_p_deleted, fs.stats_gc_runs
+					, fs_gc_stats.quick_runs, fs_gc_stats.full_runs, fs_gc_stats.errors, fs_gc_stats.foreground_runs
+					, fs_gc_stats.last_ticks * portTICK_PERIOD_MS, fs_gc_stats.max_ticks * portTICK_PERIOD_MS);
+			serialSend(buffer);
+			return 1;
+		}
+		case CMD_GET_WEAR: {
+			/* one line per partition: sectors, min-max, mean, then how many sectors fall in each bin from min up */
+			const uint32_t addrs[] = { SPIFFS_LOGS_ADDR, SPIFFS_STATE_ADDR };
+			const uint32_t sizes[] = { SPIFFS_LOGS_SIZE, SPIFFS_STATE_SIZE };
+			const char *names[] = { "logs", "state" };
+			fs_wear_hist_t h;
+			uint8_t i;
+
+			for (i = 0; i < LEN(addrs); i++) {
+				fs_wear_histogram(addrs[i], sizes[i], &h);
+				sprintf(buffer, "%s: %u sectors, %u-%u, mean %u, x%u: %u %u %u %u %u %u %u %u\n"
+						, names[i], h.sectors, h.min, h.max, h.total / h.sectors, h.width
+						, h.bins[0], h.bins[1], h.bins[2], h.bins[3], h.bins[4], h.bins[5], h.bins[6], h.bins[7]);
+				serialSend(buffer);
+			}
+			sprintf(buffer, "erases since boot: %u, saves: %u (seq %u, err %u, bad %u), gc ages: %s\n"
+					, fs_wear_stats.erases, fs_wear_stats.saves, fs_wear_stats.seq, fs_wear_stats.save_errors
+					, fs_wear_stats.bad_copies, fs_wear_gc ? "ours" : "spiffs");
+			serialSend(buffer);
+			return 1;
+		}
+		case CMD_GET_FS: {
+			/* a line per partition, then the mean and max time of each HAL call. Cache and GC counts are since mount */
+			spiffs *parts[] = { &fs, &fs_state };
+			const char *names[] = { "logs", "state" };
+			const spiffs_hal_latency_t *lat[] = { &spiffs_hal_stats.read_time, &spiffs_hal_stats.write_time, &spiffs_hal_stats.erase_time };
+			const char *ops[] = { "read", "write", "erase" };
+			spiffs_usage_t u;
+			s32_t res;
+			uint8_t i;
+
+			for (i = 0; i < LEN(parts); i++) {
+				res = my_spiffs_usage(parts[i], &u, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS));
+				if (res < 0) {
+					sprintf(buffer, "%s: %d\n", names[i], res);
+				} else {
+					sprintf(buffer, "%s: %u/%u B, %u free blocks, pages free %u deleted %u, cache %u/%u hits (%u%%), gc %u\n"
+							, names[i], u.used, u.total, u.free_blocks, u.pages_free, u.pages_deleted
+							, u.cache_hits, u.cache_hits + u.cache_misses
+							, (u.cache_hits + u.cache_misses > 0) ? (uint32_t)((uint64_t)u.cache_hits * 100 / (u.cache_hits + u.cache_misses)) : 0
+							, u.gc_runs);
+				}
+				serialSend(buffer);
+			}
+			for (i = 0; i < LEN(lat); i++) {
+				sprintf(buffer, "%s: %u calls, mean %u us, max %u us\n", ops[i], lat[i]->calls
+						, (lat[i]->calls > 0) ? (uint32_t)(lat[i]->total_us / lat[i]->calls) : 0, lat[i]->max_us);
+				serialSend(buffer);
+			}
+			sprintf(buffer, "flash waits: %u, %u polls, %u ms waited, %u ms asleep\n", flash_wait_stats.waits
+					, flash_wait_stats.polls, (uint32_t)(flash_wait_stats.wait_us / 1000), (uint32_t)(flash_wait_stats.slept_us / 1000));
+			serialSend(buffer);
+			sprintf(buffer, "check: %u passes, %u blocks, %u errors (last pass %u, this one %u), max %u ms\n"
+					, fs_check_stats.passes, fs_check_stats.blocks, fs_check_stats.errors, fs_check_stats.last_pass_errors
+					, fs_check_stats.pass_errors, fs_check_stats.max_ticks * portTICK_PERIOD_MS);
+			serialSend(buffer);
+			return 1;
+		}
 	}
 	serialSendQ("get: unknown sub-command");
 	return 0;
@@ -427,13 +524,17 @@ static const struct subcmd_opt CMD_WD_OPTS[] = {
 int8_t cmdWd(const CMD_t *cmd) {
 		if (cmd->subcmd_id == CMD_WD_RESET){
 			serialSendQ("Suspending watchdog task!");
+			sfu_flush_logs(); /* the watchdog will reset us, don't lose staged log entries */
 			vTaskSuspend(xTickleTaskHandle);
 			return 1;
 		}
 		if (cmd->subcmd_id == CMD_WD_F_RESET){
+			s32_t res;
+
 			serialSendln("Flash erasing");
-			flash_erase_chip();
-			serialSendln("Flash erased");
+			res = sfu_erase_chip(); /* unmounts, erases, formats and remounts */
+			sprintf(buffer, "Flash erased: %d", res);
+			serialSendln(buffer);
 			vTaskSuspend(xTickleTaskHandle);
 			return 1;
 		}
@@ -522,6 +623,14 @@ static const struct subcmd_opt CMD_FILE_OPTS[] = {
 				.subcmd_id	= CMD_FILE_ERASE,
 				.name		= "erase",
 		},
+		{
+				.subcmd_id	= CMD_FILE_RANGE,
+				.name		= "range",
+		},
+		{
+				.subcmd_id	= CMD_FILE_STATS,
+				.name		= "stats",
+		},
 };
 
 int8_t cmdFile(const CMD_t *cmd) {
@@ -538,14 +647,47 @@ int8_t cmdFile(const CMD_t *cmd) {
 			return 1;
 		}
 		if (cmd->subcmd_id == CMD_FILE_SIZE){
-			// todo: snag this from spiffs struct
+			uint32_t size;
+			s32_t res = sfu_read_range(cmd->cmd_file_data.prefix, cmd->cmd_file_data.suffix, 0, NULL, 0, &size);
+
+			if (res < 0) {
+				sprintf(buffer, "%c%c: %d\n", cmd->cmd_file_data.prefix, cmd->cmd_file_data.suffix, res);
+			} else {
+				sprintf(buffer, "%c%c: %u bytes\n", cmd->cmd_file_data.prefix, cmd->cmd_file_data.suffix, size);
+			}
+			serialSend(buffer);
+			return 1;
+		}
+		if (cmd->subcmd_id == CMD_FILE_STATS){
+			/* sizes on flash (staged entries aren't in them yet), then the appender totals since boot */
+			uint32_t size;
+			s32_t res;
+			uint8_t i;
+
+			for (i = 0; i < FSYS_NUM_SUBSYS; i++) {
+				res = sfu_read_range(getCurrentPrefix(), FSYS_OFFSET + i, 0, NULL, 0, &size);
+				sprintf(buffer, "%c%c: %d\n", getCurrentPrefix(), FSYS_OFFSET + i, (res < 0) ? res : (int32_t)size);
+				serialSend(buffer);
+			}
+			sprintf(buffer, "appended %u B, %u write outs, %u B written\n"
+					, fs_appender_stats.bytes, fs_appender_stats.write_outs, fs_appender_stats.write_out_bytes);
+			serialSend(buffer);
 			return 1;
 		}
 		if (cmd->subcmd_id == CMD_FILE_ERASE){
+			s32_t res;
+
 			serialSendln("Flash erasing");
-			flash_erase_chip();
-			serialSendln("Flash erased");
-			fs_num_increments = 0;
+			res = sfu_erase_chip(); /* unmounts, erases, formats and remounts */
+			sprintf(buffer, "Flash erased: %d", res);
+			serialSendln(buffer);
+			return 1;
+		}
+		if (cmd->subcmd_id == CMD_FILE_RANGE){
+			const CMD_FILE_RANGE_DATA_t *range = &cmd->cmd_file_range_data;
+			dumpLogRange(range->suffix,
+					((uint32_t)range->t0[0] << 24) | ((uint32_t)range->t0[1] << 16) | ((uint32_t)range->t0[2] << 8) | range->t0[3],
+					((uint32_t)range->t1[0] << 24) | ((uint32_t)range->t1[1] << 16) | ((uint32_t)range->t1[2] << 8) | range->t1[3]);
 			return 1;
 		}
 		else{
@@ -879,6 +1021,7 @@ int8_t cmdRestart(const CMD_t *cmd) {
 	 */
 
 		if (cmd->subcmd_id == CMD_RESTART_NONE){
+			sfu_flush_logs();
 //			restart_software();
 			return 1;
 		}
@@ -64,6 +64,9 @@
 #define CMD_GET_MINHEAP		0x08
 #define CMD_GET_TYPES		0x0A
 #define CMD_GET_EPOCH		0x0C
+#define CMD_GET_GC			0x0E
+#define CMD_GET_WEAR		0x10
+#define CMD_GET_FS			0x12
 
 #define CMD_EXEC_NONE		0x00
 #define CMD_EXEC_RADIO		0x02
@@ -108,6 +111,8 @@
 #define CMD_FILE_CPREFIX 	0x06
 #define CMD_FILE_SIZE		0x08
 #define CMD_FILE_ERASE		0x0A
+#define CMD_FILE_RANGE		0x0C
+#define CMD_FILE_STATS		0x0E
 
 #define CMD_RESTART_NONE	0x00
 #define CMD_RESTART_ERASE_FILES	0x02
@@ -164,6 +169,14 @@ typedef struct CMD_FILE_DATA {
 	uint8_t unused[CMD_DATA_MAX_SIZE - 2];
 } CMD_FILE_DATA_t;
 
+/* times are big endian RTC seconds, so "file range 41000000100000ffff" is log A from 0x10 to 0xffff */
+typedef struct CMD_FILE_RANGE_DATA {
+	uint8_t suffix;
+	uint8_t t0[4];
+	uint8_t t1[4];
+	uint8_t unused[CMD_DATA_MAX_SIZE - 9];
+} CMD_FILE_RANGE_DATA_t;
+
 /**
  * CMD_SCHED_MISC_DATA_t provides structured access to miscellaneous data when specifying a CMD_SCHED_DATA_t.
  * CMD_SCHED_MISC_DATA_t is only ever used in this situation.
@@ -198,6 +211,7 @@ typedef struct CMD_SCHED_DATA {
 		CMD_STATE_DATA_t scheduled_cmd_state_data;
 		CMD_SCHED_MISC_DATA_t cmd_sched_misc_data;
 		CMD_FILE_DATA_t cmd_file_misc_data;
+		CMD_FILE_RANGE_DATA_t cmd_file_range_misc_data;
 
 	};
 	uint8_t scheduled_cmd_id;
@@ -220,6 +234,7 @@ typedef struct CMD {
 		CMD_STATE_DATA_t cmd_state_data;
 		CMD_SCHED_DATA_t cmd_sched_data;
 		CMD_FILE_DATA_t cmd_file_data;
+		CMD_FILE_RANGE_DATA_t cmd_file_range_data;
 	};
 	uint8_t cmd_id;
 	uint8_t subcmd_id;
@@ -0,0 +1,99 @@
+/*
+ * obc_dlog.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "obc_dlog.h"
+#include "obc_uart.h"
+#include "obc_tasks.h"
+#include "printf.h"
+
+#define DLOG_LINE_SIZE 64	/* serial line the TX task builds: "~" + 8 hex + DLOG_MAX_ARGS * 9, or a formatted message */
+
+static serial_deferred_t serial_slots[DLOG_SERIAL_SLOTS];
+static uint8_t serial_slot_next = 0;
+
+/* Private functions */
+static char *put_hex(char *buf, uint32_t value);
+
+/* serialSendDeferred
+ * 	- copies the message into a slot and queues it for the serial TX task. Nothing is formatted here
+ * 	- use DLOG_SERIAL() rather than calling this directly
+ * 	- slots are reused round robin, so a burst of more than DLOG_SERIAL_SLOTS messages overwrites the oldest
+ */
+BaseType_t serialSendDeferred(uint32_t id, const char *fmt, const int32_t *args, uint8_t num_args) {
+	serial_deferred_t *msg;
+	uint8_t i;
+
+	if (num_args > DLOG_MAX_ARGS) {
+		num_args = DLOG_MAX_ARGS;
+	}
+
+	taskENTER_CRITICAL();
+	msg = &serial_slots[serial_slot_next];
+	serial_slot_next = (serial_slot_next + 1) % DLOG_SERIAL_SLOTS;
+	taskEXIT_CRITICAL();
+
+	msg->tag = SERIAL_DEFERRED_TAG;
+	msg->id = id;
+	msg->fmt = fmt;
+	msg->num_args = num_args;
+	for (i = 0; i < num_args; i++) {
+		msg->args[i] = args[i];
+	}
+	return serialSendQ((const char *)msg);
+}
+
+/* dlog_send_serial
+ * 	- called by the serial TX task for queued items starting with SERIAL_DEFERRED_TAG
+ * 	- sends the formatted message if we have the format string, otherwise the ~id,args token line
+ */
+void dlog_send_serial(const serial_deferred_t *msg) {
+	char buf[DLOG_LINE_SIZE] = { '\0' };
+	char *pos = buf;
+	uint8_t i;
+
+	if (msg->fmt != NULL) {
+		dlog_format(buf, DLOG_LINE_SIZE, msg->fmt, msg->args, msg->num_args);
+	} else {
+		*pos++ = '~';
+		pos = put_hex(pos, msg->id);
+		for (i = 0; i < msg->num_args; i++) {
+			*pos++ = ',';
+			pos = put_hex(pos, (uint32_t)msg->args[i]);
+		}
+		*pos = '\0';
+	}
+	serialSendln(buf);
+}
+
+/* dlog_format
+ * 	- printf for a format string whose arguments are in an array
+ * 	- unused argument slots are passed as 0, printf ignores the extras
+ */
+uint8_t dlog_format(char *buf, uint8_t size, const char *fmt, const int32_t *args, uint8_t num_args) {
+	int32_t a[DLOG_MAX_ARGS] = { 0 };
+	uint8_t i;
+
+	for (i = 0; i < num_args && i < DLOG_MAX_ARGS; i++) {
+		a[i] = args[i];
+	}
+	return snprintf(buf, size, fmt, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+/* put_hex
+ * 	- writes value as hex without leading zeros, returns the position after the last digit
+ */
+static char *put_hex(char *buf, uint32_t value) {
+	int8_t shift = 28;
+
+	while (shift > 0 && ((value >> shift) & 0xF) == 0) {
+		shift -= 4;
+	}
+	for (; shift >= 0; shift -= 4) {
+		*buf++ = "0123456789abcdef"[(value >> shift) & 0xF];
+	}
+	return buf;
+}
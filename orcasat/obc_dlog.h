@@ -0,0 +1,74 @@
+/*
+ * obc_dlog.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Deferred (dictionary) formatting for log entries and serial messages.
+ *
+ *      Instead of running printf on the OBC, a call site stores HASH(fmt) and the raw argument words. The format strings
+ *      are pulled out of the source by tools/fmt_dict.py, which the ground uses to render the messages:
+ *      	- DLOG_FILE(f_suffix, fmt, ...) writes a LOG_REC_DEFERRED record (obc_fs_record.h), decoded by tools/log_decode.py
+ *      	- DLOG_SERIAL(fmt, ...) queues the message for the serial TX task, which sends a token line:
+ *      		~<id hex>,<arg hex>,<arg hex>...
+ *      	  tools/fmt_dict.py render turns a console capture with these lines back into text
+ *
+ *      Rules for the format strings:
+ *      	- use a string literal directly in the macro, that's what the extraction step looks for
+ *      	- integer conversions only (%d %i %u %x), at most DLOG_MAX_ARGS of them. No %s, the string wouldn't be around on the ground
+ *      	- fmt_dict.py fails if two different strings hash to the same ID. Reword one of them if that happens
+ *
+ *      Set DEFERRED_FORMATTING to 0 to format everything on the OBC again (same call sites, text records and plain serial lines).
+ *      Serial messages are formatted by the TX task in both modes, never by the caller.
+ */
+
+#ifndef SFUSAT_OBC_DLOG_H_
+#define SFUSAT_OBC_DLOG_H_
+
+#include "sys_common.h"
+#include "FreeRTOS.h"
+#include "obc_utils.h"
+
+#define DEFERRED_FORMATTING		1		/* 1: ground renders the messages, 0: the OBC does */
+
+#define DLOG_MAX_ARGS			6		/* most argument words a message can have. Matches LOG_RECORD_MAX_FIELDS */
+#define DLOG_SERIAL_SLOTS		16		/* serial messages that can wait for the TX task at once. Oldest gets overwritten */
+#define SERIAL_DEFERRED_TAG		'\x1e'	/* first byte of a queued deferred message, so the TX task can tell it from a string */
+
+#if DEFERRED_FORMATTING
+#define DLOG_FMT(fmt) NULL				/* the string itself doesn't need to be in the image */
+#else
+#define DLOG_FMT(fmt) (fmt)
+#endif
+
+/* DLOG_FILE
+ * 	- ex: DLOG_FILE(FSYS_ERROR, "Failed PBIST #%d", i);
+ * 	- the leading 0 keeps the initializer valid when there are no arguments
+ */
+#define DLOG_FILE(f_suffix, fmt, ...) do { \
+		const int32_t _dlog_args[] = { 0, __VA_ARGS__ }; \
+		sfu_write_deferred((f_suffix), HASH(fmt), DLOG_FMT(fmt), &_dlog_args[1], LEN(_dlog_args) - 1); \
+	} while (0)
+
+/* DLOG_SERIAL
+ * 	- ex: DLOG_SERIAL("FNww: %d", res);
+ */
+#define DLOG_SERIAL(fmt, ...) do { \
+		const int32_t _dlog_args[] = { 0, __VA_ARGS__ }; \
+		serialSendDeferred(HASH(fmt), DLOG_FMT(fmt), &_dlog_args[1], LEN(_dlog_args) - 1); \
+	} while (0)
+
+typedef struct serial_deferred {
+	char tag;							/* SERIAL_DEFERRED_TAG */
+	uint8_t num_args;
+	uint32_t id;						/* HASH(fmt) */
+	const char *fmt;					/* NULL when the ground formats it */
+	int32_t args[DLOG_MAX_ARGS];
+} serial_deferred_t;
+
+void sfu_write_deferred(char f_suffix, uint32_t id, const char *fmt, const int32_t *args, uint8_t num_args); /* in obc_fs_structure.c */
+BaseType_t serialSendDeferred(uint32_t id, const char *fmt, const int32_t *args, uint8_t num_args);
+void dlog_send_serial(const serial_deferred_t *msg);	/* TX task side: formats or tokenizes msg and sends it */
+uint8_t dlog_format(char *buf, uint8_t size, const char *fmt, const int32_t *args, uint8_t num_args);
+
+#endif /* SFUSAT_OBC_DLOG_H_ */
@@ -81,13 +81,16 @@
  * Flash
  */
 #define FLASH_MIBSPI_REG 		mibspiREG1
+#define FLASH_MIBSPI_RAM 		mibspiRAM1
 #define FLASH_DATA_FORMAT 		0
 #define FLASH_6_BYTE_GROUP 		0
 #define FLASH_1_BYTE_GROUP 		1 // transfer group with 1 byte length
 #define FLASH_2_BYTE_GROUP 		2 // transfer group with 2 byte length
 #define FLASH_4_BYTE_GROUP 		4 // transfer group with 4 byte length
 #define FLASH_20_BYTE_GROUP		3 // TG 20 byte length
+#define FLASH_STREAM_GROUP 		5 // TG FLASH_STREAM_LEN byte length, set up by flash_mibspi_init
 #define FLASH_CHIP_TYPE 		1 // 0 = SST26, 1 = IS25LP016D
+#define FLASH_USE_DMA 			1 // 1 = TG5 data copied by DMA (needs the HALCoGen DMA driver), 0 = by the CPU
 
 /**
  * Deployment
@@ -170,13 +173,16 @@
  * Flash
  */
 #define FLASH_MIBSPI_REG 		mibspiREG1
+#define FLASH_MIBSPI_RAM 		mibspiRAM1
 #define FLASH_DATA_FORMAT 		0
 #define FLASH_6_BYTE_GROUP 		0
 #define FLASH_1_BYTE_GROUP 		1 // transfer group with 1 byte length
 #define FLASH_2_BYTE_GROUP 		2 // transfer group with 2 byte length
 #define FLASH_4_BYTE_GROUP 		4 // transfer group with 4 byte length
 #define FLASH_20_BYTE_GROUP 	3 // TG 20 byte length
+#define FLASH_STREAM_GROUP 		5 // TG FLASH_STREAM_LEN byte length, set up by flash_mibspi_init
 #define FLASH_CHIP_TYPE 		1 // 0 = SST26, 1 = IS25LP016D
+#define FLASH_USE_DMA 			1 // 1 = TG5 data copied by DMA (needs the HALCoGen DMA driver), 0 = by the CPU
 #endif /* PLATFORM_OBC_V0_3 */
 
 
@@ -231,12 +237,15 @@
  * Flash
  */
 #define FLASH_MIBSPI_REG 		mibspiREG1
+#define FLASH_MIBSPI_RAM 		mibspiRAM1
 #define FLASH_6_BYTE_GROUP 		0
 #define FLASH_1_BYTE_GROUP 		1 // transfer group with 1 byte length
 #define FLASH_2_BYTE_GROUP 		2 // transfer group with 2 byte length
 #define FLASH_4_BYTE_GROUP 		4 // transfer group with 4 byte length
 #define FLASH_20_BYTE_GROUP 	3 // TG 20 byte length
+#define FLASH_STREAM_GROUP 		5 // TG FLASH_STREAM_LEN byte length, set up by flash_mibspi_init
 #define FLASH_CHIP_TYPE 		0 // 0 = SST26, 1 = IS25LP016D
+#define FLASH_USE_DMA 			0 // no DMA driver in this HALCoGen project (TMS570LS0432)
 #endif /* PLATFORM_LAUNCHPAD */
 
 #endif /* SFUSAT_HWDEFS_H_ */
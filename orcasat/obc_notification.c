@@ -40,6 +40,9 @@ void mibspiGroupNotification(mibspiBASE_t *mibspi, uint32 group) {
     case 4:
         TG4_IS_Complete = 0xA5;
         break;
+    case 5:
+        flash_stream_complete_fromISR();
+        break;
     default:
         while(1);
     }
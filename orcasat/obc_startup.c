@@ -14,6 +14,7 @@
 #include "reg_system.h"
 
 #include "obc_fs_structure.h"
+#include "obc_dlog.h"
 #include "obc_startup.h"
 #include "obc_uart.h"
 #include "obc_utils.h"
@@ -47,7 +48,7 @@ void logPBISTFails(void){
 		bool bitFailed = (pbistFailed >> i) & 1U;
 		if (bitComplete && bitFailed)
 		{
-			sfu_write_fname(FSYS_ERROR, "Failed PBIST #%i", i);
+			DLOG_FILE(FSYS_ERROR, "Failed PBIST #%d", i);
 			isFailureDetected = true;
 		}
 	}
@@ -74,6 +75,7 @@ void logPBISTFails(void){
 			// RA: FLAGS
 //			sfu_write_fname_offset(FSYS_FLAGS, RESET_FLAG_START, RESET_FLAG_MSG);
 			sfu_write_fname(FSYS_SYS, "PBIST FAILED");
+			sfu_flush_logs();
 			restart_software();
 		}
 	} else{
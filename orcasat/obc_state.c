@@ -12,6 +12,10 @@
 
 State_t cur_state;
 InstanceData_t state_persistent_data;
+
+static const char *stateNameString[] = {
+    FOREACH_STATE(GENERATE_STRING)
+};
 /* -------------- doStateX Functions ------------------------
 These handle the checks required to transition from one state to the next.
 Return to current state is always last so that checks are performed frequently. */
@@ -27,10 +27,6 @@ typedef enum {
     FOREACH_STATE(GENERATE_ENUM)
 } State_t;
 
-static const char *stateNameString[] = {
-    FOREACH_STATE(GENERATE_STRING)
-};
-
 typedef struct Instance_Data {
 	State_t previous_state; // keep this so we can correctly go to the last state
 	uint32_t enter_time; // time we enter current state. Use with current time to determine how long we've been in a state
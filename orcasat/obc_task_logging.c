@@ -6,6 +6,7 @@
  */
 
 #include "obc_fs_structure.h"
+#include "obc_fs_record.h"
 #include "obc_rtc.h"
 #include "obc_task_logging.h"
 #include "obc_uart.h"
@@ -40,10 +41,9 @@ void vLogToFileTask(void *pvParameters) {
 		 * When an item is present in queue, log to file. Otherwise, block
 		 */
 		if (xQueueReceive(xLoggingQueue, &received, portMAX_DELAY) == pdPASS) {
-			sfu_write_fname(FSYS_SYS, "%d, %d, %d",
-					received.rtcEpochTime,
-					received.logType,
-					received.encodedMessage);
+			/* stamped with the time the item was queued, not when we got around to writing it */
+			const int32_t fields[] = { received.logType, received.encodedMessage };
+			sfu_write_fields(FSYS_SYS, received.rtcEpochTime, LOG_REC_EVENT, fields, 2);
 		}
 	}
 
@@ -8,6 +8,8 @@
 #include "examples/obcsat_examples.h"
 #include "obc_adc.h"
 #include "obc_fs_structure.h"
+#include "obc_fs_gc.h"
+#include "obc_fs_service.h"
 #include "obc_gps.h"
 #include "obc_i2c.h"
 #include "obc_rtc.h"
@@ -38,6 +40,7 @@ TaskHandle_t xTickleTaskHandle = NULL;
 TaskHandle_t xBlinkyTaskHandle = NULL;
 TaskHandle_t xStateTaskHandle = NULL;
 TaskHandle_t xFilesystemTaskHandle = NULL;
+TaskHandle_t xFilesystemGCTaskHandle = NULL;
 
 /**
  * Currently unused tasks.
@@ -84,6 +87,7 @@ void vMainTask(void *pvParameters) {
 	xSerialTXQueue = xQueueCreate(30, sizeof(portCHAR *));
 	xSerialRXQueue = xQueueCreate(10, sizeof(portCHAR));
 	xLoggingQueue = xQueueCreate(LOGGING_QUEUE_LENGTH, sizeof(LoggingQueueStructure_t));
+	fs_service_init();
 
 	/**
 	 * Test initialization phase.
@@ -113,6 +117,7 @@ void vMainTask(void *pvParameters) {
 	xTaskCreate(vSerialTask				, "serial"	, 400, NULL, SERIAL_TASK_DEFAULT_PRIORITY	, &xSerialTaskHandle);
 	xTaskCreate(vStateTask				, "state"	, 400, NULL, STATE_TASK_DEFAULT_PRIORITY	, &xStateTaskHandle);
 	xTaskCreate(vFilesystemLifecycleTask, "fs"		, 500, NULL, FLASH_TASK_DEFAULT_PRIORITY	, &xFilesystemTaskHandle);
+	xTaskCreate(vFilesystemGCTask		, "fs_gc"	, 300, NULL, FLASH_GC_DEFAULT_PRIORITY		, &xFilesystemGCTaskHandle);
 	xTaskCreate(vRadioTask				, "radio"	, 600, NULL, portPRIVILEGE_BIT |
 																	RADIO_TASK_DEFAULT_PRIORITY	, &xRadioTaskHandle);
 	xTaskCreate(deploy_task				, "deploy"	, 128, NULL, 4								, &deployTaskHandle);
@@ -233,6 +238,7 @@ void vMainTask(void *pvParameters) {
 	xSerialTXQueue = xQueueCreate(30, sizeof(portCHAR *));
 	xSerialRXQueue = xQueueCreate(10, sizeof(portCHAR));
 	xLoggingQueue = xQueueCreate(LOGGING_QUEUE_LENGTH, sizeof(LoggingQueueStructure_t));
+	fs_service_init();
 
 	serialSendQ("created queue");
 
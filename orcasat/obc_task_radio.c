@@ -249,6 +249,7 @@ static uint8 statusByte;
  * Forward declarations
  */
 static uint8 readRegister(uint8 addr);
+static int writeToTxFIFO(const uint8 *src, uint8 numBytesToWrite);
 static int readFromRxFIFO(uint8 *dest, uint8 numBytesToRead);
 static void strobe(uint8 addr);
 static uint8 * readAllStatusRegisters();
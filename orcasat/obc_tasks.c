@@ -5,6 +5,7 @@
 #include "obc_state.h"
 #include "obc_tasks.h"
 #include "obc_utils.h"
+#include "obc_dlog.h"
 #include "adc.h"
 #include "sys_pmu.h"
 
@@ -73,7 +74,11 @@ void vSerialTask(void *pvParameters) {
 			serialSendln(" msgs in tx queue");
 		}
 		while (xQueueReceive(xSerialTXQueue, &txCurrQueuedStr, xTicksToWait) == pdPASS) {
-			serialSendln(txCurrQueuedStr);
+			if (txCurrQueuedStr[0] == SERIAL_DEFERRED_TAG) {
+				dlog_send_serial((const serial_deferred_t *)txCurrQueuedStr);
+			} else {
+				serialSendln(txCurrQueuedStr);
+			}
 		}
 
 		/*
@@ -72,6 +72,47 @@ void watchdog_busywait(int32_t numtickles){
 	}
 }
 
+/* base64_encode
+ * 	- standard base64 with '=' padding, NUL terminated
+ * 	- used to send binary data over the serial link, where the send functions stop at the first \0
+ */
+uint32_t base64_encode(const uint8_t *data, uint32_t size, char *out) {
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	uint32_t len = 0;
+	uint32_t i;
+	uint32_t triple;
+
+	for (i = 0; i < size; i += 3) {
+		triple = (uint32_t)data[i] << 16;
+		if (i + 1 < size) triple |= (uint32_t)data[i + 1] << 8;
+		if (i + 2 < size) triple |= data[i + 2];
+
+		out[len++] = alphabet[(triple >> 18) & 0x3F];
+		out[len++] = alphabet[(triple >> 12) & 0x3F];
+		out[len++] = (i + 1 < size) ? alphabet[(triple >> 6) & 0x3F] : '=';
+		out[len++] = (i + 2 < size) ? alphabet[triple & 0x3F] : '=';
+	}
+	out[len] = '\0';
+	return len;
+}
+
+/* crc16_ccitt
+ * 	- CRC-16/CCITT (poly 0x1021), bit at a time. Pass 0xFFFF as crc to start, or a previous result to continue
+ * 	- slow, meant for small records
+ */
+uint16_t crc16_ccitt(const uint8_t *data, uint32_t size, uint16_t crc) {
+	uint32_t i;
+	uint8_t bit;
+
+	for (i = 0; i < size; i++) {
+		crc ^= (uint16_t)data[i] << 8;
+		for (bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
 void clearBuf(char *buf,uint32_t length){
 	// use memset to fill empty chars into the buffer
 	memset(buf, '\0', length);
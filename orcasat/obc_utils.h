@@ -48,6 +48,8 @@ void watchdog_busywait(int32_t numtickles);
 char* itoa2(int num, char *buffer, int base, int itr); // http://code.geeksforgeeks.org/lDrTiv
 
 char* utoa2(uint32_t num, char *buffer, int base, int itr);
+uint32_t base64_encode(const uint8_t *data, uint32_t size, char *out); // out needs 4 * ((size + 2) / 3) + 1 bytes. Returns the string length
+uint16_t crc16_ccitt(const uint8_t *data, uint32_t size, uint16_t crc); // start with crc = 0xFFFF
 void clearBuf(char *buf,uint32_t length);
 uint32_t adc_to_mA(uint32_t adcval); // based on some rough calibration, convert an ADC reading of the INA301 current output to an actual current draw
 
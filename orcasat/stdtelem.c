@@ -19,6 +19,7 @@
 #include "stlm75.h"
 #include "stdtelem.h"
 #include "obc_fs_structure.h"
+#include "obc_fs_record.h"
 #include "reg_tcram.h"
 #include "obc_task_utils.h"
 #include "bq25703.h"
@@ -42,6 +43,7 @@ TaskHandle_t xTransmitTelemTaskHandle = NULL;
  */
 
 void generalTelemTask(void *pvParameters){
+	spiffs_usage_t fs_usage;
 	telemConfig[GENERAL_TELEM] = (telemConfig_t){	.max = 0, .min = 0, .period = 12000};
 	SET_UART_RF_MUX(UART_RF_MUX_TARGET_UART);
 	// none, uart, rf
@@ -52,11 +54,19 @@ void generalTelemTask(void *pvParameters){
 		stdTelem.min_heap = xPortGetMinimumEverFreeHeapSize();
 		stdTelem.fs_free_blocks = fs.free_blocks;
 		stdTelem.fs_prefix = getCurrentPrefix();
+		if (my_spiffs_usage(&fs, &fs_usage, 0) == SPIFFS_OK) { // keep the last ones if the filesystem is busy
+			stdTelem.fs_used_kb = fs_usage.used / 1024;
+			stdTelem.fs_total_kb = fs_usage.total / 1024;
+			stdTelem.fs_pages_free = fs_usage.pages_free;
+			stdTelem.fs_pages_deleted = fs_usage.pages_deleted;
+			stdTelem.fs_cache_hits = fs_usage.cache_hits;
+			stdTelem.fs_cache_misses = fs_usage.cache_misses;
+			stdTelem.fs_gc_runs = fs_usage.gc_runs;
+		}
 		stdTelem.ramoccur_1 = tcram1REG->RAMOCCUR;
 		stdTelem.ramoccur_2 = tcram2REG->RAMOCCUR;
 
-		sfu_write_fname(FSYS_SYS, "R1: %i", stdTelem.ramoccur_1);
-		sfu_write_fname(FSYS_SYS, "R2: %i", stdTelem.ramoccur_2);
+		SFU_WRITE_RECORD(FSYS_SYS, LOG_REC_RAMOCCUR, stdTelem.ramoccur_1, stdTelem.ramoccur_2);
 	}
 }
 
@@ -69,7 +79,7 @@ void BMSTelemTask(void *pvParameters){
 		stdTelem.bms_volt = 234;//read_volt();
 		stdTelem.bms_curr = 45;//read_curr();
 
-		sfu_write_fname(FSYS_BMS, "%d V, %d uA", stdTelem.bms_volt, stdTelem.bms_curr);
+		SFU_WRITE_RECORD(FSYS_BMS, LOG_REC_BMS, stdTelem.bms_volt, stdTelem.bms_curr);
 	}
 }
 
@@ -90,7 +100,7 @@ void obcCurrentTelemTask(void *pvParameters){
 //			// enter safe mode
 //		}
 
-		sfu_write_fname(OBC_CURRENT, "%d", reading);
+		SFU_WRITE_RECORD(OBC_CURRENT, LOG_REC_CURRENT, reading);
 		stdTelem.obc_current = reading;
 	}
 }
@@ -104,16 +114,15 @@ void temperatureTelemTask(void *pvParameters){
 	while(1){
 		vTaskDelay(getStdTelemDelay(TEMP_TELEM));
 		res = read_temp(OBC_TEMP);
-		sfu_write_fname(TEMPS, "OBC: %d", res);
 		stdTelem.obc_temp = res;
 
 		res = read_temp(LB_TEMP);
-		sfu_write_fname(TEMPS, "LB: %d", res);
 		stdTelem.lb_temp = res;
 
 		res = read_temp(UB_TEMP);
-		sfu_write_fname(TEMPS, "UB: %d", res);
 		stdTelem.ub_temp = res;
+
+		SFU_WRITE_RECORD(TEMPS, LOG_REC_TEMPS, stdTelem.obc_temp, stdTelem.lb_temp, stdTelem.ub_temp); /* one record for all three sensors */
 	}
 }
 
@@ -172,5 +181,22 @@ void transmitTelemUART(void *pvParameters){
 		);
 		UART_RF_MUX_SENDQ(buf);
 	    vTaskDelay(pdMS_TO_TICKS(20)); // delay slightly to allow transmission to complete
+
+		snprintf(buf, 49, "S4,%i,%i,%i,%i",
+				stdTelem.fs_used_kb,
+				stdTelem.fs_total_kb,
+				stdTelem.fs_pages_free,
+				stdTelem.fs_pages_deleted
+		);
+		UART_RF_MUX_SENDQ(buf);
+	    vTaskDelay(pdMS_TO_TICKS(20)); // delay slightly to allow transmission to complete
+
+		snprintf(buf, 49, "S5,%u,%u,%u",
+				stdTelem.fs_cache_hits,
+				stdTelem.fs_cache_misses,
+				stdTelem.fs_gc_runs
+		);
+		UART_RF_MUX_SENDQ(buf);
+	    vTaskDelay(pdMS_TO_TICKS(20)); // delay slightly to allow transmission to complete
 	}
 }
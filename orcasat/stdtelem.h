@@ -60,6 +60,13 @@ typedef struct stdtelem{
 	uint32_t min_heap;
 	uint8_t fs_free_blocks;
 	char fs_prefix;
+	uint16_t fs_used_kb;		// logs partition, from my_spiffs_usage
+	uint16_t fs_total_kb;
+	uint16_t fs_pages_free;
+	uint16_t fs_pages_deleted;
+	uint32_t fs_cache_hits;		// since mount
+	uint32_t fs_cache_misses;
+	uint32_t fs_gc_runs;
 	int16_t obc_current;
 	int16_t obc_temp;
 	int16_t lb_temp;
@@ -0,0 +1,78 @@
+/*
+ * test_fs_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+#include "obc_rtc.h"
+#include "obc_uart.h"
+#include "obc_utils.h"
+#include "obc_fs_service.h"
+#include "test_fs_bench.h"
+
+static void print_bench_result(const char *name, uint32_t num_records);
+static void legacy_write_fname(char f_suffix, char *data);
+
+/* fs_bench_appender
+ * 	- logs num_records entries to the system log with the old open/write/close sequence, then with sfu_write_fname
+ * 	- prints how many HAL reads and writes each record cost for both
+ * 	- the appender stages entries into full data pages, so expect well under one write per record there
+ */
+void fs_bench_appender(uint32_t num_records) {
+	uint32_t i;
+
+	spiffs_hal_stats_reset();
+	for (i = 0; i < num_records; i++) {
+		legacy_write_fname(FSYS_SYS, "bench 1234");
+	}
+	print_bench_result("open/close", num_records);
+
+	spiffs_hal_stats_reset();
+	for (i = 0; i < num_records; i++) {
+		sfu_write_fname(FSYS_SYS, "bench %d", 1234);
+		if ((i % (FS_SERVICE_QUEUE_LENGTH / 2)) == (FS_SERVICE_QUEUE_LENGTH / 2) - 1) {
+			sfu_fs_sync(); /* we log faster than any task would, don't let the queue drop entries */
+		}
+	}
+	sfu_flush_logs(); /* count the partial page left in the stage too */
+	print_bench_result("appender", num_records);
+}
+
+static void print_bench_result(const char *name, uint32_t num_records) {
+	char buf[60] = { '\0' };
+	snprintf(buf, 60, "%s: %u rec, R %u/rec, W %u/rec, E %u",
+			name,
+			num_records,
+			spiffs_hal_stats.reads / num_records,
+			spiffs_hal_stats.writes / num_records,
+			spiffs_hal_stats.erases);
+	serialSendln(buf);
+}
+
+/* legacy_write_fname
+ * 	- what every sfu_write_fname call used to do: remount, open by name, write, close
+ * 	- the entry is the same size as the one sfu_write_fname would produce
+ */
+static void legacy_write_fname(char f_suffix, char *data) {
+	char nameBuf[3] = { '\0' };
+	char buf[SFU_WRITE_DATA_BUF] = { '\0' };
+	spiffs_file fd;
+
+	utoa2(getCurrentRTCTime(), buf, 10, 0);
+	buf[strlen(buf)] = '|';
+	strncat(buf, data, SFU_WRITE_DATA_BUF - 1 - strlen(buf));
+
+	if (xSemaphoreTake(spiffsTopMutex, pdMS_TO_TICKS(SPIFFS_READ_TIMEOUT_MS)) == pdTRUE) {
+		nameBuf[0] = getCurrentPrefix();
+		nameBuf[1] = f_suffix;
+		my_spiffs_mount();
+		fd = SPIFFS_open(&fs, nameBuf, SPIFFS_APPEND | SPIFFS_RDWR, 0);
+		if (fd >= 0) {
+			SPIFFS_write(&fs, fd, buf, strlen(buf) + 1);
+			SPIFFS_close(&fs, fd);
+		}
+		xSemaphoreGive(spiffsTopMutex);
+	} else {
+		serialSendQ("FBwe: can't get top mutex");
+	}
+}
@@ -0,0 +1,25 @@
+/*
+ * test_fs_bench.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ *
+ *      Filesystem benchmarks. These count the calls into the flash HAL (spiffs_hal_stats) for a fixed workload so
+ *      we can compare the cost of fs layer changes with numbers instead of guesses.
+ *
+ *      USAGE - after the filesystem lifecycle task has created the file set:
+ *      	fs_bench_appender(100);
+ *
+ *      Results are printed on the UART as HAL reads/writes per logged record. They also land in the current system
+ *      log, so don't run these on a flight image.
+ */
+
+#ifndef SFUSAT_TEST_SEQUENCES_TEST_FS_BENCH_H_
+#define SFUSAT_TEST_SEQUENCES_TEST_FS_BENCH_H_
+#include "obc_fs_structure.h"
+#include "obc_spiffs.h"
+#include "spiffs.h"
+
+void fs_bench_appender(uint32_t num_records); // open/write/close per record vs. the log appender
+
+#endif /* SFUSAT_TEST_SEQUENCES_TEST_FS_BENCH_H_ */
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+fmt_dict.py
+
+Format string dictionary for deferred formatting (orcasat/obc_dlog.h).
+
+DLOG_FILE() and DLOG_SERIAL() call sites only send HASH(fmt) and the argument words. This script finds every
+call site in the firmware source, computes the same hash as HASH() in obc_utils.h and builds the ID -> format
+string table the ground needs to render the messages.
+
+Usage:
+    fmt_dict.py extract [-o fmt_dict.json]     scan the source, fail on hash collisions or bad formats
+    fmt_dict.py render [capture.txt]           replace ~id,args lines in a serial capture with the messages
+
+Run extract as part of the build and keep the json with the image it was built from. log_decode.py uses
+the dictionary for LOG_REC_DEFERRED records.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+REPO_ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+SOURCE_DIRS = ['orcasat']
+MAX_ARGS = 6  # DLOG_MAX_ARGS
+
+CALL_RE = re.compile(r'\bDLOG_(?:FILE\s*\([^,"]*,|SERIAL\s*\()\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+STRING_RE = re.compile(r'"((?:[^"\\]|\\.)*)"')
+CONVERSION_RE = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l)?([diuxXcs%])')
+TOKEN_RE = re.compile(r'^~([0-9a-f]{1,8})((?:,[0-9a-f]{1,8})*)\s*$')
+
+
+class DictError(Exception):
+    pass
+
+
+def c_unescape(s):
+    return s.encode('latin-1').decode('unicode_escape')
+
+
+def dlog_hash(s):
+    """HASH() from obc_utils.h: 65599 hash over the last 256 chars, last char first, then folded."""
+    data = s.encode('latin-1')
+    n = len(data)
+    x = 0
+    for i in range(255, -1, -1):
+        c = data[n - 1 - i] if i < n else 0
+        x = (x * 65599 + c) & 0xFFFFFFFF
+    return (x ^ (x >> 16)) & 0xFFFFFFFF
+
+
+def check_format(fmt):
+    convs = [c for c in CONVERSION_RE.findall(fmt) if c != '%']
+    if 's' in convs:
+        raise DictError('%%s can\'t be deferred: "%s"' % fmt)
+    if len(convs) > MAX_ARGS:
+        raise DictError('more than %d arguments: "%s"' % (MAX_ARGS, fmt))
+
+
+def extract(root=REPO_ROOT):
+    """Returns {id: fmt} for every DLOG_ call site under root."""
+    table = {}
+    where = {}
+    for src_dir in SOURCE_DIRS:
+        for dirpath, _, files in os.walk(os.path.join(root, src_dir)):
+            for name in sorted(files):
+                if not name.endswith(('.c', '.h')):
+                    continue
+                path = os.path.join(dirpath, name)
+                with open(path, encoding='latin-1') as f:
+                    text = f.read()
+                for m in CALL_RE.finditer(text):
+                    fmt = c_unescape(''.join(STRING_RE.findall(m.group(1))))
+                    line = text.count('\n', 0, m.start()) + 1
+                    loc = '%s:%d' % (os.path.relpath(path, root), line)
+                    check_format(fmt)
+                    fmt_id = dlog_hash(fmt)
+                    if fmt_id in table and table[fmt_id] != fmt:
+                        raise DictError('hash collision 0x%08x: "%s" (%s) and "%s" (%s)'
+                                        % (fmt_id, fmt, loc, table[fmt_id], where[fmt_id]))
+                    table[fmt_id] = fmt
+                    where[fmt_id] = loc
+    return table
+
+
+def load(path):
+    with open(path) as f:
+        return {int(k, 16): v for k, v in json.load(f).items()}
+
+
+def render(table, fmt_id, args):
+    """Formats a deferred message. args are the raw 32-bit words."""
+    if fmt_id not in table:
+        return '<unknown format 0x%08x: %s>' % (fmt_id, ', '.join(str(a) for a in args))
+    fmt = table[fmt_id]
+    values = []
+    for conv in [c for c in CONVERSION_RE.findall(fmt) if c != '%']:
+        word = args[len(values)] & 0xFFFFFFFF if len(values) < len(args) else 0
+        if conv in 'di':
+            word = word - (1 << 32) if word & 0x80000000 else word
+        values.append(word)
+    return fmt % tuple(values)
+
+
+def render_line(table, line):
+    m = TOKEN_RE.match(line)
+    if not m:
+        return line
+    args = [int(a, 16) for a in m.group(2).split(',')[1:]]
+    return render(table, int(m.group(1), 16), args) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Deferred format string dictionary')
+    sub = parser.add_subparsers(dest='cmd')
+    p_extract = sub.add_parser('extract', help='build the dictionary from the source')
+    p_extract.add_argument('-o', '--output', help='json file to write, stdout if not given')
+    p_render = sub.add_parser('render', help='render ~id,args lines in a serial capture')
+    p_render.add_argument('capture', nargs='?', help='capture file, stdin if not given')
+    p_render.add_argument('--dict', help='json from extract. Built from the source if not given')
+    args = parser.parse_args()
+
+    try:
+        if args.cmd == 'extract':
+            table = extract()
+            out = json.dumps({'%08x' % k: v for k, v in sorted(table.items())}, indent=1)
+            if args.output:
+                with open(args.output, 'w') as f:
+                    f.write(out + '\n')
+            else:
+                print(out)
+        elif args.cmd == 'render':
+            table = load(args.dict) if args.dict else extract()
+            src = open(args.capture, encoding='latin-1') if args.capture else sys.stdin
+            for line in src:
+                sys.stdout.write(render_line(table, line))
+        else:
+            parser.print_help()
+            return 1
+    except DictError as e:
+        sys.stderr.write('fmt_dict: %s\n' % e)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+"""
+log_decode.py
+
+Turns binary OBC log files back into the old "<time>|<text>" lines.
+
+The record format is described in orcasat/filesystem/obc_fs_record.h. The record types and their formats
+are read straight out of LOG_RECORD_TABLE in that header, so adding a record type on the OBC side doesn't
+need a change here.
+
+LOG_REC_DEFERRED records are rendered with the format string dictionary from fmt_dict.py.
+
+Usage:
+    log_decode.py aA.bin [more files...]
+    log_decode.py --header path/to/obc_fs_record.h --dict fmt_dict.json aA.bin
+    log_decode.py --capture serial_log.txt [--save-dir dumps/]
+
+With --capture the inputs are serial console captures of "file dump" output (FILE: / DF,<offset>,<base64> /
+FILE_END: lines, see dumpFile() in obc_fs_structure.c). Every dumped file in them is rebuilt and decoded.
+
+Circular logs (orcasat/filesystem/obc_fs_circular.h) are recognised by their header and decoded a data page at a
+time, oldest page first. The header is only rewritten when the log wraps, so head is found from the data pages like
+the OBC does. A "log range" dump of a circular log sends the header first, so the ranges after it in the
+same capture are split into pages using the page size from that header (--page-size if there wasn't one).
+"""
+
+import argparse
+import base64
+import os
+import re
+import sys
+
+import fmt_dict
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              '..', 'orcasat', 'filesystem', 'obc_fs_record.h')
+
+LOG_REC_BASE = 'LOG_REC_BASE'
+LOG_REC_TEXT = 'LOG_REC_TEXT'
+LOG_REC_DEFERRED = 'LOG_REC_DEFERRED'
+
+CIRC_MAGIC = 0xC1C0
+CIRC_HEADER_SIZE = 24
+DEFAULT_PAGE_SIZE = 247  # SPIFFS_DATA_PAGE_SIZE: 256 byte logical pages, 9 byte page headers (u32 object ids and span indexes)
+
+ENTRY_RE = re.compile(r'ENTRY\(\s*(\w+)\s*,\s*(0x[0-9A-Fa-f]+|\d+)\s*,\s*(\d+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+
+
+class DecodeError(Exception):
+    pass
+
+
+def load_record_table(header_path):
+    """Returns {type byte: (name, num_fields, fmt)} from LOG_RECORD_TABLE."""
+    with open(header_path) as f:
+        text = f.read()
+    start = text.find('#define LOG_RECORD_TABLE(ENTRY)')
+    if start < 0:
+        raise DecodeError('LOG_RECORD_TABLE not found in %s' % header_path)
+
+    table = {}
+    for line in text[start:].splitlines()[1:]:
+        m = ENTRY_RE.search(line)
+        if m:
+            name, type_id, num_fields, fmt = m.groups()
+            table[int(type_id, 0)] = (name, int(num_fields), fmt.encode().decode('unicode_escape'))
+        if not line.rstrip().endswith('\\'):
+            break
+    return table
+
+
+def extract_dumps(text):
+    """Yields (name, start offset, data) for every file dump in a serial capture."""
+    name = None
+    chunks = []
+    for line in text.splitlines():
+        line = line.strip()
+        if line.startswith('FILE: '):
+            name = line.split()[1]
+            chunks = []
+        elif line.startswith('DF,') and name is not None:
+            _, offset, b64 = line.split(',', 2)
+            chunks.append((int(offset), base64.b64decode(b64)))
+        elif line.startswith('FILE_END: ') and name is not None:
+            if not chunks:
+                yield name, 0, b''
+            else:
+                start = chunks[0][0]
+                data = bytearray()
+                for offset, chunk in chunks:
+                    if offset != start + len(data):
+                        raise DecodeError('%s: dump line for offset %d, expected %d. Lost a line?'
+                                          % (name, offset, start + len(data)))
+                    data += chunk
+                yield name, start, bytes(data)
+            name = None
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def parse_circ_header(data):
+    """Returns (page size, pages, head, tail, wraps) if data starts with a circular log header, else None."""
+    if len(data) < CIRC_HEADER_SIZE or int.from_bytes(data[0:2], 'big') != CIRC_MAGIC:
+        return None
+    if int.from_bytes(data[20:22], 'big') != crc16_ccitt(data[:20]):
+        raise DecodeError('circular log header has a bad CRC')
+    return (int.from_bytes(data[2:4], 'big'), int.from_bytes(data[4:6], 'big'), int.from_bytes(data[8:12], 'big'),
+            int.from_bytes(data[12:16], 'big'), int.from_bytes(data[16:20], 'big'))
+
+
+def decode_pages(data, start, page_size, table, formats):
+    """Decodes part of a circular log that starts at file offset start, one data page at a time."""
+    pos = 0
+    while pos < len(data):
+        # data pages start at page_size, right after the header page
+        end = pos + page_size - (start + pos) % page_size
+        yield from decode(data[pos:end], table, formats)
+        pos = end
+
+
+def find_head(data, header, table):
+    """Returns the header with head and tail where the OBC finds them on open (recover_head_noMutex in
+    obc_fs_circular.c). The header on flash is only rewritten when the log wraps."""
+    page_size, pages, head, tail, wraps = header
+    if wraps == 0 or len(data) < page_size * (pages + 1):
+        return page_size, pages, max(len(data) - page_size, 0), tail, wraps
+
+    base_id = next(type_id for type_id, entry in table.items() if entry[0] == LOG_REC_BASE)
+
+    def page_time(page):
+        offset = page_size * (page + 1)
+        return get_varint(data, offset + 1)[0] if data[offset] == base_id else 0
+
+    # the pages written since the wrap start at or after the page before the header's head
+    ref = page_time((head // page_size + pages - 1) % pages)
+    lo, hi = head // page_size, pages
+    while lo < hi:
+        mid = (lo + hi) // 2
+        time = page_time(mid)
+        if time and time >= ref:
+            lo = mid + 1
+        else:
+            hi = mid
+    head = max(head, lo * page_size)
+    if head >= pages * page_size:
+        head, wraps = 0, wraps + 1
+    return page_size, pages, head, (head // page_size + 1) % pages * page_size, wraps
+
+
+def decode_circular(data, header, table, formats):
+    """Decodes a whole circular log file, from tail around to head."""
+    page_size, pages, head, tail, wraps = find_head(data, header, table)
+    head_page = head // page_size
+    count = head_page if wraps == 0 else pages - 1
+    if head % page_size:
+        count += 1
+    for k in range(count):
+        page = (tail // page_size + k) % pages
+        start = page_size + page * page_size
+        end = page_size + head if page == head_page else start + page_size
+        yield from decode(data[start:end], table, formats)
+
+
+def get_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data):
+            raise DecodeError('varint runs past the end of the file')
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b < 0x80:
+            return value, pos
+        shift += 7
+        if shift > 28:
+            raise DecodeError('varint longer than 5 bytes')
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode(data, table, formats):
+    """Yields (time, text) for every record in data."""
+    base = None
+    pos = 0
+    while pos < len(data):
+        rec_start = pos
+        type_id = data[pos]
+        pos += 1
+        if type_id == 0xFF:
+            break  # erased flash, nothing was written past here
+        if type_id not in table:
+            raise DecodeError('unknown record type 0x%02x at offset %d' % (type_id, rec_start))
+        name, num_fields, fmt = table[type_id]
+
+        dt, pos = get_varint(data, pos)
+        if name == LOG_REC_BASE:
+            base = dt
+            continue
+        if base is None:
+            raise DecodeError('%s at offset %d before any base record' % (name, rec_start))
+
+        if name == LOG_REC_TEXT:
+            end = data.find(b'\0', pos)
+            if end < 0:
+                raise DecodeError('unterminated text record at offset %d' % rec_start)
+            text = data[pos:end].decode('ascii', errors='replace')
+            pos = end + 1
+        elif name == LOG_REC_DEFERRED:
+            if pos + 5 > len(data):
+                raise DecodeError('deferred record at offset %d runs past the end of the file' % rec_start)
+            fmt_id = int.from_bytes(data[pos:pos + 4], 'big')
+            num_args = data[pos + 4]
+            pos += 5
+            args = []
+            for _ in range(num_args):
+                value, pos = get_varint(data, pos)
+                args.append(unzigzag(value))
+            text = fmt_dict.render(formats, fmt_id, args)
+        else:
+            fields = []
+            for _ in range(num_fields):
+                value, pos = get_varint(data, pos)
+                fields.append(unzigzag(value))
+            text = fmt % tuple(fields)
+        yield base + dt, text
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode binary OBC log files')
+    parser.add_argument('files', nargs='+', help='raw log files')
+    parser.add_argument('--header', default=DEFAULT_HEADER, help='obc_fs_record.h to take LOG_RECORD_TABLE from')
+    parser.add_argument('--dict', help='format dictionary from fmt_dict.py extract. Built from the source if not given')
+    parser.add_argument('--capture', action='store_true', help='inputs are serial captures of file dumps')
+    parser.add_argument('--save-dir', help='with --capture, also write the rebuilt raw files here')
+    parser.add_argument('--page-size', type=int, nargs='?', const=DEFAULT_PAGE_SIZE,
+                        help='with --capture, treat ranges dumped without a header as circular log pages of this size '
+                             '(%d if no size is given)' % DEFAULT_PAGE_SIZE)
+    args = parser.parse_args()
+
+    table = load_record_table(args.header)
+    formats = fmt_dict.load(args.dict) if args.dict else fmt_dict.extract()
+    ok = True
+    for path in args.files:
+        with open(path, 'rb') as f:
+            data = f.read()
+        try:
+            if args.capture:
+                page_sizes = {}  # circular logs whose header was dumped
+                for name, start, dump in extract_dumps(data.decode('latin-1')):
+                    print('# %s from offset %d, %d bytes' % (name, start, len(dump)))
+                    if args.save_dir:
+                        with open(os.path.join(args.save_dir, '%s_%d.bin' % (name, start)), 'wb') as f:
+                            f.write(dump)
+                    header = parse_circ_header(dump) if start == 0 else None
+                    if header is not None:
+                        page_sizes[name] = header[0]
+                        records = decode_circular(dump, header, table, formats)
+                    elif start > 0 and (name in page_sizes or args.page_size):
+                        records = decode_pages(dump, start, page_sizes.get(name, args.page_size), table, formats)
+                    else:
+                        records = decode(dump, table, formats)
+                    for time, text in records:
+                        print('%d|%s' % (time, text))
+            else:
+                header = parse_circ_header(data)
+                records = decode(data, table, formats) if header is None else decode_circular(data, header, table, formats)
+                for time, text in records:
+                    print('%d|%s' % (time, text))
+        except DecodeError as e:
+            sys.stderr.write('%s: %s\n' % (path, e))
+            ok = False
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())